@@ -0,0 +1,583 @@
+/*****************************************************************************
+ * main.cpp: Wrapper overhead & callback throughput benchmarks
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+// Each benchmark compares the libvlcpp path with the equivalent raw libvlc
+// code, so that the wrapper cost can be told apart from the libvlc one.
+// The results are written as JSON, on the standard output or to the file
+// given as second argument; the progress is reported on stderr.
+
+#include "vlcpp/vlc.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+const size_t NbRuns = 7;
+
+struct Result
+{
+    std::string name;
+    std::string unit;
+    uint64_t iterations;
+    double median;
+    double min;
+    double max;
+};
+
+std::vector<Result> results;
+
+void report( std::string name, std::string unit, uint64_t iterations, std::vector<double> runs )
+{
+    if ( runs.empty() == true )
+    {
+        std::cerr << name << ": skipped" << std::endl;
+        return;
+    }
+    std::sort( begin( runs ), end( runs ) );
+    Result r;
+    r.name = std::move( name );
+    r.unit = std::move( unit );
+    r.iterations = iterations;
+    r.median = runs[runs.size() / 2];
+    r.min = runs.front();
+    r.max = runs.back();
+    std::cerr << r.name << ": " << r.median << ' ' << r.unit << std::endl;
+    results.push_back( std::move( r ) );
+}
+
+double nanoseconds( Clock::duration d )
+{
+    return static_cast<double>( std::chrono::duration_cast<std::chrono::nanoseconds>( d ).count() );
+}
+
+// Runs f( iterations ) NbRuns times, after a shorter warmup run, and reports
+// the time per iteration. reset() is invoked between the runs, untimed.
+template <typename Func, typename Reset>
+void measure( const char* name, size_t iterations, Func f, Reset reset )
+{
+    std::vector<double> runs;
+    f( iterations / 10 + 1 );
+    reset();
+    for ( size_t i = 0; i < NbRuns; ++i )
+    {
+        auto start = Clock::now();
+        f( iterations );
+        auto elapsed = Clock::now() - start;
+        reset();
+        runs.push_back( nanoseconds( elapsed ) / iterations );
+    }
+    report( name, "ns/op", iterations, std::move( runs ) );
+}
+
+template <typename Func>
+void measure( const char* name, size_t iterations, Func f )
+{
+    measure( name, iterations, f, []() {} );
+}
+
+void writeJson( std::ostream& out )
+{
+    out << "{\n  \"libvlc\": \"" << libvlc_get_version() << "\",\n"
+        << "  \"results\": [\n";
+    char buff[64];
+    for ( size_t i = 0; i < results.size(); ++i )
+    {
+        const auto& r = results[i];
+        out << "    { \"name\": \"" << r.name << "\", \"unit\": \"" << r.unit
+            << "\", \"iterations\": " << r.iterations;
+        snprintf( buff, sizeof( buff ), "%.3f", r.median );
+        out << ", \"median\": " << buff;
+        snprintf( buff, sizeof( buff ), "%.3f", r.min );
+        out << ", \"min\": " << buff;
+        snprintf( buff, sizeof( buff ), "%.3f", r.max );
+        out << ", \"max\": " << buff << " }" << ( i + 1 < results.size() ? ",\n" : "\n" );
+    }
+    out << "  ]\n}\n";
+}
+
+// A one shot, timed wait for an event raised from a libvlc thread
+class Signal
+{
+public:
+    Signal()
+        : m_raised( false )
+    {
+    }
+
+    void raise()
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_raised = true;
+        m_cond.notify_all();
+    }
+
+    bool wait( std::chrono::milliseconds timeout )
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        return m_cond.wait_for( lock, timeout, [this]() { return m_raised; } );
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_raised;
+};
+
+VLC::Media createMedia( VLC::Instance& instance, const std::string& path )
+{
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+    (void)instance;
+    return VLC::Media( path, VLC::Media::FromPath );
+#else
+    return VLC::Media( instance, path, VLC::Media::FromPath );
+#endif
+}
+
+VLC::MediaList createList( VLC::Instance& instance )
+{
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+    (void)instance;
+    return VLC::MediaList();
+#else
+    return VLC::MediaList( instance );
+#endif
+}
+
+void stopPlayer( VLC::MediaPlayer& mp )
+{
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+    mp.stopAsync();
+#else
+    mp.stop();
+#endif
+}
+
+/*
+ * Event dispatch: libvlc raises MediaListItemAdded synchronously from
+ * libvlc_media_list_add_media, which makes for a deterministic event source.
+ */
+
+void rawItemAdded( const libvlc_event_t*, void* data )
+{
+    ++*static_cast<uint64_t*>( data );
+}
+
+void benchEvents( VLC::Instance& instance, VLC::Media& media )
+{
+    auto addItems = []( VLC::MediaList& ml, VLC::Media& md, size_t n ) {
+        ml.lock();
+        for ( size_t i = 0; i < n; ++i )
+            ml.addMedia( md );
+        ml.unlock();
+    };
+    auto clear = []( VLC::MediaList& ml ) {
+        ml.lock();
+        for ( auto i = ml.count(); i > 0; --i )
+            ml.removeIndex( i - 1 );
+        ml.unlock();
+    };
+    const size_t iterations = 20000;
+    {
+        auto ml = createList( instance );
+        measure( "event.list_add.no_handler", iterations,
+                 [&]( size_t n ) { addItems( ml, media, n ); },
+                 [&]() { clear( ml ); } );
+    }
+    {
+        auto ml = createList( instance );
+        uint64_t count = 0;
+        libvlc_media_list_t* raw = ml;
+        auto em = libvlc_media_list_event_manager( raw );
+        libvlc_event_attach( em, libvlc_MediaListItemAdded, &rawItemAdded, &count );
+        measure( "event.list_add.raw_attach", iterations,
+                 [&]( size_t n ) { addItems( ml, media, n ); },
+                 [&]() { clear( ml ); } );
+        libvlc_event_detach( em, libvlc_MediaListItemAdded, &rawItemAdded, &count );
+    }
+    {
+        auto ml = createList( instance );
+        uint64_t count = 0;
+        auto h = ml.eventManager().onItemAdded( [&count]( VLC::MediaPtr, int ) { ++count; } );
+        measure( "event.list_add.vlcpp_handler", iterations,
+                 [&]( size_t n ) { addItems( ml, media, n ); },
+                 [&]() { clear( ml ); } );
+        h->unregister();
+    }
+}
+
+/*
+ * Trampolines: the functions handed to libvlc are invoked directly, through
+ * a volatile pointer so that the call can't be inlined, like libvlc does.
+ */
+
+struct RawContext
+{
+    uint64_t count;
+    void* buffer;
+};
+
+void* rawLock( void* opaque, void** planes )
+{
+    auto ctx = static_cast<RawContext*>( opaque );
+    *planes = ctx->buffer;
+    ++ctx->count;
+    return nullptr;
+}
+
+void rawDisplay( void* opaque, void* )
+{
+    ++static_cast<RawContext*>( opaque )->count;
+}
+
+void rawPlay( void* opaque, const void*, unsigned int, int64_t )
+{
+    ++static_cast<RawContext*>( opaque )->count;
+}
+
+// Any index does, the trampolines don't depend on it
+enum BenchIdx : size_t
+{
+    Lock,
+    Display,
+    Play,
+    NbBenchCallbacks,
+};
+
+void benchTrampolines()
+{
+    const size_t iterations = 10000000;
+    uint8_t buffer[64];
+    RawContext ctx{ 0, buffer };
+    uint64_t count = 0;
+    void* planes[1];
+
+    VLC::CallbackArray<NbBenchCallbacks> callbacks;
+    void* opaque = &callbacks;
+    libvlc_video_lock_cb volatile lockCb =
+        VLC::CallbackWrapper<Lock, libvlc_video_lock_cb>::wrap( callbacks,
+            [&count, &buffer]( void** p ) -> void* {
+                *p = buffer;
+                ++count;
+                return nullptr;
+            });
+    libvlc_video_display_cb volatile displayCb =
+        VLC::CallbackWrapper<Display, libvlc_video_display_cb>::wrap( callbacks,
+            [&count]( void* ) { ++count; } );
+    libvlc_audio_play_cb volatile playCb =
+        VLC::CallbackWrapper<Play, libvlc_audio_play_cb>::wrap( callbacks,
+            [&count]( const void*, unsigned int, int64_t ) { ++count; } );
+    libvlc_video_lock_cb volatile rawLockCb = &rawLock;
+    libvlc_video_display_cb volatile rawDisplayCb = &rawDisplay;
+    libvlc_audio_play_cb volatile rawPlayCb = &rawPlay;
+
+    measure( "trampoline.video_lock.raw", iterations, [&]( size_t n ) {
+        for ( size_t i = 0; i < n; ++i )
+            rawLockCb( &ctx, planes );
+    });
+    measure( "trampoline.video_lock.vlcpp", iterations, [&]( size_t n ) {
+        for ( size_t i = 0; i < n; ++i )
+            lockCb( opaque, planes );
+    });
+    measure( "trampoline.video_display.raw", iterations, [&]( size_t n ) {
+        for ( size_t i = 0; i < n; ++i )
+            rawDisplayCb( &ctx, nullptr );
+    });
+    measure( "trampoline.video_display.vlcpp", iterations, [&]( size_t n ) {
+        for ( size_t i = 0; i < n; ++i )
+            displayCb( opaque, nullptr );
+    });
+    measure( "trampoline.audio_play.raw", iterations, [&]( size_t n ) {
+        for ( size_t i = 0; i < n; ++i )
+            rawPlayCb( &ctx, buffer, 16, static_cast<int64_t>( i ) );
+    });
+    measure( "trampoline.audio_play.vlcpp", iterations, [&]( size_t n ) {
+        for ( size_t i = 0; i < n; ++i )
+            playCb( opaque, buffer, 16, static_cast<int64_t>( i ) );
+    });
+    if ( ctx.count == 0 || count == 0 )
+        std::cerr << "trampolines were not invoked" << std::endl;
+}
+
+/*
+ * Tracks: the cost of building the MediaTrack vectors, compared with the
+ * raw list retrieval & release
+ */
+
+bool parse( VLC::Instance& instance, VLC::Media& media )
+{
+    Signal parsed;
+    auto status = VLC::Media::ParsedStatus::Skipped;
+    auto h = media.eventManager().onParsedChanged( [&parsed, &status]( VLC::Media::ParsedStatus s ) {
+        if ( s != VLC::Media::ParsedStatus::Done && s != VLC::Media::ParsedStatus::Failed &&
+             s != VLC::Media::ParsedStatus::Timeout )
+            return;
+        status = s;
+        parsed.raise();
+    });
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+    auto res = media.parseRequest( instance, VLC::Media::ParseFlags::Local, 5000 );
+#else
+    (void)instance;
+    auto res = media.parseWithOptions( VLC::Media::ParseFlags::Local, 5000 );
+#endif
+    res = res == true && parsed.wait( std::chrono::milliseconds( 10000 ) ) == true;
+    h->unregister();
+    return res == true && status == VLC::Media::ParsedStatus::Done;
+}
+
+void benchTracks( VLC::Instance& instance, VLC::Media& media )
+{
+    if ( parse( instance, media ) == false )
+    {
+        std::cerr << "Failed to parse the sample, skipping the tracks benchmarks" << std::endl;
+        return;
+    }
+    const size_t iterations = 20000;
+    libvlc_media_t* md = VLC::getInternalPtr<libvlc_media_t>( media );
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+    measure( "tracks.media.raw", iterations, [md]( size_t n ) {
+        for ( size_t i = 0; i < n; ++i )
+        {
+            auto list = libvlc_media_get_tracklist( md, libvlc_track_video );
+            if ( list != nullptr )
+                libvlc_media_tracklist_delete( list );
+        }
+    });
+    measure( "tracks.media.vlcpp", iterations, [&media]( size_t n ) {
+        for ( size_t i = 0; i < n; ++i )
+            media.tracks( VLC::MediaTrack::Type::Video );
+    });
+
+    Signal playing;
+    VLC::MediaPlayer mp( instance, media );
+    auto h = mp.eventManager().onESAdded( [&playing]( VLC::MediaTrack::Type, const std::string& ) {
+        playing.raise();
+    });
+    mp.play();
+    if ( playing.wait( std::chrono::milliseconds( 10000 ) ) == true )
+    {
+        mp.setPause( true );
+        libvlc_media_player_t* p = mp;
+        measure( "tracks.player.raw", iterations, [p]( size_t n ) {
+            for ( size_t i = 0; i < n; ++i )
+            {
+                auto list = libvlc_media_player_get_tracklist( p, libvlc_track_video, false );
+                if ( list != nullptr )
+                    libvlc_media_tracklist_delete( list );
+            }
+        });
+        measure( "tracks.player.vlcpp", iterations, [&mp]( size_t n ) {
+            for ( size_t i = 0; i < n; ++i )
+                mp.tracks( VLC::MediaTrack::Type::Video, false );
+        });
+    }
+    else
+        std::cerr << "Failed to start the playback, skipping the player tracks benchmarks" << std::endl;
+    h->unregister();
+    stopPlayer( mp );
+#else
+    measure( "tracks.media.raw", iterations, [md]( size_t n ) {
+        for ( size_t i = 0; i < n; ++i )
+        {
+            libvlc_media_track_t** tracks;
+            auto nbTracks = libvlc_media_tracks_get( md, &tracks );
+            libvlc_media_tracks_release( tracks, nbTracks );
+        }
+    });
+    measure( "tracks.media.vlcpp", iterations, [&media]( size_t n ) {
+        for ( size_t i = 0; i < n; ++i )
+            media.tracks();
+    });
+#endif
+}
+
+/*
+ * imem: the media is read from memory through the callbacks, and streamed
+ * to a dummy stream output, so that the demuxer isn't paced by the playback
+ * clock.
+ */
+
+struct MemoryStream
+{
+    const std::vector<unsigned char>* data;
+    size_t pos;
+    uint64_t nbReads;
+    uint64_t nbBytes;
+};
+
+void benchImem( VLC::Instance& instance, const std::string& path )
+{
+    std::vector<unsigned char> data;
+    {
+        std::ifstream f( path, std::ios::binary );
+        data.assign( std::istreambuf_iterator<char>( f ), std::istreambuf_iterator<char>() );
+    }
+    if ( data.empty() == true )
+    {
+        std::cerr << "Failed to read " << path << ", skipping the imem benchmark" << std::endl;
+        return;
+    }
+    std::vector<double> runs;
+    uint64_t nbReads = 0;
+    for ( size_t run = 0; run < 3; ++run )
+    {
+        MemoryStream stream{ &data, 0, 0, 0 };
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        auto media = VLC::Media(
+#else
+        auto media = VLC::Media( instance,
+#endif
+            [&stream]( void*, void** opaque, uint64_t* size ) -> int {
+                stream.pos = 0;
+                *opaque = &stream;
+                *size = stream.data->size();
+                return 0;
+            },
+            []( void* opaque, unsigned char* buf, size_t size ) -> ptrdiff_t {
+                auto s = static_cast<MemoryStream*>( opaque );
+                auto len = std::min( size, s->data->size() - s->pos );
+                memcpy( buf, s->data->data() + s->pos, len );
+                s->pos += len;
+                ++s->nbReads;
+                s->nbBytes += len;
+                return static_cast<ptrdiff_t>( len );
+            },
+            []( void* opaque, uint64_t offset ) -> int {
+                auto s = static_cast<MemoryStream*>( opaque );
+                if ( offset > s->data->size() )
+                    return -1;
+                s->pos = static_cast<size_t>( offset );
+                return 0;
+            },
+            nullptr );
+        media.addOption( ":sout=#dummy" );
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        VLC::MediaPlayer mp( instance, media );
+#else
+        VLC::MediaPlayer mp( media );
+#endif
+        Signal ended;
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        mp.eventManager().onStopping( [&ended]() { ended.raise(); } );
+#else
+        mp.eventManager().onEndReached( [&ended]() { ended.raise(); } );
+#endif
+        mp.eventManager().onEncounteredError( [&ended]() { ended.raise(); } );
+        auto start = Clock::now();
+        mp.play();
+        auto done = ended.wait( std::chrono::milliseconds( 60000 ) );
+        auto elapsed = Clock::now() - start;
+        stopPlayer( mp );
+        if ( done == false || stream.nbBytes == 0 )
+        {
+            std::cerr << "The imem playback didn't complete, skipping the imem benchmark" << std::endl;
+            return;
+        }
+        nbReads = stream.nbReads;
+        // MB/s
+        runs.push_back( static_cast<double>( stream.nbBytes ) * 1000. / nanoseconds( elapsed ) );
+    }
+    report( "imem.read_throughput", "MB/s", nbReads, std::move( runs ) );
+}
+
+/*
+ * Start to first frame: the time between play() and the first picture
+ * handed to the display callback
+ */
+
+void benchFirstFrame( VLC::Instance& instance, VLC::Media& media )
+{
+    const unsigned width = 320;
+    const unsigned height = 240;
+    std::vector<uint8_t> buffer( width * height * 4 );
+    std::vector<double> runs;
+    for ( size_t run = 0; run < 5; ++run )
+    {
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        VLC::MediaPlayer mp( instance, media );
+#else
+        (void)instance;
+        VLC::MediaPlayer mp( media );
+#endif
+        Signal displayed;
+        auto planes = buffer.data();
+        mp.setVideoCallbacks( [planes]( void** p ) -> void* {
+            *p = planes;
+            return nullptr;
+        }, nullptr, [&displayed]( void* ) {
+            displayed.raise();
+        });
+        mp.setVideoFormat( "RV32", width, height, width * 4 );
+        auto start = Clock::now();
+        mp.play();
+        auto done = displayed.wait( std::chrono::milliseconds( 10000 ) );
+        auto elapsed = Clock::now() - start;
+        stopPlayer( mp );
+        if ( done == false )
+        {
+            std::cerr << "No frame was displayed, skipping the first frame benchmark" << std::endl;
+            return;
+        }
+        // Milliseconds
+        runs.push_back( nanoseconds( elapsed ) / 1000000. );
+    }
+    report( "player.first_frame", "ms", runs.size(), std::move( runs ) );
+}
+
+} // namespace
+
+int main( int ac, char** av )
+{
+    if ( ac < 2 )
+    {
+        std::cerr << "usage: " << av[0] << " <sample file> [output.json]" << std::endl;
+        return 1;
+    }
+    const char* vlcArgs[] = { "--quiet", "--aout=dummy" };
+    VLC::Instance instance( 2, vlcArgs );
+    auto media = createMedia( instance, av[1] );
+
+    benchEvents( instance, media );
+    benchTrampolines();
+    benchTracks( instance, media );
+    benchImem( instance, av[1] );
+    benchFirstFrame( instance, media );
+
+    if ( ac > 2 )
+    {
+        std::ofstream out( av[2] );
+        writeJson( out );
+        return out.good() == true ? 0 : 1;
+    }
+    writeJson( std::cout );
+    return 0;
+}
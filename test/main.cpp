@@ -24,7 +24,520 @@
 
 #include <iostream>
 #include <thread>
+#include <cstdio>
 #include <cstring>
+#include <limits>
+
+static VLC::Media newTestMedia(VLC::Instance& instance, const std::string& mrl)
+{
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+    (void)instance;
+    return VLC::Media( mrl, VLC::Media::FromLocation );
+#else
+    return VLC::Media( instance, mrl, VLC::Media::FromLocation );
+#endif
+}
+
+static void testAudioSink()
+{
+    VLC::AudioSink::Config config;
+    config.format = "S16N";
+    config.bufferDuration = std::chrono::milliseconds( 100 );
+    VLC::AudioSink sink( config );
+    char format[5] = "FL32";
+    uint32_t rate = 1000;
+    uint32_t channels = 1;
+    // 100 frames, rounded up to 128
+    auto res = sink.setup( format, &rate, &channels );
+    assert( res == 0 && sink.frameSize() == 2 );
+    std::vector<int16_t> in( 128 );
+    std::vector<int16_t> out( 128 );
+    auto fill = [&in]( int16_t first ) {
+        for ( size_t i = 0; i < in.size(); ++i )
+            in[i] = static_cast<int16_t>( first + i );
+    };
+    auto check = [&out]( size_t nbFrames, int16_t first ) {
+        for ( size_t i = 0; i < nbFrames; ++i )
+            assert( out[i] == static_cast<int16_t>( first + i ) );
+    };
+    int64_t pts;
+
+    fill( 0 );
+    sink.play( in.data(), 64, 0 );
+    auto nbRead = sink.read( out.data(), 32, &pts );
+    assert( nbRead == 32 && pts == 0 );
+    check( nbRead, 0 );
+
+    // The flushed frames are skipped, but their room is only given back once
+    // the consumer moved past them
+    sink.flush( 0 );
+    fill( 1000 );
+    sink.play( in.data(), 128, 1000 );
+    assert( sink.nbOverrunFrames() == 32 && sink.available() == 96 );
+    nbRead = sink.read( out.data(), 128, &pts );
+    assert( nbRead == 96 && pts == 1000 );
+    check( nbRead, 1000 );
+    fill( 2000 );
+    sink.play( in.data(), 128, 2000 );
+    assert( sink.nbOverrunFrames() == 32 );
+    nbRead = sink.readExact( out.data(), 128, &pts );
+    assert( nbRead == 128 && pts == 2000 );
+    check( nbRead, 2000 );
+
+    // Looking for frames is enough to release the flushed ones
+    sink.play( in.data(), 100, 3000 );
+    sink.flush( 0 );
+    nbRead = sink.readExact( out.data(), 10 );
+    assert( nbRead == 0 );
+    fill( 4000 );
+    sink.play( in.data(), 128, 4000 );
+    assert( sink.nbOverrunFrames() == 32 );
+    nbRead = sink.read( out.data(), 128 );
+    assert( nbRead == 128 );
+    check( nbRead, 4000 );
+    sink.cleanup();
+}
+
+static void testDispatchTable(VLC::Instance& instance)
+{
+    auto media = newTestMedia( instance, "file:///dispatch-table-test" );
+    auto& em = media.eventManager();
+    em.setDispatchMode( VLC::EventManager::DispatchMode::Table );
+    auto nbCalls1 = 0;
+    auto nbCalls2 = 0;
+    VLC::EventManager::Handle h1 = em.onMetaChanged( [&nbCalls1](libvlc_meta_t) { ++nbCalls1; } );
+    assert( em.isRegistered( h1 ) == true );
+    em.unregister( h1 );
+    assert( em.isRegistered( h1 ) == false );
+    // The slot is recycled for the next registration, which the stale handle
+    // must not match
+    VLC::EventManager::Handle h2 = em.onMetaChanged( [&nbCalls2](libvlc_meta_t) { ++nbCalls2; } );
+    assert( h2.event() == h1.event() && h2.generation() != h1.generation() );
+    assert( em.isRegistered( h1 ) == false && em.isRegistered( h2 ) == true );
+    em.unregister( h1 );
+    media.setMeta( libvlc_meta_Title, "title" );
+    assert( nbCalls1 == 0 && nbCalls2 == 1 );
+
+    // A handler can unregister itself, and others, while being dispatched
+    VLC::EventManager::Handle self;
+    auto nbSelfCalls = 0;
+    self = em.onMetaChanged( [&em, &self, &h2, &nbSelfCalls](libvlc_meta_t) {
+        ++nbSelfCalls;
+        em.unregister( self, h2 );
+    });
+    media.setMeta( libvlc_meta_Title, "other title" );
+    assert( nbSelfCalls == 1 && em.isRegistered( self ) == false && em.isRegistered( h2 ) == false );
+    // h2 might have been dispatched before the removal
+    auto nbCalls2Before = nbCalls2;
+    media.setMeta( libvlc_meta_Title, "last title" );
+    assert( nbSelfCalls == 1 && nbCalls2 == nbCalls2Before );
+}
+
+static void testEventQueue(VLC::Instance& instance)
+{
+    // A capacity of 2 is kept as is
+    auto queue = std::make_shared<VLC::EventQueue>( 2 );
+    assert( queue->capacity() == 2 && queue->empty() == true );
+    auto media = newTestMedia( instance, "file:///event-queue-test" );
+    auto& em = media.eventManager();
+    em.setEventQueue( queue );
+    assert( em.dispatchMode() == VLC::EventManager::DispatchMode::Table );
+    auto nbMetaChanged = 0;
+    em.onMetaChanged( [&nbMetaChanged](libvlc_meta_t) {
+        ++nbMetaChanged;
+    });
+    // Nothing is delivered until the queue is drained, and the events
+    // which don't fit are dropped
+    for ( auto i = 0; i < 5; ++i )
+        media.setMeta( libvlc_meta_Title, "title " + std::to_string( i ) );
+    assert( nbMetaChanged == 0 && queue->empty() == false );
+    auto nbDrained = queue->drain();
+    assert( nbDrained == 2 && nbMetaChanged == 2 );
+    assert( queue->nbDropped() == 3 && queue->empty() == true );
+
+    // An event queued from another thread wakes the waiting one up
+    auto start = std::chrono::steady_clock::now();
+    std::thread t( [&media]() {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+        media.setMeta( libvlc_meta_Title, "from another thread" );
+    });
+    size_t nbEvents = 0;
+    while ( nbEvents == 0 )
+        nbEvents = queue->waitAndDrain( std::chrono::seconds( 5 ) );
+    t.join();
+    assert( nbEvents == 1 && nbMetaChanged == 3 );
+    assert( std::chrono::steady_clock::now() - start < std::chrono::seconds( 5 ) );
+
+    // wakeUp interrupts the wait, without any event
+    std::thread w( [&queue]() {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+        queue->wakeUp();
+    });
+    nbEvents = queue->waitAndDrain( std::chrono::seconds( 5 ) );
+    assert( nbEvents == 0 );
+    w.join();
+}
+
+static void testRateLimit(VLC::Instance& instance)
+{
+    const libvlc_meta_t metas[] = { libvlc_meta_Title, libvlc_meta_Artist,
+                                    libvlc_meta_Genre, libvlc_meta_Album };
+    const auto interval = std::chrono::milliseconds( 50 );
+
+    // Synchronous delivery: the events received within the interval are lost
+    {
+        auto media = newTestMedia( instance, "file:///rate-limit-test" );
+        auto& em = media.eventManager();
+        auto nbCalls = 0;
+        VLC::EventManager::Handle h = em.onMetaChanged( [&nbCalls](libvlc_meta_t) { ++nbCalls; } );
+        auto res = em.setRateLimit( h, interval );
+        assert( res == true );
+        for ( auto m : metas )
+            media.setMeta( m, "value" );
+        assert( nbCalls == 1 );
+        em.unregister( h );
+        res = em.setRateLimit( h, interval );
+        assert( res == false );
+    }
+
+    // Through a queue: the last dropped event is delivered once the interval
+    // elapsed
+    auto queue = std::make_shared<VLC::EventQueue>( 16 );
+    auto media = newTestMedia( instance, "file:///rate-limit-queue-test" );
+    auto& em = media.eventManager();
+    em.setEventQueue( queue );
+    std::vector<libvlc_meta_t> received;
+    VLC::EventManager::Handle h = em.onMetaChanged( [&received](libvlc_meta_t m) { received.push_back( m ); } );
+    auto res = em.setRateLimit( h, interval );
+    assert( res == true );
+    for ( auto m : metas )
+        media.setMeta( m, "value" );
+    auto nbDrained = queue->drain();
+    assert( nbDrained == 4 );
+    assert( received.size() == 1 && received[0] == libvlc_meta_Title );
+    // Too early for the held back event
+    nbDrained = queue->drain();
+    assert( nbDrained == 0 && received.size() == 1 );
+    auto start = std::chrono::steady_clock::now();
+    size_t nbEvents = 0;
+    while ( nbEvents == 0 )
+        nbEvents = queue->waitAndDrain( std::chrono::seconds( 5 ) );
+    assert( nbEvents == 1 && std::chrono::steady_clock::now() - start < std::chrono::seconds( 5 ) );
+    assert( received.size() == 2 && received[1] == libvlc_meta_Album );
+    // Nothing is left behind
+    nbEvents = queue->waitAndDrain( interval * 2 );
+    assert( nbEvents == 0 && received.size() == 2 );
+
+    // A held back event is superseded by the next delivered one
+    std::this_thread::sleep_for( interval * 2 );
+    media.setMeta( libvlc_meta_Title, "value" );
+    media.setMeta( libvlc_meta_Artist, "value" );
+    queue->drain();
+    std::this_thread::sleep_for( interval * 2 );
+    media.setMeta( libvlc_meta_Genre, "value" );
+    queue->drain();
+    assert( received.size() == 4 && received[3] == libvlc_meta_Genre );
+    nbEvents = queue->waitAndDrain( interval * 2 );
+    assert( nbEvents == 0 && received.size() == 4 );
+}
+
+static void testHistogram()
+{
+    using Histogram = VLC::instrumentation::Histogram;
+    // Each bucket starts right after the previous one, and holds the values
+    // up to the next lower bound
+    assert( Histogram::lowerBound( 0 ) == 0 );
+    for ( size_t i = 0; i + 1 < Histogram::NbBuckets; ++i )
+    {
+        auto lower = Histogram::lowerBound( i );
+        auto next = Histogram::lowerBound( i + 1 );
+        assert( next > lower );
+        assert( Histogram::bucket( lower ) == i );
+        assert( Histogram::bucket( next - 1 ) == i );
+        // Within 25% of the lower bound, past the exact buckets
+        assert( i < 4 || ( next - lower ) * 4 <= lower );
+    }
+    // The values past the last bucket are clamped
+    auto last = Histogram::NbBuckets - 1;
+    assert( Histogram::bucket( Histogram::lowerBound( last ) ) == last );
+    assert( Histogram::bucket( std::numeric_limits<uint64_t>::max() ) == last );
+
+    Histogram h;
+    for ( uint64_t ns = 1; ns <= 100; ++ns )
+        h.record( ns * 1000 );
+    assert( h.count() == 100 && h.maxNs() == 100000 && h.totalNs() == 5050000 );
+    VLC::instrumentation::Report r;
+    r.count = h.count();
+    r.totalNs = h.totalNs();
+    r.maxNs = h.maxNs();
+    for ( size_t i = 0; i < Histogram::NbBuckets; ++i )
+        r.buckets[i] = h.bucketCount( i );
+    assert( r.meanNs() == 50500. );
+    // The 50th value is 50us, reported as its bucket lower bound
+    auto p50 = r.percentile( 0.5 );
+    assert( p50 == Histogram::lowerBound( Histogram::bucket( 50000 ) ) );
+    assert( r.percentile( 1. ) == Histogram::lowerBound( Histogram::bucket( 100000 ) ) );
+    h.reset();
+    assert( h.count() == 0 && h.maxNs() == 0 && h.bucketCount( Histogram::bucket( 1000 ) ) == 0 );
+}
+
+struct Counted
+{
+    int refs;
+};
+
+struct CountedTraits
+{
+    static void retain( Counted* c ) { ++c->refs; }
+    static void release( Counted* c ) { --c->refs; }
+};
+
+static void testLocalRef()
+{
+    using Ref = VLC::Ref<Counted, CountedTraits>;
+    using LocalRef = VLC::LocalRef<Counted, CountedTraits>;
+    Counted obj{ 1 };
+    LocalRef a( Ref::adopt( &obj ) );
+    assert( obj.refs == 1 && a.unique() == true );
+    {
+        // The copies share the same reference
+        LocalRef b( a );
+        LocalRef c;
+        c = b;
+        assert( obj.refs == 1 && a.unique() == false && b == a && c == a );
+        // Leaving from the middle of the ring keeps the others linked
+        b.reset();
+        assert( b.isValid() == false && b.unique() == false );
+        assert( obj.refs == 1 && a.unique() == false );
+        LocalRef d( std::move( c ) );
+        assert( c.isValid() == false && d == a );
+        LocalRef e;
+        e = std::move( d );
+        assert( d.isValid() == false && e == a && a.unique() == false );
+    }
+    assert( obj.refs == 1 && a.unique() == true );
+
+    // A Ref holds a separate reference
+    auto r = a.toRef();
+    assert( obj.refs == 2 && r.get() == &obj );
+    r.reset();
+    assert( obj.refs == 1 );
+
+    // Assigning another object detaches from the previous one
+    Counted other{ 1 };
+    LocalRef o( Ref::adopt( &other ) );
+    LocalRef copy( a );
+    o = copy;
+    assert( other.refs == 0 && o == a && obj.refs == 1 );
+
+    // The last copy releases the reference
+    a.reset();
+    copy.reset();
+    assert( obj.refs == 1 && o.unique() == true );
+    o.reset();
+    assert( obj.refs == 0 );
+}
+
+static void testMediaListIndex(VLC::Instance& instance)
+{
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+    VLC::MediaList list;
+#else
+    VLC::MediaList list( instance );
+#endif
+    std::vector<VLC::Media> medias;
+    for ( auto i = 0; i < 4; ++i )
+        medias.push_back( newTestMedia( instance, "file:///index-test-" + std::to_string( i ) ) );
+    auto nbAdded = list.addMedias( medias );
+    assert( nbAdded == 4 );
+    VLC::MediaListIndex index( list );
+    // The index must agree with a linear search
+    auto check = [&list, &index, &medias]() {
+        assert( static_cast<int>( index.size() ) == list.count() );
+        for ( auto& md : medias )
+        {
+            int pos;
+            int mrlPos = -1;
+            {
+                VLC::MediaList::Lock lock( list );
+                pos = list.indexOfItem( md );
+                for ( auto i = 0; i < list.count() && mrlPos < 0; ++i )
+                {
+                    if ( list.itemAtIndex( i )->mrl() == md.mrl() )
+                        mrlPos = i;
+                }
+            }
+            assert( index.indexOf( md ) == pos );
+            assert( index.indexOf( md.mrl() ) == mrlPos );
+        }
+    };
+    check();
+    assert( index.indexOf( medias[2] ) == 2 && index.indexOf( "file:///index-test-3" ) == 3 );
+
+    // Duplicates report their first occurrence, through both lookups
+    nbAdded = list.addMedias( std::vector<VLC::Media>{ medias[1], medias[0] } );
+    assert( nbAdded == 2 );
+    assert( index.indexOf( medias[1] ) == 1 && index.indexOf( medias[0] ) == 0 );
+    check();
+    // A different media with an already known MRL
+    auto sameMrl = newTestMedia( instance, "file:///index-test-2" );
+    {
+        VLC::MediaList::Lock lock( list );
+        auto res = list.insertMedia( sameMrl, 1 );
+        assert( res == true );
+    }
+    assert( index.indexOf( sameMrl ) == 1 && index.indexOf( "file:///index-test-2" ) == 1 );
+    assert( index.indexOf( medias[2] ) == 3 );
+    check();
+
+    // Removing from the middle shifts the following items
+    {
+        VLC::MediaList::Lock lock( list );
+        auto res = list.removeIndex( 1 );
+        assert( res == true );
+        res = list.removeIndex( 0 );
+        assert( res == true );
+    }
+    assert( index.indexOf( sameMrl ) == -1 && index.indexOf( "file:///index-test-2" ) == 1 );
+    // The first medias[0] is gone, the duplicate at the end is found
+    assert( index.indexOf( medias[0] ) == list.count() - 1 );
+    check();
+    auto nbRemoved = list.removeRange( 1, 2 );
+    assert( nbRemoved == 2 );
+    check();
+    nbRemoved = list.removeRange( 0, list.count() );
+    assert( nbRemoved > 0 );
+    assert( index.size() == 0 && index.indexOf( medias[1] ) == -1 && index.indexOf( "file:///index-test-1" ) == -1 );
+}
+
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
+static void testDiscoveryFeed(VLC::Instance& instance)
+{
+    using Change = VLC::DiscoveryFeed::Change;
+    const std::string cachePath = "discovery-feed-test.cache";
+    std::remove( cachePath.c_str() );
+    auto add = [&instance](VLC::MediaList& list, const std::string& mrl) {
+        auto md = newTestMedia( instance, mrl );
+        VLC::MediaList::Lock lock( list );
+        auto res = list.addMedia( md );
+        assert( res == true );
+    };
+    auto removeFirst = [](VLC::MediaList& list) {
+        VLC::MediaList::Lock lock( list );
+        auto res = list.removeIndex( 0 );
+        assert( res == true );
+    };
+
+    // The discoverers' lists are read-only: the feed is driven from lists
+    // filled by hand
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+    VLC::MediaList list1;
+    VLC::MediaList list2;
+#else
+    VLC::MediaList list1( instance );
+    VLC::MediaList list2( instance );
+#endif
+    std::vector<Change> changes;
+    auto cb = [&changes](const std::vector<Change>& c) {
+        changes.insert( end( changes ), begin( c ), end( c ) );
+    };
+    {
+        VLC::DiscoveryFeed feed( cb, cachePath );
+        assert( changes.empty() );
+        add( list1, "file:///shared" );
+        feed.addMediaList( list1 );
+        feed.addMediaList( list2 );
+        assert( list1.eventManager().nbRegistered() == 2 && list2.eventManager().nbRegistered() == 2 );
+        assert( changes.size() == 1 && changes[0].type == Change::Type::Added );
+        // Reported by both lists, added once, removed with the last one
+        add( list2, "file:///shared" );
+        add( list2, "file:///only" );
+        assert( changes.size() == 2 && changes[1].entry.key == "file:///only" );
+        assert( changes[1].entry.id == VLC::DiscoveryFeed::idOf( VLC::DiscoveryFeed::Kind::Media, "file:///only" ) );
+        removeFirst( list1 );
+        assert( changes.size() == 2 && feed.entries().size() == 2 );
+        auto saved = feed.save();
+        assert( saved == true );
+    }
+    // The feed unregistered its handlers
+    assert( list1.eventManager().nbRegistered() == 0 && list2.eventManager().nbRegistered() == 0 );
+    add( list1, "file:///after" );
+    assert( changes.size() == 2 );
+
+    changes.clear();
+    {
+        VLC::DiscoveryFeed feed( cb, cachePath );
+        assert( changes.size() == 2 && changes[0].entry.cached == true && changes[1].entry.cached == true );
+        assert( feed.media( changes[0].entry.id ) == nullptr );
+        // "file:///only" is gone before its list is added
+        removeFirst( list2 );
+        removeFirst( list2 );
+        add( list2, "file:///shared" );
+        feed.addMediaList( list2 );
+        assert( changes.size() == 3 && changes[2].type == Change::Type::Confirmed );
+        assert( changes[2].entry.key == "file:///shared" && changes[2].entry.cached == false );
+        assert( feed.media( changes[2].entry.id ) != nullptr );
+        feed.expireCached();
+        assert( changes.size() == 4 && changes[3].type == Change::Type::Removed );
+        assert( changes[3].entry.key == "file:///only" && feed.entries().size() == 1 );
+    }
+    std::remove( cachePath.c_str() );
+
+    // A discoverer which isn't started provides an empty list
+    VLC::MediaDiscoverer sd( instance, "upnp" );
+    if ( sd.isValid() == true )
+    {
+        changes.clear();
+        VLC::DiscoveryFeed feed( cb );
+        auto res = feed.addMediaDiscoverer( sd );
+        assert( res == true && changes.empty() == true );
+    }
+
+    VLC::RendererDiscoverer rd( instance, "microdns" );
+    if ( rd.isValid() == true )
+    {
+        // The event manager is left for the feed to create
+        {
+            VLC::DiscoveryFeed feed( nullptr );
+            feed.addRendererDiscoverer( rd );
+            assert( rd.eventManager().nbRegistered() == 2 );
+        }
+        assert( rd.eventManager().nbRegistered() == 0 );
+    }
+}
+
+static void testSeqLock()
+{
+    // Not a multiple of the word size, so that the last word is partial
+    struct Value
+    {
+        uint64_t a;
+        uint64_t b;
+        uint32_t c;
+    };
+    VLC::detail::SeqLock<Value> lock( Value{ 1, 2, 3 } );
+    auto v = lock.load();
+    assert( v.a == 1 && v.b == 2 && v.c == 3 );
+
+    // The writer keeps b == 2 * a and c == 3 * a, a torn read would not
+    std::atomic<bool> stop( false );
+    std::thread writer( [&lock, &stop]() {
+        for ( uint64_t i = 1; stop.load() == false; ++i )
+            lock.store( Value{ i, 2 * i, static_cast<uint32_t>( 3 * i ) } );
+    });
+    uint64_t last = 0;
+    for ( auto i = 0; i < 100000; ++i )
+    {
+        v = lock.load();
+        assert( v.b == 2 * v.a );
+        assert( v.c == static_cast<uint32_t>( 3 * v.a ) );
+        assert( v.a >= last );
+        last = v.a;
+    }
+    stop.store( true );
+    writer.join();
+}
+#endif
 
 int main(int ac, char** av)
 {
@@ -39,6 +552,18 @@ int main(int ac, char** av)
         static_cast<uint8_t*>( imgBuffer ), &free };
     auto instance = VLC::Instance(1, &vlcArgs);
 
+    testAudioSink();
+    testDispatchTable( instance );
+    testEventQueue( instance );
+    testRateLimit( instance );
+    testHistogram();
+    testLocalRef();
+    testMediaListIndex( instance );
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
+    testDiscoveryFeed( instance );
+    testSeqLock();
+#endif
+
 #if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
     auto sds = instance.mediaDiscoverers( VLC::MediaDiscoverer::Category::Lan );
     for ( const auto& sd : sds )
@@ -104,6 +629,24 @@ int main(int ac, char** av)
     // We might want to fix this, but is it worth the cost of a shared/weak_pointer?
     expected = false;
 
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
+    {
+        // Created while playing: the initial snapshot catches up with the
+        // player, then the events keep it up to date
+        VLC::PlayerStateMonitor monitor( mp );
+        auto s = monitor.snapshot();
+        assert( s.state == libvlc_Playing );
+        assert( s.isPlaying == true );
+        assert( s.length > 0 );
+        std::this_thread::sleep_for( std::chrono::milliseconds( 500 ) );
+        VLC::MediaPlayer::Snapshot rows[1];
+        std::vector<VLC::PlayerStateMonitor*> monitors{ &monitor };
+        VLC::PlayerStateMonitor::snapshot( monitors.begin(), monitors.end(), rows );
+        assert( rows[0].state == libvlc_Playing );
+        assert( rows[0].time >= s.time );
+    }
+#endif
+
     std::this_thread::sleep_for( std::chrono::seconds( 2 ) );
 
     expected = true;
@@ -179,6 +722,63 @@ int main(int ac, char** av)
     {
         std::cout << f.name() << std::endl;
     }
+    // Render through a frame pool, and keep the last frame alive after the
+    // player is gone
+    {
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        auto poolMp = VLC::MediaPlayer(instance, media);
+#else
+        auto poolMp = VLC::MediaPlayer(media);
+#endif
+        VLC::VideoFramePool::Config config;
+        config.chroma = "RV32";
+        config.width = 480;
+        config.height = 320;
+        auto pool = std::make_shared<VLC::VideoFramePool>( config );
+        auto queue = std::make_shared<VLC::VideoFrameQueue>( 1, VLC::VideoFrameQueue::Overflow::KeepLatest );
+        poolMp.setVideoFramePool( pool, [queue](VLC::VideoFrame frame) {
+            assert( frame.width() == 480 && frame.pitch( 0 ) >= 480 * 4 );
+            queue->push( std::move( frame ) );
+        });
+        auto sink = std::make_shared<VLC::AudioSink>();
+        poolMp.setAudioSink( sink );
+        // The time changes pending in the queue are coalesced
+        auto eventQueue = std::make_shared<VLC::EventQueue>( 16 );
+        poolMp.eventManager().setEventQueue( eventQueue );
+        libvlc_time_t lastTime = -1;
+        auto nbTimeChanged = 0;
+        poolMp.eventManager().onTimeChanged( [&lastTime, &nbTimeChanged](libvlc_time_t t) {
+            lastTime = t;
+            ++nbTimeChanged;
+        });
+        poolMp.play();
+        VLC::VideoFrame lastFrame;
+        for ( auto i = 0; i < 10; ++i )
+        {
+            VLC::VideoFrame frame;
+            if ( queue->waitPop( frame, std::chrono::milliseconds( 100 ) ) == true )
+            {
+                assert( lastFrame.isValid() == false || frame.sequence() > lastFrame.sequence() );
+                lastFrame = std::move( frame );
+            }
+        }
+        auto nbTimeEvents = eventQueue->drain();
+        assert( nbTimeEvents <= 1 && nbTimeChanged == static_cast<int>( nbTimeEvents ) );
+        assert( nbTimeChanged == 0 || lastTime >= 0 );
+        float samples[1024 * 8];
+        int64_t pts;
+        if ( sink->channels() <= 8 && sink->readExact( samples, 1024, &pts ) == 1024 )
+            std::cout << "Read 1024 " << sink->format() << " frames at pts " << pts << std::endl;
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        poolMp.stopAsync();
+#else
+        poolMp.stop();
+#endif
+        poolMp = VLC::MediaPlayer{};
+        std::cout << "Displayed " << pool->nbDisplayed() << " pooled frames" << std::endl;
+        assert( lastFrame.isValid() == false || lastFrame.plane( 0 ) != nullptr );
+    }
+
     // Check that we don't use the old media player when releasing its event manager
     mp = VLC::MediaPlayer{};
 }
@@ -0,0 +1,499 @@
+/*****************************************************************************
+ * AudioSink.hpp: Lock-free ring buffer sink for the audio callbacks
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_AUDIOSINK_H
+#define LIBVLC_CXX_AUDIOSINK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "common.hpp"
+
+namespace VLC
+{
+
+namespace detail
+{
+    inline unsigned audioSampleSize( const char* format )
+    {
+        if ( memcmp( format, "S16N", 4 ) == 0 )
+            return 2;
+        if ( memcmp( format, "S32N", 4 ) == 0 || memcmp( format, "FL32", 4 ) == 0 )
+            return 4;
+        if ( memcmp( format, "FL64", 4 ) == 0 )
+            return 8;
+        if ( memcmp( format, "U8  ", 4 ) == 0 )
+            return 1;
+        return 0;
+    }
+
+    /**
+     * Single producer/single consumer ring of audio frames, along with the
+     * pts of the buffers they were received in.
+     * Indexes are expressed in frames, and grow monotonically.
+     */
+    struct AudioRing
+    {
+        // Number of play() buffers for which we remember the pts
+        static const size_t NbPtsMarkers = 64;
+
+        struct PtsMarker
+        {
+            std::atomic<uint64_t> seq;
+            std::atomic<uint64_t> frame;
+            std::atomic<int64_t> pts;
+        };
+
+        AudioRing( const char* fmt, unsigned r, unsigned nbChannels, size_t minFrames )
+            : rate( r )
+            , channels( nbChannels )
+            , frameSize( audioSampleSize( fmt ) * nbChannels )
+            , capacity( 1 )
+            , writeIndex( 0 )
+            , readIndex( 0 )
+            , flushIndex( 0 )
+            , nbMarkers( 0 )
+        {
+            memcpy( format, fmt, 4 );
+            format[4] = 0;
+            while ( capacity < minFrames )
+                capacity <<= 1;
+            samples.reset( new uint8_t[capacity * frameSize] );
+            for ( size_t i = 0; i < NbPtsMarkers; ++i )
+                markers[i].seq.store( UINT64_MAX, std::memory_order_relaxed );
+        }
+
+        char format[5];
+        const unsigned rate;
+        const unsigned channels;
+        const size_t frameSize;
+        size_t capacity;
+        std::unique_ptr<uint8_t[]> samples;
+        std::atomic<uint64_t> writeIndex;
+        char padding0[64];
+        std::atomic<uint64_t> readIndex;
+        char padding1[64];
+        // Frames below this index were flushed, and must be skipped. Their
+        // room is only given back once the consumer moved its read index
+        // past them, as it might still be copying some of them.
+        std::atomic<uint64_t> flushIndex;
+        std::atomic<uint64_t> nbMarkers;
+        PtsMarker markers[NbPtsMarkers];
+        // Consumer side cache of the last marker used
+        uint64_t markerCursor = 0;
+    };
+}
+
+///
+/// \brief The AudioSink class buffers the decoded audio in a preallocated
+/// lock-free ring, for the application to pull from its own thread.
+///
+/// Install it on a player through MediaPlayer::setAudioSink(). The libvlc
+/// audio thread copies samples into the ring without any allocation nor lock,
+/// and the application reads them in batches of its choosing with read() or
+/// readExact(), along with the pts of the first frame read.
+///
+/// The ring is sized when libvlc negotiates the audio format, from the rate,
+/// channel count and Config::bufferDuration. When the consumer doesn't keep up,
+/// the incoming samples that don't fit are dropped, and accounted for in
+/// nbOverrunFrames().
+///
+/// The setup/cleanup/play/pause/resume/flush/drain/setVolume methods are meant
+/// to be called by libvlc. The other methods are meant for the consumer, and
+/// must always be called from the same thread.
+///
+class AudioSink
+{
+public:
+    class Config
+    {
+    public:
+        Config()
+            : format( "FL32" )
+            , rate( 0 )
+            , channels( 0 )
+            , bufferDuration( std::chrono::milliseconds( 500 ) )
+            , handleVolume( false )
+        {
+        }
+
+        /// Requested sample format: "S16N", "S32N", "FL32" or "FL64". An empty
+        /// string keeps the format proposed by libvlc, when supported.
+        std::string format;
+        /// Requested rate (in Hz) & channel count, 0 to keep libvlc's
+        unsigned rate;
+        unsigned channels;
+        /// Amount of audio the ring can hold
+        std::chrono::milliseconds bufferDuration;
+        /// If true, libvlc won't apply the volume, and the application is
+        /// expected to do so, based on volume() and isMuted()
+        bool handleVolume;
+    };
+
+    explicit AudioSink( const Config& config = Config() )
+        : m_config( config )
+        , m_generation( 0 )
+        , m_consumerGeneration( 0 )
+        , m_paused( false )
+        , m_draining( false )
+        , m_volume( 1.f )
+        , m_muted( false )
+        , m_nbOverrunFrames( 0 )
+    {
+    }
+
+    AudioSink( const AudioSink& ) = delete;
+    AudioSink& operator=( const AudioSink& ) = delete;
+
+    /**
+     * Setup callback implementation.
+     * Matches MediaPlayer::setAudioFormatCallbacks() setup callback prototype.
+     *
+     * \return 0 on success
+     */
+    int setup( char* format, uint32_t* rate, uint32_t* channels )
+    {
+        if ( m_config.format.size() == 4 )
+            memcpy( format, m_config.format.c_str(), 4 );
+        else if ( detail::audioSampleSize( format ) == 0 )
+            memcpy( format, "FL32", 4 );
+        if ( detail::audioSampleSize( format ) == 0 )
+            return -1;
+        if ( m_config.rate != 0 )
+            *rate = m_config.rate;
+        if ( m_config.channels != 0 )
+            *channels = m_config.channels;
+        if ( *rate == 0 || *channels == 0 )
+            return -1;
+        auto nbFrames = static_cast<size_t>( *rate ) * m_config.bufferDuration.count() / 1000;
+        auto ring = std::make_shared<detail::AudioRing>( format, *rate, *channels,
+                                                         nbFrames > 0 ? nbFrames : 1 );
+        {
+            std::lock_guard<std::mutex> lock( m_ringMutex );
+            m_ring = ring;
+            m_generation.fetch_add( 1, std::memory_order_release );
+        }
+        m_producerRing = std::move( ring );
+        return 0;
+    }
+
+    /// Cleanup callback implementation
+    void cleanup()
+    {
+        m_producerRing.reset();
+        m_draining.store( false, std::memory_order_relaxed );
+        m_drainParker.notify();
+    }
+
+    /// Play callback implementation
+    void play( const void* samples, uint32_t count, int64_t pts )
+    {
+        auto ring = m_producerRing.get();
+        if ( ring == nullptr || count == 0 )
+            return;
+        auto w = ring->writeIndex.load( std::memory_order_relaxed );
+        auto r = ring->readIndex.load( std::memory_order_acquire );
+        auto room = ring->capacity - static_cast<size_t>( w - r );
+        size_t nbFrames = count;
+        if ( nbFrames > room )
+        {
+            m_nbOverrunFrames.fetch_add( nbFrames - room, std::memory_order_relaxed );
+            nbFrames = room;
+        }
+        if ( nbFrames == 0 )
+            return;
+        // Publish the pts of this buffer before its samples
+        auto m = ring->nbMarkers.load( std::memory_order_relaxed );
+        auto& marker = ring->markers[m % detail::AudioRing::NbPtsMarkers];
+        marker.seq.store( UINT64_MAX, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_release );
+        marker.frame.store( w, std::memory_order_relaxed );
+        marker.pts.store( pts, std::memory_order_relaxed );
+        marker.seq.store( m, std::memory_order_release );
+        ring->nbMarkers.store( m + 1, std::memory_order_release );
+
+        copyIn( *ring, w, static_cast<const uint8_t*>( samples ), nbFrames );
+        ring->writeIndex.store( w + nbFrames, std::memory_order_release );
+    }
+
+    /// Pause callback implementation
+    void pause( int64_t )
+    {
+        m_paused.store( true, std::memory_order_relaxed );
+    }
+
+    /// Resume callback implementation
+    void resume( int64_t )
+    {
+        m_paused.store( false, std::memory_order_relaxed );
+    }
+
+    /// Flush callback implementation: discards all the pending samples
+    void flush( int64_t )
+    {
+        auto ring = m_producerRing.get();
+        if ( ring == nullptr )
+            return;
+        ring->flushIndex.store( ring->writeIndex.load( std::memory_order_relaxed ),
+                                std::memory_order_release );
+    }
+
+    /**
+     * Drain callback implementation.
+     * Waits for the consumer to read the pending samples, for at most the
+     * ring duration.
+     */
+    void drain()
+    {
+        auto ring = m_producerRing;
+        if ( ring == nullptr )
+            return;
+        auto end = ring->writeIndex.load( std::memory_order_relaxed );
+        m_draining.store( true );
+        m_drainParker.waitUntil( [&ring, end, this]() {
+            return ring->readIndex.load() >= end ||
+                    ring->flushIndex.load() >= end ||
+                    m_draining.load( std::memory_order_relaxed ) == false;
+        }, std::chrono::steady_clock::now() + m_config.bufferDuration );
+        m_draining.store( false, std::memory_order_relaxed );
+    }
+
+    /// Volume callback implementation, used when Config::handleVolume is true
+    void setVolume( float volume, bool mute )
+    {
+        m_volume.store( volume, std::memory_order_relaxed );
+        m_muted.store( mute, std::memory_order_relaxed );
+    }
+
+    /**
+     * Reads up to \p maxFrames frames.
+     *
+     * \param buffer    A buffer of at least maxFrames * frameSize() bytes
+     * \param maxFrames The maximum number of frames to read
+     * \param pts       If not nullptr, receives the pts of the first frame read
+     *                  or -1 if unknown
+     *
+     * \return The number of frames read
+     */
+    size_t read( void* buffer, size_t maxFrames, int64_t* pts = nullptr )
+    {
+        return doRead( buffer, maxFrames, false, pts );
+    }
+
+    /**
+     * Reads exactly \p nbFrames frames, or nothing if less frames are pending.
+     * This allows processing audio in fixed size blocks without any extra copy.
+     *
+     * \return nbFrames if enough frames were pending, 0 otherwise
+     */
+    size_t readExact( void* buffer, size_t nbFrames, int64_t* pts = nullptr )
+    {
+        return doRead( buffer, nbFrames, true, pts );
+    }
+
+    /// Number of frames ready to be read
+    size_t available()
+    {
+        auto ring = consumerRing();
+        if ( ring == nullptr )
+            return 0;
+        return static_cast<size_t>( ring->writeIndex.load( std::memory_order_acquire ) -
+                                    readStart( *ring ) );
+    }
+
+    /// Negotiated sample format, or an empty string before the first setup
+    std::string format()
+    {
+        auto ring = consumerRing();
+        return ring != nullptr ? ring->format : std::string{};
+    }
+
+    unsigned rate()
+    {
+        auto ring = consumerRing();
+        return ring != nullptr ? ring->rate : 0;
+    }
+
+    unsigned channels()
+    {
+        auto ring = consumerRing();
+        return ring != nullptr ? ring->channels : 0;
+    }
+
+    /// Size of a frame (ie. one sample for each channel), in bytes
+    size_t frameSize()
+    {
+        auto ring = consumerRing();
+        return ring != nullptr ? ring->frameSize : 0;
+    }
+
+    bool isPaused() const
+    {
+        return m_paused.load( std::memory_order_relaxed );
+    }
+
+    float volume() const
+    {
+        return m_volume.load( std::memory_order_relaxed );
+    }
+
+    bool isMuted() const
+    {
+        return m_muted.load( std::memory_order_relaxed );
+    }
+
+    /// Number of frames dropped because the ring was full
+    uint64_t nbOverrunFrames() const
+    {
+        return m_nbOverrunFrames.load( std::memory_order_relaxed );
+    }
+
+    const Config& config() const
+    {
+        return m_config;
+    }
+
+private:
+    detail::AudioRing* consumerRing()
+    {
+        // Only lock when the format changed
+        if ( m_generation.load( std::memory_order_acquire ) != m_consumerGeneration )
+        {
+            std::lock_guard<std::mutex> lock( m_ringMutex );
+            m_consumerRing = m_ring;
+            m_consumerGeneration = m_generation.load( std::memory_order_relaxed );
+        }
+        return m_consumerRing.get();
+    }
+
+    static uint64_t readStart( detail::AudioRing& ring )
+    {
+        auto r = ring.readIndex.load( std::memory_order_relaxed );
+        auto flushed = ring.flushIndex.load( std::memory_order_acquire );
+        return r < flushed ? flushed : r;
+    }
+
+    size_t doRead( void* buffer, size_t maxFrames, bool exact, int64_t* pts )
+    {
+        if ( pts != nullptr )
+            *pts = -1;
+        auto ring = consumerRing();
+        if ( ring == nullptr )
+            return 0;
+        auto r = readStart( *ring );
+        // Give the room of the flushed frames back to the producer
+        if ( r != ring->readIndex.load( std::memory_order_relaxed ) )
+            ring->readIndex.store( r );
+        auto w = ring->writeIndex.load( std::memory_order_acquire );
+        auto nbFrames = static_cast<size_t>( w - r );
+        if ( exact == true && nbFrames < maxFrames )
+            return 0;
+        if ( nbFrames > maxFrames )
+            nbFrames = maxFrames;
+        if ( nbFrames == 0 )
+            return 0;
+        if ( pts != nullptr )
+            *pts = ptsAt( *ring, r );
+        copyOut( *ring, r, static_cast<uint8_t*>( buffer ), nbFrames );
+        // Sequentially consistent, along with the m_draining store in drain():
+        // either drain() sees the new read index, or this sees it's draining
+        ring->readIndex.store( r + nbFrames );
+        if ( m_draining.load() == true )
+            m_drainParker.notify();
+        return nbFrames;
+    }
+
+    // Returns the pts of the given frame, based on the last buffer starting
+    // before it.
+    static int64_t ptsAt( detail::AudioRing& ring, uint64_t frame )
+    {
+        const auto NbMarkers = detail::AudioRing::NbPtsMarkers;
+        auto nbMarkers = ring.nbMarkers.load( std::memory_order_acquire );
+        if ( nbMarkers == 0 )
+            return -1;
+        // Skip the markers that were overwritten since we last looked
+        if ( nbMarkers - ring.markerCursor > NbMarkers )
+            ring.markerCursor = nbMarkers - NbMarkers;
+        auto res = int64_t{ -1 };
+        for ( auto m = ring.markerCursor; m < nbMarkers; ++m )
+        {
+            auto& marker = ring.markers[m % NbMarkers];
+            if ( marker.seq.load( std::memory_order_acquire ) != m )
+                continue;
+            auto markerFrame = marker.frame.load( std::memory_order_relaxed );
+            auto markerPts = marker.pts.load( std::memory_order_relaxed );
+            std::atomic_thread_fence( std::memory_order_acquire );
+            if ( marker.seq.load( std::memory_order_relaxed ) != m )
+                continue;
+            if ( markerFrame > frame )
+                break;
+            ring.markerCursor = m;
+            res = markerPts + static_cast<int64_t>( ( frame - markerFrame ) * 1000000 / ring.rate );
+        }
+        return res;
+    }
+
+    static void copyIn( detail::AudioRing& ring, uint64_t index, const uint8_t* src, size_t nbFrames )
+    {
+        auto offset = static_cast<size_t>( index & ( ring.capacity - 1 ) );
+        auto first = ring.capacity - offset < nbFrames ? ring.capacity - offset : nbFrames;
+        memcpy( ring.samples.get() + offset * ring.frameSize, src, first * ring.frameSize );
+        if ( first < nbFrames )
+            memcpy( ring.samples.get(), src + first * ring.frameSize,
+                    ( nbFrames - first ) * ring.frameSize );
+    }
+
+    static void copyOut( detail::AudioRing& ring, uint64_t index, uint8_t* dst, size_t nbFrames )
+    {
+        auto offset = static_cast<size_t>( index & ( ring.capacity - 1 ) );
+        auto first = ring.capacity - offset < nbFrames ? ring.capacity - offset : nbFrames;
+        memcpy( dst, ring.samples.get() + offset * ring.frameSize, first * ring.frameSize );
+        if ( first < nbFrames )
+            memcpy( dst + first * ring.frameSize, ring.samples.get(),
+                    ( nbFrames - first ) * ring.frameSize );
+    }
+
+private:
+    const Config m_config;
+    // The ring currently in use, as published by setup()
+    std::mutex m_ringMutex;
+    std::shared_ptr<detail::AudioRing> m_ring;
+    std::atomic<unsigned> m_generation;
+    // Producer side reference
+    std::shared_ptr<detail::AudioRing> m_producerRing;
+    // Consumer side cache
+    std::shared_ptr<detail::AudioRing> m_consumerRing;
+    unsigned m_consumerGeneration;
+    std::atomic<bool> m_paused;
+    std::atomic<bool> m_draining;
+    detail::ThreadParker m_drainParker;
+    std::atomic<float> m_volume;
+    std::atomic<bool> m_muted;
+    std::atomic<uint64_t> m_nbOverrunFrames;
+};
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_AUDIOSINK_H
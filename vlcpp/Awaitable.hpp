@@ -0,0 +1,495 @@
+/*****************************************************************************
+ * Awaitable.hpp: C++20 awaitables for the asynchronous libvlc operations
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_AWAITABLE_H
+#define LIBVLC_CXX_AWAITABLE_H
+
+// The awaitables are only available to C++20 (or later) translation units
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <atomic>
+#include <coroutine>
+#include <stdexcept>
+#include <utility>
+
+#include "common.hpp"
+#include "EventManager.hpp"
+#include "Instance.hpp"
+#include "Media.hpp"
+#include "MediaPlayer.hpp"
+#include "Ref.hpp"
+
+namespace VLC
+{
+
+///
+/// The awaitables turn the libvlc operations reporting their completion
+/// through an event into co_await expressions.
+///
+/// They don't provide a coroutine type: any task type can await them. The
+/// awaiting coroutine is resumed through the provided executor, which is any
+/// object with a `void post( std::coroutine_handle<> )` method, typically
+/// queuing the handle to a thread pool:
+///
+///     Task inspect( Pool& pool, VLC::Media media, VLC::MediaPlayer mp )
+///     {
+///         auto status = co_await VLC::parseAsync( pool, media, VLC::Media::ParseFlags::Local, 5000 );
+///         if ( status != VLC::Media::ParsedStatus::Done )
+///             co_return;
+///         mp.setMedia( media );
+///         mp.play();
+///         if ( co_await VLC::waitForState( pool, mp, libvlc_Playing ) == libvlc_Error )
+///             co_return;
+///         ...
+///     }
+///
+/// The awaitables live in the coroutine frame, and register an event handler
+/// for the duration of the operation. With the event manager in
+/// DispatchMode::Table, the handler slots are recycled, and awaiting doesn't
+/// allocate anything once the manager is warm.
+///
+/// \warning The executor must not resume the coroutine from within post(),
+/// unless the event manager is in DispatchMode::Table: the handler is
+/// unregistered when the coroutine resumes, which would otherwise happen from
+/// the libvlc event callback.
+/// As with the EventManager, a given media or player must only be awaited on
+/// by one coroutine at a time, and a coroutine must not be destroyed while it
+/// is suspended on one of these awaitables.
+///
+namespace detail
+{
+
+// Resumes the coroutine once, either from the callback completing the
+// operation, or inline when the operation completed before the coroutine was
+// actually suspended.
+template <typename Derived, typename Executor, typename Result>
+class EventAwaiter
+{
+public:
+    explicit EventAwaiter( Executor& executor )
+        : m_executor( executor )
+        , m_result()
+        , m_claimed( false )
+        , m_state( Starting )
+    {
+    }
+
+    EventAwaiter( const EventAwaiter& ) = delete;
+    EventAwaiter& operator=( const EventAwaiter& ) = delete;
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    bool await_suspend( std::coroutine_handle<> coro )
+    {
+        m_coro = coro;
+        static_cast<Derived*>( this )->start();
+        // If the operation already completed, nobody will post the coroutine
+        return m_state.exchange( Suspended, std::memory_order_acq_rel ) != Completed;
+    }
+
+    Result await_resume()
+    {
+        static_cast<Derived*>( this )->stop();
+        return std::move( m_result );
+    }
+
+protected:
+    // Only the first call has any effect, libvlc may report an event again
+    // before the handler gets unregistered
+    void complete( Result res )
+    {
+        if ( m_claimed.exchange( true, std::memory_order_relaxed ) == true )
+            return;
+        m_result = std::move( res );
+        if ( m_state.exchange( Completed, std::memory_order_acq_rel ) == Suspended )
+            m_executor.post( m_coro );
+    }
+
+private:
+    enum State
+    {
+        Starting,
+        Suspended,
+        Completed,
+    };
+
+    Executor& m_executor;
+    std::coroutine_handle<> m_coro;
+    Result m_result;
+    std::atomic<bool> m_claimed;
+    std::atomic<int> m_state;
+};
+
+} // namespace detail
+
+///
+/// \brief The ParseAwaiter class parses a media, and resumes with the
+/// resulting status. See parseAsync()
+///
+template <typename Executor>
+class ParseAwaiter : public detail::EventAwaiter<ParseAwaiter<Executor>, Executor, Media::ParsedStatus>
+{
+    using Base = detail::EventAwaiter<ParseAwaiter<Executor>, Executor, Media::ParsedStatus>;
+    friend Base;
+
+public:
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+    ParseAwaiter( Executor& executor, Media media, Instance instance,
+                  Media::ParseFlags flags, int timeout )
+        : Base( executor )
+        , m_media( std::move( media ) )
+        , m_instance( std::move( instance ) )
+        , m_flags( flags )
+        , m_timeout( timeout )
+    {
+    }
+#else
+    ParseAwaiter( Executor& executor, Media media, Media::ParseFlags flags, int timeout )
+        : Base( executor )
+        , m_media( std::move( media ) )
+        , m_flags( flags )
+        , m_timeout( timeout )
+    {
+    }
+#endif
+
+    ~ParseAwaiter()
+    {
+        stop();
+    }
+
+private:
+    void start()
+    {
+#if LIBVLC_VERSION_INT < LIBVLC_VERSION(4, 0, 0, 0)
+        // libvlc 3 only parses a media once, and won't report anything again
+        auto status = m_media.parsedStatus();
+        if ( static_cast<int>( status ) != 0 )
+        {
+            this->complete( status );
+            return;
+        }
+#endif
+        m_handle = m_media.eventManager().onParsedChanged( [this]( Media::ParsedStatus status ) {
+            this->complete( status );
+        });
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        auto started = m_media.parseRequest( m_instance, m_flags, m_timeout );
+#else
+        auto started = m_media.parseWithOptions( m_flags, m_timeout );
+#endif
+        if ( started == false )
+            this->complete( Media::ParsedStatus::Failed );
+    }
+
+    void stop()
+    {
+        m_media.eventManager().unregister( m_handle );
+    }
+
+private:
+    Media m_media;
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+    Instance m_instance;
+#endif
+    Media::ParseFlags m_flags;
+    int m_timeout;
+    EventManager::Handle m_handle;
+};
+
+///
+/// \brief The StateAwaiter class resumes once a player reaches a state, or
+/// encounters an error. See waitForState()
+///
+template <typename Executor>
+class StateAwaiter : public detail::EventAwaiter<StateAwaiter<Executor>, Executor, libvlc_state_t>
+{
+    using Base = detail::EventAwaiter<StateAwaiter<Executor>, Executor, libvlc_state_t>;
+    friend Base;
+
+public:
+    /**
+     * \param executor  The executor resuming the coroutine
+     * \param player    The player to watch
+     * \param state     The awaited state. libvlc_NothingSpecial and
+     *                  libvlc_Buffering aren't reported by any event, and
+     *                  can't be awaited.
+     * \param stop      Whether the player must be stopped asynchronously once
+     *                  the handlers are registered (libvlc 4 only)
+     *
+     * \throw std::invalid_argument if the state can't be awaited
+     */
+    StateAwaiter( Executor& executor, MediaPlayer player, libvlc_state_t state, bool stop = false )
+        : Base( executor )
+        , m_player( std::move( player ) )
+        , m_target( state )
+        , m_stop( stop )
+    {
+        if ( state == libvlc_NothingSpecial || state == libvlc_Buffering )
+            throw std::invalid_argument( "This player state can't be awaited" );
+    }
+
+    ~StateAwaiter()
+    {
+        stop();
+    }
+
+private:
+    void start()
+    {
+        auto& em = m_player.eventManager();
+        auto reached = [this]() {
+            this->complete( m_target );
+        };
+        switch ( m_target )
+        {
+        case libvlc_Opening:
+            m_handle = em.onOpening( reached );
+            break;
+        case libvlc_Playing:
+            m_handle = em.onPlaying( reached );
+            break;
+        case libvlc_Paused:
+            m_handle = em.onPaused( reached );
+            break;
+        case libvlc_Stopped:
+            m_handle = em.onStopped( reached );
+            break;
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        case libvlc_Stopping:
+            m_handle = em.onStopping( reached );
+            break;
+#else
+        case libvlc_Ended:
+            m_handle = em.onEndReached( reached );
+            break;
+#endif
+        default:
+            break;
+        }
+        m_errorHandle = em.onEncounteredError( [this]() {
+            this->complete( libvlc_Error );
+        });
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        if ( m_stop == true )
+            m_player.stopAsync();
+#endif
+        // The state may have been reached before the handlers were registered
+        if ( m_player.state() == m_target )
+            this->complete( m_target );
+    }
+
+    void stop()
+    {
+        m_player.eventManager().unregister( m_handle, m_errorHandle );
+    }
+
+private:
+    MediaPlayer m_player;
+    libvlc_state_t m_target;
+    bool m_stop;
+    EventManager::Handle m_handle;
+    EventManager::Handle m_errorHandle;
+};
+
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+///
+/// \brief The ThumbnailAwaiter class generates a thumbnail, and resumes with
+/// the resulting picture, which is invalid in case of failure. See
+/// thumbnailAsync()
+///
+template <typename Executor>
+class ThumbnailAwaiter : public detail::EventAwaiter<ThumbnailAwaiter<Executor>, Executor, UniquePicture>
+{
+    using Base = detail::EventAwaiter<ThumbnailAwaiter<Executor>, Executor, UniquePicture>;
+    friend Base;
+
+public:
+    /**
+     * \param byTime    Whether the thumbnail is taken at \p time, or at \p pos
+     *
+     * The other parameters are the ones of Media::thumbnailRequestByPos() &
+     * Media::thumbnailRequestByTime()
+     */
+    ThumbnailAwaiter( Executor& executor, Media media, Instance instance, bool byTime,
+                      float pos, libvlc_time_t time, Media::ThumbnailSeekSpeed speed,
+                      uint32_t width, uint32_t height, bool crop, Picture::Type type,
+                      libvlc_time_t timeout )
+        : Base( executor )
+        , m_media( std::move( media ) )
+        , m_instance( std::move( instance ) )
+        , m_byTime( byTime )
+        , m_pos( pos )
+        , m_time( time )
+        , m_speed( speed )
+        , m_width( width )
+        , m_height( height )
+        , m_crop( crop )
+        , m_type( type )
+        , m_timeout( timeout )
+        , m_request( nullptr )
+    {
+    }
+
+    ~ThumbnailAwaiter()
+    {
+        stop();
+    }
+
+private:
+    void start()
+    {
+        m_handle = m_media.eventManager().onThumbnailGeneratedUnique( [this]( UniquePicture pic ) {
+            this->complete( std::move( pic ) );
+        });
+        if ( m_byTime == true )
+            m_request = m_media.thumbnailRequestByTime( m_instance, m_time, m_speed, m_width,
+                                                        m_height, m_crop, m_type, m_timeout );
+        else
+            m_request = m_media.thumbnailRequestByPos( m_instance, m_pos, m_speed, m_width,
+                                                       m_height, m_crop, m_type, m_timeout );
+        if ( m_request == nullptr )
+            this->complete( UniquePicture() );
+    }
+
+    void stop()
+    {
+        m_media.eventManager().unregister( m_handle );
+        if ( m_request != nullptr )
+        {
+            m_media.thumbnailRequestDestroy( m_request );
+            m_request = nullptr;
+        }
+    }
+
+private:
+    Media m_media;
+    Instance m_instance;
+    bool m_byTime;
+    float m_pos;
+    libvlc_time_t m_time;
+    Media::ThumbnailSeekSpeed m_speed;
+    uint32_t m_width;
+    uint32_t m_height;
+    bool m_crop;
+    Picture::Type m_type;
+    libvlc_time_t m_timeout;
+    Media::ThumbnailRequest* m_request;
+    EventManager::Handle m_handle;
+};
+#endif
+
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+/**
+ * Parses a media, see Media::parseRequest()
+ *
+ * \return An awaitable resuming with the parsed status
+ */
+template <typename Executor>
+ParseAwaiter<Executor> parseAsync( Executor& executor, Media media, const Instance& instance,
+                                   Media::ParseFlags flags, int timeout )
+{
+    return ParseAwaiter<Executor>( executor, std::move( media ), instance, flags, timeout );
+}
+#else
+/**
+ * Parses a media, see Media::parseWithOptions()
+ *
+ * \return An awaitable resuming with the parsed status. libvlc 3 only parses
+ *         a media once: a media which was already parsed resumes right away
+ *         with its current status.
+ */
+template <typename Executor>
+ParseAwaiter<Executor> parseAsync( Executor& executor, Media media,
+                                   Media::ParseFlags flags, int timeout )
+{
+    return ParseAwaiter<Executor>( executor, std::move( media ), flags, timeout );
+}
+#endif
+
+/**
+ * Waits for a player to reach a state
+ *
+ * \return An awaitable resuming with \p state, or libvlc_Error if the player
+ *         encountered an error in the meantime. It resumes right away if the
+ *         player already is in that state.
+ * \throw std::invalid_argument if the state can't be awaited
+ */
+template <typename Executor>
+StateAwaiter<Executor> waitForState( Executor& executor, MediaPlayer player, libvlc_state_t state )
+{
+    return StateAwaiter<Executor>( executor, std::move( player ), state );
+}
+
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+/**
+ * Stops a player, see MediaPlayer::stopAsync()
+ *
+ * \return An awaitable resuming once the player is stopped, with
+ *         libvlc_Stopped, or libvlc_Error
+ */
+template <typename Executor>
+StateAwaiter<Executor> stopAsync( Executor& executor, MediaPlayer player )
+{
+    return StateAwaiter<Executor>( executor, std::move( player ), libvlc_Stopped, true );
+}
+
+/**
+ * Generates a thumbnail at a position, see Media::thumbnailRequestByPos()
+ *
+ * \return An awaitable resuming with the thumbnail, or an invalid picture
+ *         if it couldn't be generated
+ *
+ * \note libvlc doesn't tell the requests of a media apart: only one thumbnail
+ *       per media may be awaited at a time.
+ */
+template <typename Executor>
+ThumbnailAwaiter<Executor> thumbnailAsync( Executor& executor, Media media, const Instance& instance,
+                                           float pos, Media::ThumbnailSeekSpeed speed,
+                                           uint32_t width, uint32_t height, bool crop,
+                                           Picture::Type type, libvlc_time_t timeout )
+{
+    return ThumbnailAwaiter<Executor>( executor, std::move( media ), instance, false, pos, 0,
+                                       speed, width, height, crop, type, timeout );
+}
+
+/**
+ * Generates a thumbnail at a time, see Media::thumbnailRequestByTime() and
+ * thumbnailAsync()
+ */
+template <typename Executor>
+ThumbnailAwaiter<Executor> thumbnailAtTimeAsync( Executor& executor, Media media, const Instance& instance,
+                                                 libvlc_time_t time, Media::ThumbnailSeekSpeed speed,
+                                                 uint32_t width, uint32_t height, bool crop,
+                                                 Picture::Type type, libvlc_time_t timeout )
+{
+    return ThumbnailAwaiter<Executor>( executor, std::move( media ), instance, true, 0.f, time,
+                                       speed, width, height, crop, type, timeout );
+}
+#endif
+
+} // namespace VLC
+
+#endif
+
+#endif // LIBVLC_CXX_AWAITABLE_H
@@ -0,0 +1,567 @@
+/*****************************************************************************
+ * DiscoveryFeed.hpp: Deduplicated, incremental discovery results
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_DISCOVERYFEED_H
+#define LIBVLC_CXX_DISCOVERYFEED_H
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common.hpp"
+#include "EventManager.hpp"
+#include "Media.hpp"
+#include "MediaDiscoverer.hpp"
+#include "MediaList.hpp"
+#include "RendererDiscoverer.hpp"
+
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
+
+namespace VLC
+{
+
+///
+/// \brief The DiscoveryFeed class merges the items found by several media &
+/// renderer discoverers into a single stream of changes.
+///
+/// Each item is identified by a stable id, computed from its MRL (medias) or
+/// its type & name (renderers), so that an item reported by several
+/// discoverers is only added once, and only removed once none of them reports
+/// it anymore.
+///
+/// The items can be persisted to a cache file: the cached items are reported
+/// as soon as the feed is created, and are confirmed, or expired, as the
+/// discovery goes on:
+///
+///     VLC::DiscoveryFeed feed( []( const std::vector<VLC::DiscoveryFeed::Change>& changes ) {
+///         for ( const auto& c : changes )
+///             ui.apply( c.type, c.entry.id, c.entry.name );
+///     }, cachePath );
+///     feed.addMediaDiscoverer( upnp );
+///     feed.addMediaDiscoverer( smb );
+///     upnp.start();
+///     smb.start();
+///     ...
+///     // Later on, once the discovery had time to revalidate the cache
+///     feed.expireCached();
+///     feed.save();
+///
+/// The callback is invoked with the feed lock released, from the libvlc
+/// thread reporting the items, one batch at a time. It must not call into the
+/// discoverers: libvlc holds the media list lock while it reports the
+/// changes of a list.
+///
+/// \note Only the top level items of the media discoverers are reported, not
+/// the subitems of the nodes they contain.
+///
+class DiscoveryFeed
+{
+public:
+    enum class Kind
+    {
+        Media,
+        Renderer,
+    };
+
+    struct Entry
+    {
+        /// Stable across runs, derived from the kind & key
+        uint64_t id;
+        Kind kind;
+        /// The media MRL, or the renderer type & name
+        std::string key;
+        /// The media title (or MRL), or the renderer name
+        std::string name;
+        /// The renderer type, empty for the medias
+        std::string type;
+        /// True until a discoverer reports the item again
+        bool cached;
+    };
+
+    struct Change
+    {
+        enum class Type
+        {
+            Added,
+            /// A cached item was confirmed by a discoverer
+            Confirmed,
+            Removed,
+        };
+
+        Type type;
+        Entry entry;
+    };
+
+    using Callback = std::function<void(const std::vector<Change>&)>;
+
+    /**
+     * \param cb        Receives the changes
+     * \param cachePath The file the items are loaded from, and saved to by
+     *                  save(), or an empty string for no cache. The cached
+     *                  items are reported before this constructor returns.
+     */
+    explicit DiscoveryFeed( Callback cb, std::string cachePath = {} )
+        : m_cb( std::move( cb ) )
+        , m_cachePath( std::move( cachePath ) )
+        , m_delivering( false )
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        load();
+        deliver( lock );
+    }
+
+    /// Stops listening to the discoverers, without saving the cache
+    ~DiscoveryFeed()
+    {
+        for ( auto& s : m_mediaSources )
+            s.list->eventManager().unregister( s.added, s.deleted );
+        for ( auto& s : m_rendererSources )
+            s.discoverer.eventManager().unregister( s.added, s.deleted );
+    }
+
+    DiscoveryFeed( const DiscoveryFeed& ) = delete;
+    DiscoveryFeed& operator=( const DiscoveryFeed& ) = delete;
+
+    /**
+     * Reports the items of a media discoverer, including the ones it found
+     * already. The discoverer can be started before or after this call.
+     *
+     * \return false if the discoverer doesn't provide a media list
+     */
+    bool addMediaDiscoverer( MediaDiscoverer& discoverer )
+    {
+        auto list = discoverer.mediaList();
+        if ( list == nullptr )
+            return false;
+        addSource( std::move( list ) );
+        return true;
+    }
+
+    /**
+     * Reports the items of a media list, including the ones it holds
+     * already, such as a list filled by the application.
+     */
+    void addMediaList( MediaList& list )
+    {
+        // Share the event manager with our copy of the list, which
+        // unregisters the handlers upon destruction
+        list.eventManager();
+        addSource( std::make_shared<MediaList>( list ) );
+    }
+
+    /**
+     * Reports the items of a renderer discoverer. This must be called before
+     * the discoverer is started.
+     */
+    void addRendererDiscoverer( RendererDiscoverer& discoverer )
+    {
+        // Share the event manager with our copy of the discoverer, which
+        // unregisters the handlers upon destruction
+        auto& em = discoverer.eventManager();
+        RendererSource s{ discoverer, EventManager::Handle(), EventManager::Handle() };
+        s.added = em.onItemAdded( [this]( const RendererDiscoverer::Item& item ) {
+            onRendererAdded( item );
+        });
+        s.deleted = em.onItemDeleted( [this]( const RendererDiscoverer::Item& item ) {
+            onRendererDeleted( item );
+        });
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_rendererSources.push_back( std::move( s ) );
+    }
+
+    /// The current items, cached or reported by a discoverer
+    std::vector<Entry> entries() const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        std::vector<Entry> res;
+        res.reserve( m_items.size() );
+        for ( const auto& p : m_items )
+            res.push_back( p.second.entry );
+        return res;
+    }
+
+    /// The media of an item, or nullptr if it's not a media, or if it was
+    /// only cached so far
+    MediaPtr media( uint64_t id ) const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        auto it = m_items.find( id );
+        return it != end( m_items ) ? it->second.media : nullptr;
+    }
+
+    /// The renderer of an item, or nullptr if it's not a renderer, or if it
+    /// was only cached so far
+    std::shared_ptr<RendererDiscoverer::Item> renderer( uint64_t id ) const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        auto it = m_items.find( id );
+        return it != end( m_items ) ? it->second.renderer : nullptr;
+    }
+
+    /**
+     * Removes the cached items which no discoverer reported since the feed
+     * was created
+     */
+    void expireCached()
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        for ( auto it = begin( m_items ); it != end( m_items ); )
+        {
+            if ( it->second.entry.cached == true )
+            {
+                queue( Change::Type::Removed, it->second.entry );
+                it = m_items.erase( it );
+            }
+            else
+                ++it;
+        }
+        deliver( lock );
+    }
+
+    /**
+     * Writes the current items to the cache file, replacing it
+     *
+     * \return false if there is no cache file, or if it couldn't be written
+     */
+    bool save() const
+    {
+        if ( m_cachePath.empty() == true )
+            return false;
+        auto tmpPath = m_cachePath + ".tmp";
+        {
+            std::ofstream out( tmpPath, std::ios::binary | std::ios::trunc );
+            if ( out.is_open() == false )
+                return false;
+            out << cacheHeader() << '\n';
+            std::lock_guard<std::mutex> lock( m_mutex );
+            for ( const auto& p : m_items )
+            {
+                const auto& e = p.second.entry;
+                out << ( e.kind == Kind::Media ? 'm' : 'r' ) << '\t' << escape( e.key )
+                    << '\t' << escape( e.name ) << '\t' << escape( e.type ) << '\n';
+            }
+            if ( out.flush().good() == false )
+                return false;
+        }
+        std::remove( m_cachePath.c_str() );
+        return std::rename( tmpPath.c_str(), m_cachePath.c_str() ) == 0;
+    }
+
+    /// Computes the id of an item
+    static uint64_t idOf( Kind kind, const std::string& key )
+    {
+        // 64 bits FNV-1a
+        uint64_t h = 14695981039346656037ULL;
+        auto mix = [&h]( unsigned char c ) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        };
+        mix( kind == Kind::Media ? 'm' : 'r' );
+        for ( auto c : key )
+            mix( static_cast<unsigned char>( c ) );
+        return h;
+    }
+
+private:
+    // Bumped whenever the cache format changes, the older caches being ignored
+    static const char* cacheHeader()
+    {
+        return "libvlcpp-discovery-cache 1";
+    }
+
+    struct Item
+    {
+        Entry entry;
+        // The number of discoverers currently reporting the item
+        size_t nbSources;
+        MediaPtr media;
+        std::shared_ptr<RendererDiscoverer::Item> renderer;
+    };
+
+    struct MediaSource
+    {
+        std::shared_ptr<MediaList> list;
+        EventManager::Handle added;
+        EventManager::Handle deleted;
+    };
+
+    struct RendererSource
+    {
+        RendererDiscoverer discoverer;
+        EventManager::Handle added;
+        EventManager::Handle deleted;
+    };
+
+    static std::string rendererKey( const RendererDiscoverer::Item& item )
+    {
+        return item.type() + "://" + item.name();
+    }
+
+    void addSource( std::shared_ptr<MediaList> list )
+    {
+        MediaSource s;
+        s.list = list;
+        std::unique_lock<std::mutex> lock( m_mutex, std::defer_lock );
+        {
+            // Registering and reading the current items under the list lock,
+            // so that none is missed or reported twice
+            MediaList::Lock listLock( *list );
+            auto& em = list->eventManager();
+            s.added = em.onItemAdded( [this]( MediaPtr md, int ) {
+                onMediaAdded( std::move( md ) );
+            });
+            s.deleted = em.onItemDeleted( [this]( MediaPtr md, int ) {
+                onMediaDeleted( std::move( md ) );
+            });
+            std::vector<MediaPtr> current;
+            auto count = list->count();
+            for ( auto i = 0; i < count; ++i )
+            {
+                auto md = list->itemAtIndex( i );
+                if ( md != nullptr )
+                    current.push_back( std::move( md ) );
+            }
+            lock.lock();
+            m_mediaSources.push_back( std::move( s ) );
+            for ( auto& md : current )
+                addMedia( std::move( md ) );
+        }
+        // The changes are delivered once the list is unlocked, so that the
+        // callback can use it
+        deliver( lock );
+    }
+
+    void onMediaAdded( MediaPtr md )
+    {
+        if ( md == nullptr )
+            return;
+        std::unique_lock<std::mutex> lock( m_mutex );
+        addMedia( std::move( md ) );
+        deliver( lock );
+    }
+
+    void onMediaDeleted( MediaPtr md )
+    {
+        if ( md == nullptr )
+            return;
+        auto mrl = md->mrl();
+        std::unique_lock<std::mutex> lock( m_mutex );
+        release( idOf( Kind::Media, mrl ) );
+        deliver( lock );
+    }
+
+    void onRendererAdded( const RendererDiscoverer::Item& item )
+    {
+        Entry e;
+        e.kind = Kind::Renderer;
+        e.key = rendererKey( item );
+        e.id = idOf( e.kind, e.key );
+        e.name = item.name();
+        e.type = item.type();
+        e.cached = false;
+        auto renderer = std::make_shared<RendererDiscoverer::Item>( item );
+        std::unique_lock<std::mutex> lock( m_mutex );
+        auto& it = acquire( std::move( e ) );
+        it.renderer = std::move( renderer );
+        deliver( lock );
+    }
+
+    void onRendererDeleted( const RendererDiscoverer::Item& item )
+    {
+        auto id = idOf( Kind::Renderer, rendererKey( item ) );
+        std::unique_lock<std::mutex> lock( m_mutex );
+        release( id );
+        deliver( lock );
+    }
+
+    // Must be called with the lock held
+    void addMedia( MediaPtr md )
+    {
+        Entry e;
+        e.kind = Kind::Media;
+        e.key = md->mrl();
+        e.id = idOf( e.kind, e.key );
+        e.name = md->meta( libvlc_meta_Title );
+        if ( e.name.empty() == true )
+            e.name = e.key;
+        e.cached = false;
+        auto& it = acquire( std::move( e ) );
+        it.media = std::move( md );
+    }
+
+    // Accounts for a discoverer reporting an item. Must be called with the
+    // lock held
+    Item& acquire( Entry e )
+    {
+        auto it = m_items.find( e.id );
+        if ( it == end( m_items ) )
+        {
+            queue( Change::Type::Added, e );
+            auto id = e.id;
+            return m_items.emplace( id, Item{ std::move( e ), 1, nullptr, nullptr } ).first->second;
+        }
+        auto& item = it->second;
+        ++item.nbSources;
+        if ( item.entry.cached == true )
+        {
+            item.entry = std::move( e );
+            queue( Change::Type::Confirmed, item.entry );
+        }
+        return item;
+    }
+
+    // Must be called with the lock held
+    void release( uint64_t id )
+    {
+        auto it = m_items.find( id );
+        if ( it == end( m_items ) || it->second.nbSources == 0 )
+            return;
+        if ( --it->second.nbSources > 0 )
+            return;
+        queue( Change::Type::Removed, it->second.entry );
+        m_items.erase( it );
+    }
+
+    void queue( Change::Type type, const Entry& e )
+    {
+        m_pending.push_back( Change{ type, e } );
+    }
+
+    // Hands the pending changes to the callback, without holding the lock.
+    // A single thread delivers at a time, so that the changes are received
+    // in order.
+    void deliver( std::unique_lock<std::mutex>& lock )
+    {
+        if ( m_delivering == true )
+            return;
+        m_delivering = true;
+        while ( m_pending.empty() == false )
+        {
+            std::vector<Change> batch;
+            batch.swap( m_pending );
+            lock.unlock();
+            if ( m_cb != nullptr )
+                m_cb( batch );
+            lock.lock();
+        }
+        m_delivering = false;
+    }
+
+    // Must be called with the lock held
+    void load()
+    {
+        if ( m_cachePath.empty() == true )
+            return;
+        std::ifstream in( m_cachePath, std::ios::binary );
+        std::string line;
+        if ( std::getline( in, line ).good() == false || line != cacheHeader() )
+            return;
+        while ( std::getline( in, line ) )
+        {
+            std::vector<std::string> fields;
+            size_t start = 0;
+            for ( ;; )
+            {
+                auto tab = line.find( '\t', start );
+                fields.push_back( unescape( line.substr( start, tab - start ) ) );
+                if ( tab == std::string::npos )
+                    break;
+                start = tab + 1;
+            }
+            if ( fields.size() != 4 || fields[0].size() != 1 ||
+                 ( fields[0][0] != 'm' && fields[0][0] != 'r' ) )
+                continue;
+            Entry e;
+            e.kind = fields[0][0] == 'm' ? Kind::Media : Kind::Renderer;
+            e.key = std::move( fields[1] );
+            e.id = idOf( e.kind, e.key );
+            e.name = std::move( fields[2] );
+            e.type = std::move( fields[3] );
+            e.cached = true;
+            if ( m_items.find( e.id ) != end( m_items ) )
+                continue;
+            queue( Change::Type::Added, e );
+            auto id = e.id;
+            m_items.emplace( id, Item{ std::move( e ), 0, nullptr, nullptr } );
+        }
+    }
+
+    static std::string escape( const std::string& s )
+    {
+        std::string res;
+        res.reserve( s.size() );
+        for ( auto c : s )
+        {
+            switch ( c )
+            {
+            case '\\': res += "\\\\"; break;
+            case '\t': res += "\\t"; break;
+            case '\n': res += "\\n"; break;
+            case '\r': res += "\\r"; break;
+            default: res += c; break;
+            }
+        }
+        return res;
+    }
+
+    static std::string unescape( const std::string& s )
+    {
+        std::string res;
+        res.reserve( s.size() );
+        for ( size_t i = 0; i < s.size(); ++i )
+        {
+            if ( s[i] != '\\' || i + 1 == s.size() )
+            {
+                res += s[i];
+                continue;
+            }
+            switch ( s[++i] )
+            {
+            case 't': res += '\t'; break;
+            case 'n': res += '\n'; break;
+            case 'r': res += '\r'; break;
+            default: res += s[i]; break;
+            }
+        }
+        return res;
+    }
+
+private:
+    const Callback m_cb;
+    const std::string m_cachePath;
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint64_t, Item> m_items;
+    std::vector<Change> m_pending;
+    bool m_delivering;
+    std::vector<MediaSource> m_mediaSources;
+    std::vector<RendererSource> m_rendererSources;
+};
+
+} // namespace VLC
+
+#endif
+
+#endif // LIBVLC_CXX_DISCOVERYFEED_H
@@ -23,6 +23,10 @@
 #ifndef EQUALIZER_HPP
 #define EQUALIZER_HPP
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "common.hpp"
 #include "Internal.hpp"
 
@@ -32,6 +36,24 @@ namespace VLC
 class Equalizer : public Internal<libvlc_equalizer_t>
 {
 public:
+    struct Preset
+    {
+        std::string name;
+        float preamp;
+        /// One amplification value per band
+        std::vector<float> amps;
+    };
+
+    ///
+    /// \brief The PresetTable struct holds the band frequencies & the presets,
+    /// which are read from libvlc once per process.
+    ///
+    struct PresetTable
+    {
+        std::vector<float> frequencies;
+        std::vector<Preset> presets;
+    };
+
     /**
      * Create a new default equalizer, with all frequency values zeroed.
      *
@@ -63,9 +85,10 @@ public:
      * \version LibVLC 2.2.0 or later
      */
     Equalizer( unsigned int index )
-        : Internal{ libvlc_audio_equalizer_new_from_preset( index ), libvlc_audio_equalizer_release }
+        : Equalizer()
     {
-        if ( isValid() == false )
+        // The values come from the cached preset table, see presets()
+        if ( setPreset( index ) == false )
             throw std::runtime_error( "Failed to create audio equalizer" );
     }
 
@@ -127,6 +150,76 @@ public:
         return libvlc_audio_equalizer_get_amp_at_index( *this, band );
     }
 
+    /**
+     * Set the amplification values of several consecutive frequency bands.
+     *
+     * This only updates the equalizer: the settings are applied to a media
+     * player at once, by a single call to MediaPlayer::setEqualizer().
+     *
+     * \param amps  amplification values, the first one being for band 0.
+     *              The values past the last band are ignored.
+     * \param count number of values
+     * \return zero on success, -1 on error
+     */
+    int setBands( const float* amps, size_t count )
+    {
+        auto n = std::min<size_t>( count, bandCount() );
+        auto res = 0;
+        for ( auto i = 0u; i < n; ++i )
+        {
+            if ( libvlc_audio_equalizer_set_amp_at_index( *this, amps[i], i ) != 0 )
+                res = -1;
+        }
+        return res;
+    }
+
+    /**
+     * Same as setBands( const float*, size_t ), for any contiguous container
+     * of floats, such as a std::vector, a std::array or a std::span
+     */
+    template <typename Container>
+    int setBands( const Container& amps )
+    {
+        return setBands( amps.data(), amps.size() );
+    }
+
+    /**
+     * Get the amplification values of all the frequency bands.
+     */
+    std::vector<float> bands()
+    {
+        std::vector<float> res( bandCount() );
+        for ( auto i = 0u; i < res.size(); ++i )
+            res[i] = libvlc_audio_equalizer_get_amp_at_index( *this, i );
+        return res;
+    }
+
+    /**
+     * Copy the pre-amplification & amplification values of a preset into this
+     * equalizer, from the cached preset table.
+     *
+     * \param index index of the preset, counting from zero
+     * \return false if there is no such preset, or on error
+     */
+    bool setPreset( unsigned int index )
+    {
+        const auto& table = presets();
+        if ( index >= table.presets.size() )
+            return false;
+        const auto& p = table.presets[index];
+        return setPreamp( p.preamp ) == 0 && setBands( p.amps ) == 0;
+    }
+
+    /**
+     * Get the band frequencies & the presets. They are read from libvlc on
+     * the first call, and cached for the lifetime of the process.
+     */
+    static const PresetTable& presets()
+    {
+        static const PresetTable table = loadPresets();
+        return table;
+    }
+
     /**
      * Get the number of equalizer presets.
      *
@@ -135,7 +228,7 @@ public:
      */
     static unsigned int presetCount()
     {
-        return libvlc_audio_equalizer_get_preset_count();
+        return static_cast<unsigned int>( presets().presets.size() );
     }
 
     /**
@@ -150,7 +243,10 @@ public:
      */
     static std::string presetName( unsigned index )
     {
-        return libvlc_audio_equalizer_get_preset_name( index );
+        const auto& table = presets();
+        if ( index >= table.presets.size() )
+            return {};
+        return table.presets[index].name;
     }
 
     /**
@@ -161,7 +257,7 @@ public:
      */
     static unsigned int bandCount()
     {
-        return libvlc_audio_equalizer_get_band_count();
+        return static_cast<unsigned int>( presets().frequencies.size() );
     }
 
     /**
@@ -176,7 +272,43 @@ public:
      */
     static float bandFrequency( unsigned int index )
     {
-        return libvlc_audio_equalizer_get_band_frequency( index );
+        const auto& table = presets();
+        if ( index >= table.frequencies.size() )
+            return -1.f;
+        return table.frequencies[index];
+    }
+
+private:
+    static PresetTable loadPresets()
+    {
+        PresetTable table;
+        auto nbBands = libvlc_audio_equalizer_get_band_count();
+        table.frequencies.reserve( nbBands );
+        for ( auto i = 0u; i < nbBands; ++i )
+            table.frequencies.push_back( libvlc_audio_equalizer_get_band_frequency( i ) );
+        auto nbPresets = libvlc_audio_equalizer_get_preset_count();
+        table.presets.reserve( nbPresets );
+        for ( auto i = 0u; i < nbPresets; ++i )
+        {
+            Preset p;
+            auto name = libvlc_audio_equalizer_get_preset_name( i );
+            if ( name != nullptr )
+                p.name = name;
+            p.preamp = 0.f;
+            auto eq = libvlc_audio_equalizer_new_from_preset( i );
+            if ( eq != nullptr )
+            {
+                p.preamp = libvlc_audio_equalizer_get_preamp( eq );
+                p.amps.reserve( nbBands );
+                for ( auto b = 0u; b < nbBands; ++b )
+                    p.amps.push_back( libvlc_audio_equalizer_get_amp_at_index( eq, b ) );
+                libvlc_audio_equalizer_release( eq );
+            }
+            else
+                p.amps.assign( nbBands, 0.f );
+            table.presets.push_back( std::move( p ) );
+        }
+        return table;
     }
 };
 
@@ -0,0 +1,242 @@
+/*****************************************************************************
+ * EqualizerSmoother.hpp: Rate limited equalizer transitions
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_EQUALIZERSMOOTHER_H
+#define LIBVLC_CXX_EQUALIZERSMOOTHER_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "Equalizer.hpp"
+#include "MediaPlayer.hpp"
+
+namespace VLC
+{
+
+///
+/// \brief The EqualizerSmoother class moves the equalizer of a player
+/// towards its target settings progressively, at a bounded rate.
+///
+/// Each MediaPlayer::setEqualizer() call is handled by the audio output.
+/// Animating the equalizer directly, such as from a slider, pushes one such
+/// update per change. The smoother interpolates from the current settings to
+/// the latest target over Config::duration, and applies the result at most
+/// once per Config::interval, from its own thread:
+///
+///     VLC::EqualizerSmoother eq( player );
+///     eq.setPreset( rockIndex );
+///     ...
+///     // Any number of calls per second, coalesced into a few updates
+///     void onSliderMoved( unsigned int band, float amp )
+///     {
+///         bands[band] = amp;
+///         eq.setTarget( preamp, bands );
+///     }
+///
+/// The smoother starts from a flat equalizer, and doesn't touch the player
+/// until a target is set. The last applied settings are left in place upon
+/// destruction.
+///
+class EqualizerSmoother
+{
+public:
+    struct Config
+    {
+        Config()
+            : duration( 200 )
+            , interval( 40 )
+        {
+        }
+
+        /// The duration of a transition to new settings. Zero makes each
+        /// target apply at once, still no more often than interval.
+        std::chrono::milliseconds duration;
+        /// The minimum delay between two updates of the player
+        std::chrono::milliseconds interval;
+    };
+
+    /**
+     * \throw std::runtime_error when the equalizer creation fails
+     */
+    explicit EqualizerSmoother( MediaPlayer player, Config config = Config() )
+        : m_player( std::move( player ) )
+        , m_config( std::move( config ) )
+        , m_stop( false )
+        , m_pending( false )
+        , m_fromPreamp( 0.f )
+        , m_toPreamp( 0.f )
+        , m_preamp( 0.f )
+        , m_from( Equalizer::bandCount(), 0.f )
+        , m_to( m_from )
+        , m_bands( m_from )
+    {
+        m_thread = std::thread( &EqualizerSmoother::run, this );
+    }
+
+    ~EqualizerSmoother()
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        m_thread.join();
+    }
+
+    EqualizerSmoother( const EqualizerSmoother& ) = delete;
+    EqualizerSmoother& operator=( const EqualizerSmoother& ) = delete;
+
+    /**
+     * Starts a transition from the settings applied last to new ones. This
+     * can be called repeatedly: only the latest target is kept.
+     *
+     * \param preamp The pre-amplification value
+     * \param amps   The amplification values, the first one being for band 0.
+     *               The missing bands are set to 0.
+     * \param count  The number of values
+     */
+    void setTarget( float preamp, const float* amps, size_t count )
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            auto n = std::min( count, m_to.size() );
+            std::copy( amps, amps + n, begin( m_to ) );
+            std::fill( begin( m_to ) + n, end( m_to ), 0.f );
+            m_toPreamp = preamp;
+            m_fromPreamp = m_preamp;
+            m_from = m_bands;
+            m_start = std::chrono::steady_clock::now();
+            m_pending = true;
+        }
+        m_cond.notify_all();
+    }
+
+    /**
+     * Same as setTarget( float, const float*, size_t ), for any contiguous
+     * container of floats, such as a std::vector, a std::array or a std::span
+     */
+    template <typename Container>
+    void setTarget( float preamp, const Container& amps )
+    {
+        setTarget( preamp, amps.data(), amps.size() );
+    }
+
+    /**
+     * Starts a transition to the settings of an equalizer
+     */
+    void setTarget( Equalizer eq )
+    {
+        auto amps = eq.bands();
+        setTarget( eq.preamp(), amps );
+    }
+
+    /**
+     * Starts a transition to a preset, from the cached preset table
+     *
+     * \return false if there is no such preset
+     */
+    bool setPreset( unsigned int index )
+    {
+        const auto& table = Equalizer::presets();
+        if ( index >= table.presets.size() )
+            return false;
+        const auto& p = table.presets[index];
+        setTarget( p.preamp, p.amps );
+        return true;
+    }
+
+    /// Returns whether a transition is still being applied
+    bool isTransitioning() const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return m_pending;
+    }
+
+private:
+    void run()
+    {
+        auto nextApply = std::chrono::steady_clock::now();
+        std::vector<float> bands;
+        std::unique_lock<std::mutex> lock( m_mutex );
+        for ( ;; )
+        {
+            m_cond.wait( lock, [this]() { return m_stop == true || m_pending == true; } );
+            if ( m_stop == true )
+                return;
+            // Leave an interval between two updates, and get past the start of
+            // a transition, where the settings barely changed
+            auto due = std::max( nextApply, m_start + std::min( m_config.interval, m_config.duration ) );
+            if ( m_cond.wait_until( lock, due, [this]() { return m_stop == true; } ) == true )
+                return;
+            if ( m_pending == false )
+                continue;
+            auto now = std::chrono::steady_clock::now();
+            auto t = 1.f;
+            if ( m_config.duration.count() > 0 )
+            {
+                auto elapsed = std::chrono::duration<float>( now - m_start ).count();
+                auto duration = std::chrono::duration<float>( m_config.duration ).count();
+                t = std::min( elapsed / duration, 1.f );
+            }
+            if ( t >= 1.f )
+                m_pending = false;
+            m_preamp = m_fromPreamp + ( m_toPreamp - m_fromPreamp ) * t;
+            for ( auto i = 0u; i < m_bands.size(); ++i )
+                m_bands[i] = m_from[i] + ( m_to[i] - m_from[i] ) * t;
+            auto preamp = m_preamp;
+            bands = m_bands;
+            lock.unlock();
+            // A single update of the player, with all the bands set at once
+            m_equalizer.setPreamp( preamp );
+            m_equalizer.setBands( bands );
+            m_player.setEqualizer( m_equalizer );
+            nextApply = now + m_config.interval;
+            lock.lock();
+        }
+    }
+
+private:
+    MediaPlayer m_player;
+    // Only used by the smoother thread
+    Equalizer m_equalizer;
+    const Config m_config;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_stop;
+    bool m_pending;
+    std::chrono::steady_clock::time_point m_start;
+    float m_fromPreamp;
+    float m_toPreamp;
+    // The settings applied last
+    float m_preamp;
+    std::vector<float> m_from;
+    std::vector<float> m_to;
+    std::vector<float> m_bands;
+    std::thread m_thread;
+};
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_EQUALIZERSMOOTHER_H
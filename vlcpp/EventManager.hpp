@@ -26,13 +26,17 @@
 #include <string>
 
 #include "common.hpp"
+#include "EventQueue.hpp"
 #include "Internal.hpp"
 #include "Media.hpp"
 
 #include <algorithm>
+#include <deque>
 #include <functional>
-#include <vector>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
 
 #define EXPECT_SIGNATURE(sig) static_assert(signature_match<decltype(f), sig>::value, "Expected a function with prototype " #sig)
 
@@ -57,6 +61,12 @@ private:
     struct EventHandlerBase
     {
         using Wrapper = std::add_pointer<void(const libvlc_event_t*, void*)>::type;
+        EventHandlerBase()
+            : m_generation( 0 )
+            , m_minInterval( 0 )
+            , m_nextDelivery( 0 )
+        {
+        }
         virtual ~EventHandlerBase() = default;
         /**
          * @brief unregister Unregister this event handler.
@@ -64,6 +74,43 @@ private:
          * Calling this method makes the instance invalid.
          */
         virtual void unregister() = 0;
+        /// Returns true if this handler lives in the provided dispatch table
+        virtual bool isOwnedBy(const void*) const { return false; }
+
+        /// A per EventManager unique identifier for this registration
+        uint32_t generation() const { return m_generation; }
+
+        void setMinInterval(std::chrono::steady_clock::duration interval)
+        {
+            m_minInterval.store( interval.count(), std::memory_order_relaxed );
+            m_nextDelivery.store( 0, std::memory_order_relaxed );
+        }
+
+        // Returns true if this event must be dropped because of the rate limit.
+        // Otherwise, the event is accounted for, and must be delivered.
+        bool isThrottled()
+        {
+            auto interval = m_minInterval.load( std::memory_order_relaxed );
+            if ( interval == 0 )
+                return false;
+            auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+            auto next = m_nextDelivery.load( std::memory_order_relaxed );
+            if ( now < next )
+                return true;
+            return m_nextDelivery.compare_exchange_strong( next, now + interval,
+                                                           std::memory_order_relaxed ) == false;
+        }
+
+        // The time from which the next event will be delivered
+        std::chrono::steady_clock::time_point nextDelivery() const
+        {
+            return std::chrono::steady_clock::time_point( std::chrono::steady_clock::duration(
+                        m_nextDelivery.load( std::memory_order_relaxed ) ) );
+        }
+
+        uint32_t m_generation;
+        std::atomic<std::chrono::steady_clock::rep> m_minInterval;
+        std::atomic<std::chrono::steady_clock::rep> m_nextDelivery;
     };
 
     template <typename Func>
@@ -84,7 +131,7 @@ private:
         {
             static_assert(std::is_same<typename std::decay<Func>::type,
                                         typename std::decay<FuncTpl>::type>::value, "");
-            if (libvlc_event_attach( *m_eventManager, m_eventType, m_wrapper, &m_userCallback ) != 0)
+            if (libvlc_event_attach( *m_eventManager, m_eventType, &EventHandler::dispatch, this ) != 0)
                 throw std::bad_alloc();
         }
 
@@ -92,7 +139,7 @@ private:
         {
             // We unregister only when the object actually goes out of scope, IE. when it is
             // removed from EventManager's event handler vector
-            libvlc_event_detach( *m_eventManager, m_eventType, m_wrapper, &m_userCallback );
+            libvlc_event_detach( *m_eventManager, m_eventType, &EventHandler::dispatch, this );
         }
 
         virtual void unregister() override
@@ -103,6 +150,19 @@ private:
         EventHandler(const EventHandler&) = delete;
         EventHandler& operator=( const EventHandler& ) = delete;
 
+    private:
+        static void dispatch(const libvlc_event_t* event, void* data)
+        {
+            auto self = static_cast<EventHandler*>( data );
+            if ( self->isThrottled() == false )
+            {
+#ifdef LIBVLCPP_INSTRUMENT_CALLBACKS
+                instrumentation::ScopedTimer timer( instrumentation::detail::eventSite( event->type ) );
+#endif
+                self->m_wrapper( event, &self->m_userCallback );
+            }
+        }
+
     private:
         // Deduced type is Func& in case of lvalue; Func in case of rvalue.
         // We decay the type to ensure we either copy or take ownership.
@@ -114,34 +174,653 @@ private:
         libvlc_event_e m_eventType;
     };
 
+    class DispatchTable;
+    class TableSlot;
+
+    // All the handlers registered for an event type, in DispatchMode::Table
+    struct DispatchBucket
+    {
+        DispatchBucket(DispatchTable* t, libvlc_event_e type, bool async)
+            : table( t )
+            , eventType( type )
+            , async( async )
+            , coalesce( async && ( type == libvlc_MediaPlayerTimeChanged ||
+                                   type == libvlc_MediaPlayerPositionChanged ) )
+            , queued( false )
+        {
+        }
+        DispatchTable* table;
+        libvlc_event_e eventType;
+        std::vector<TableSlot*> handlers;
+        // Only used when delivering through an EventQueue
+        const bool async;
+        const bool coalesce;
+        // The latest payload of a coalesced event, and whether it's already queued
+        std::mutex latestLock;
+        libvlc_event_t latest;
+        bool queued;
+    };
+
+    // A registration in DispatchMode::Table. The user callback is stored
+    // inline when it is small enough, which is the case of most lambdas.
+    // Slots are recycled, but never freed before their DispatchTable.
+    class TableSlot : public EventHandlerBase
+    {
+    public:
+        TableSlot()
+            : m_callable( nullptr )
+            , m_destroy( nullptr )
+            , m_wrapper( nullptr )
+            , m_bucket( nullptr )
+            , m_index( 0 )
+            , m_active( false )
+            , m_hasTrailing( false )
+        {
+        }
+
+        ~TableSlot()
+        {
+            reset();
+        }
+
+        TableSlot(const TableSlot&) = delete;
+        TableSlot& operator=(const TableSlot&) = delete;
+
+        template <typename Func>
+        void emplace(Func&& f, Wrapper wrapper)
+        {
+            using T = typename std::decay<Func>::type;
+            emplace<T>( std::forward<Func>( f ),
+                        std::integral_constant<bool, sizeof(T) <= sizeof(InlineStorage) &&
+                            std::alignment_of<T>::value <= std::alignment_of<InlineStorage>::value>{} );
+            m_wrapper = wrapper;
+        }
+
+        virtual void unregister() override;
+
+        virtual bool isOwnedBy(const void* owner) const override
+        {
+            return m_bucket != nullptr && m_bucket->table == owner;
+        }
+
+    private:
+        using InlineStorage = typename std::aligned_storage<6 * sizeof(void*)>::type;
+
+        template <typename T, typename Func>
+        void emplace(Func&& f, std::true_type)
+        {
+            m_callable = new (&m_storage) T( std::forward<Func>( f ) );
+            m_destroy = [](void* p) { static_cast<T*>( p )->~T(); };
+        }
+
+        template <typename T, typename Func>
+        void emplace(Func&& f, std::false_type)
+        {
+            m_callable = new T( std::forward<Func>( f ) );
+            m_destroy = [](void* p) { delete static_cast<T*>( p ); };
+        }
+
+        void reset()
+        {
+            if ( m_destroy != nullptr )
+                m_destroy( m_callable );
+            m_destroy = nullptr;
+            m_callable = nullptr;
+        }
+
+    private:
+        InlineStorage m_storage;
+        void* m_callable;
+        void (*m_destroy)(void*);
+        Wrapper m_wrapper;
+        DispatchBucket* m_bucket;
+        // Position of this slot in its bucket handlers list
+        size_t m_index;
+        bool m_active;
+        // The last event dropped by the rate limit, delivered once the
+        // interval elapsed. Only used when delivering through an EventQueue.
+        libvlc_event_t m_trailing;
+        bool m_hasTrailing;
+
+        friend class DispatchTable;
+    };
+
+    // Attaches to libvlc once per event type, and dispatches the events to a
+    // flat list of handlers.
+    class DispatchTable : public std::enable_shared_from_this<DispatchTable>
+    {
+    public:
+        DispatchTable(libvlc_event_manager_t* em, std::shared_ptr<EventQueue> queue)
+            : m_eventManager( em )
+            , m_queue( std::move( queue ) )
+            , m_dispatchDepth( 0 )
+            , m_shutdown( false )
+        {
+        }
+
+        ~DispatchTable()
+        {
+            shutdown();
+        }
+
+        // Detaches from libvlc and releases all the handlers. Events still
+        // pending in the EventQueue might keep this instance alive, but they
+        // won't be delivered anymore.
+        void shutdown()
+        {
+            if ( m_shutdown == true )
+                return;
+            // Once detached, libvlc guarantees no callback is running anymore.
+            // Don't hold the lock while detaching, as a dispatch might be waiting for it.
+            for ( auto& b : m_buckets )
+                libvlc_event_detach( m_eventManager, b->eventType, &DispatchTable::dispatch, b.get() );
+            std::lock_guard<std::recursive_mutex> lock( m_mutex );
+            m_shutdown = true;
+            if ( m_dispatchDepth == 0 )
+                releaseAll();
+        }
+
+        DispatchTable(const DispatchTable&) = delete;
+        DispatchTable& operator=(const DispatchTable&) = delete;
+
+        template <typename Func>
+        TableSlot* add(libvlc_event_e eventType, Func&& f, EventHandlerBase::Wrapper wrapper, uint32_t generation)
+        {
+            // Don't hold the dispatch lock while calling into libvlc, as libvlc
+            // holds its own lock while dispatching.
+            auto bucket = attach( eventType );
+            std::lock_guard<std::recursive_mutex> lock( m_mutex );
+            TableSlot* slot;
+            if ( m_freeSlots.empty() == false )
+            {
+                slot = m_freeSlots.back();
+                m_freeSlots.pop_back();
+            }
+            else
+            {
+                m_slots.emplace_back();
+                slot = &m_slots.back();
+            }
+            slot->emplace( std::forward<Func>( f ), wrapper );
+            slot->m_generation = generation;
+            slot->setMinInterval( std::chrono::steady_clock::duration::zero() );
+            slot->m_bucket = bucket;
+            slot->m_index = bucket->handlers.size();
+            slot->m_active = true;
+            slot->m_hasTrailing = false;
+            bucket->handlers.push_back( slot );
+            return slot;
+        }
+
+        void remove(TableSlot* slot)
+        {
+            std::lock_guard<std::recursive_mutex> lock( m_mutex );
+            if ( slot->m_active == false )
+                return;
+            slot->m_active = false;
+            // The handler might be unregistering itself: release it once
+            // we're done dispatching
+            if ( m_dispatchDepth > 0 )
+                m_pendingRemovals.push_back( slot );
+            else
+                release( slot );
+        }
+
+        bool isRegistered(const TableSlot* slot, uint32_t generation) const
+        {
+            return slot->m_active == true && slot->m_generation == generation;
+        }
+
+        size_t nbRegistered()
+        {
+            std::lock_guard<std::recursive_mutex> lock( m_mutex );
+            return static_cast<size_t>( std::count_if( begin( m_slots ), end( m_slots ), []( const TableSlot& s ) {
+                return s.m_active;
+            }));
+        }
+
+        static void dispatch(const libvlc_event_t* event, void* data)
+        {
+            auto bucket = static_cast<DispatchBucket*>( data );
+            if ( bucket->async == true )
+                bucket->table->enqueue( bucket, *event );
+            else
+                bucket->table->deliver( bucket, *event );
+        }
+
+    private:
+        void deliver(DispatchBucket* bucket, const libvlc_event_t& event)
+        {
+            std::lock_guard<std::recursive_mutex> lock( m_mutex );
+            if ( m_shutdown == true )
+                return;
+            ++m_dispatchDepth;
+            // Handlers removed while dispatching are only deactivated, so indexes
+            // are stable, and handlers added meanwhile will get the next events.
+            auto nbHandlers = bucket->handlers.size();
+            for ( size_t i = 0; i < nbHandlers; ++i )
+            {
+                auto slot = bucket->handlers[i];
+                if ( slot->m_active == false )
+                    continue;
+                if ( slot->isThrottled() == false )
+                {
+                    // This one supersedes the event held back, if any
+                    slot->m_hasTrailing = false;
+                    invoke( slot, event );
+                }
+                else if ( bucket->async == true )
+                    holdBack( slot, event );
+            }
+            endDispatch();
+        }
+
+        void invoke(TableSlot* slot, const libvlc_event_t& event)
+        {
+#ifdef LIBVLCPP_INSTRUMENT_CALLBACKS
+            instrumentation::ScopedTimer timer( instrumentation::detail::eventSite( event.type ) );
+#endif
+            slot->m_wrapper( &event, slot->m_callable );
+        }
+
+        // Keeps the latest event dropped by the rate limit, for the EventQueue
+        // to deliver it once the interval elapsed. This runs on the thread
+        // draining the queue, with the lock held.
+        void holdBack(TableSlot* slot, const libvlc_event_t& event)
+        {
+            slot->m_trailing = event;
+            if ( slot->m_hasTrailing == true )
+                return;
+            slot->m_hasTrailing = true;
+            m_queue->defer( &DispatchTable::deliverTrailing, slot, slot->m_generation,
+                            shared_from_this(), slot->nextDelivery() );
+        }
+
+        // Called from the thread draining the EventQueue
+        static bool deliverTrailing(void* owner, void* target, uint32_t generation)
+        {
+            auto table = static_cast<DispatchTable*>( owner );
+            auto slot = static_cast<TableSlot*>( target );
+            std::lock_guard<std::recursive_mutex> lock( table->m_mutex );
+            if ( table->m_shutdown == true || table->isRegistered( slot, generation ) == false ||
+                 slot->m_hasTrailing == false )
+                return false;
+            slot->m_hasTrailing = false;
+            if ( slot->isThrottled() == true )
+            {
+                // The interval was changed meanwhile
+                table->holdBack( slot, slot->m_trailing );
+                return false;
+            }
+            auto event = slot->m_trailing;
+            ++table->m_dispatchDepth;
+            table->invoke( slot, event );
+            table->endDispatch();
+            return true;
+        }
+
+        void endDispatch()
+        {
+            if ( --m_dispatchDepth == 0 )
+            {
+                if ( m_shutdown == true )
+                    releaseAll();
+                else if ( m_pendingRemovals.empty() == false )
+                {
+                    for ( auto slot : m_pendingRemovals )
+                        release( slot );
+                    m_pendingRemovals.clear();
+                }
+            }
+        }
+
+        // Called from libvlc's thread: this must not wait for the handlers
+        void enqueue(DispatchBucket* bucket, const libvlc_event_t& event)
+        {
+            if ( bucket->coalesce == true )
+            {
+                std::lock_guard<std::mutex> lock( bucket->latestLock );
+                bucket->latest = event;
+                if ( bucket->queued == true )
+                    return;
+                bucket->queued = true;
+            }
+            if ( m_queue->push( event, &DispatchTable::deliverQueued, bucket, shared_from_this() ) == false &&
+                 bucket->coalesce == true )
+            {
+                std::lock_guard<std::mutex> lock( bucket->latestLock );
+                bucket->queued = false;
+            }
+        }
+
+        // Called from the thread draining the EventQueue
+        static void deliverQueued(const libvlc_event_t& event, void* data)
+        {
+            auto bucket = static_cast<DispatchBucket*>( data );
+            if ( bucket->coalesce == false )
+            {
+                bucket->table->deliver( bucket, event );
+                return;
+            }
+            libvlc_event_t latest;
+            {
+                std::lock_guard<std::mutex> lock( bucket->latestLock );
+                latest = bucket->latest;
+                bucket->queued = false;
+            }
+            bucket->table->deliver( bucket, latest );
+        }
+
+        // Events whose payload only holds values can be copied and delivered later
+        static bool isAsyncSafe(libvlc_event_e eventType)
+        {
+            switch ( eventType )
+            {
+                case libvlc_MediaMetaChanged:
+                case libvlc_MediaDurationChanged:
+                case libvlc_MediaParsedChanged:
+                case libvlc_MediaPlayerNothingSpecial:
+                case libvlc_MediaPlayerOpening:
+                case libvlc_MediaPlayerBuffering:
+                case libvlc_MediaPlayerPlaying:
+                case libvlc_MediaPlayerPaused:
+                case libvlc_MediaPlayerStopped:
+                case libvlc_MediaPlayerForward:
+                case libvlc_MediaPlayerBackward:
+                case libvlc_MediaPlayerEncounteredError:
+                case libvlc_MediaPlayerTimeChanged:
+                case libvlc_MediaPlayerPositionChanged:
+                case libvlc_MediaPlayerSeekableChanged:
+                case libvlc_MediaPlayerPausableChanged:
+                case libvlc_MediaPlayerLengthChanged:
+                case libvlc_MediaPlayerVout:
+                case libvlc_MediaListPlayerPlayed:
+                case libvlc_MediaListPlayerStopped:
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+                case libvlc_MediaPlayerStopping:
+                case libvlc_MediaPlayerTitleListChanged:
+#else
+                case libvlc_MediaStateChanged:
+                case libvlc_MediaPlayerEndReached:
+                case libvlc_MediaPlayerTitleChanged:
+                case libvlc_MediaPlayerScrambledChanged:
+                case libvlc_MediaPlayerESAdded:
+                case libvlc_MediaPlayerESDeleted:
+                case libvlc_MediaPlayerESSelected:
+#endif
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
+                case libvlc_MediaPlayerChapterChanged:
+                case libvlc_MediaListEndReached:
+#endif
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(2, 2, 2, 0)
+                case libvlc_MediaPlayerCorked:
+                case libvlc_MediaPlayerUncorked:
+                case libvlc_MediaPlayerMuted:
+                case libvlc_MediaPlayerUnmuted:
+                case libvlc_MediaPlayerAudioVolume:
+#endif
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        void releaseAll()
+        {
+            for ( auto& slot : m_slots )
+            {
+                slot.m_active = false;
+                slot.reset();
+            }
+            for ( auto& b : m_buckets )
+                b->handlers.clear();
+            m_pendingRemovals.clear();
+        }
+
+        DispatchBucket* attach(libvlc_event_e eventType)
+        {
+            for ( auto& b : m_buckets )
+            {
+                if ( b->eventType == eventType )
+                    return b.get();
+            }
+            auto bucket = std::unique_ptr<DispatchBucket>( new DispatchBucket( this, eventType,
+                                m_queue != nullptr && isAsyncSafe( eventType ) ) );
+            if ( libvlc_event_attach( m_eventManager, eventType, &DispatchTable::dispatch, bucket.get() ) != 0 )
+                throw std::bad_alloc();
+            m_buckets.push_back( std::move( bucket ) );
+            return m_buckets.back().get();
+        }
+
+        // Swap-removes the slot from its bucket, and recycles it
+        void release(TableSlot* slot)
+        {
+            auto& handlers = slot->m_bucket->handlers;
+            auto last = handlers.back();
+            handlers[slot->m_index] = last;
+            last->m_index = slot->m_index;
+            handlers.pop_back();
+            slot->reset();
+            m_freeSlots.push_back( slot );
+        }
+
+    private:
+        libvlc_event_manager_t* m_eventManager;
+        std::shared_ptr<EventQueue> m_queue;
+        std::recursive_mutex m_mutex;
+        std::vector<std::unique_ptr<DispatchBucket>> m_buckets;
+        // A deque never moves its elements, so slots have a stable address
+        std::deque<TableSlot> m_slots;
+        std::vector<TableSlot*> m_freeSlots;
+        std::vector<TableSlot*> m_pendingRemovals;
+        unsigned m_dispatchDepth;
+        bool m_shutdown;
+    };
+
+public:
+    using RegisteredEvent = EventHandlerBase*;
+
+    /**
+     * @brief The DispatchMode enum selects how handlers are attached to libvlc
+     */
+    enum class DispatchMode
+    {
+        /// Each registration attaches its own callback to libvlc. This is the default
+        PerHandler,
+        /// A single libvlc callback is attached per event type, and dispatches
+        /// to a flat table of handlers. Registering and unregistering a handler
+        /// doesn't involve libvlc, and unregistering is O(1).
+        Table,
+    };
+
+    /**
+     * @brief The Handle class identifies a registration, and can safely be
+     * used to unregister it even after it was already unregistered.
+     *
+     * It is implicitly constructible from a RegisteredEvent, so that any
+     * onXXX() method result can be stored in a Handle:
+     *
+     *     EventManager::Handle h = em.onTimeChanged( f );
+     *     ...
+     *     em.unregister( h ); // No-op if h was already unregistered
+     */
+    class Handle
+    {
+    public:
+        Handle() : m_event( nullptr ), m_generation( 0 ) {}
+        Handle(RegisteredEvent e)
+            : m_event( e )
+            , m_generation( e != nullptr ? e->generation() : 0 )
+        {
+        }
+
+        RegisteredEvent event() const { return m_event; }
+        uint32_t generation() const { return m_generation; }
+
+    private:
+        RegisteredEvent m_event;
+        uint32_t m_generation;
+    };
+
 private:
     // variadic template recursion termination
     void unregister(){}
 
+    void unregisterOne(const EventHandlerBase* e)
+    {
+        if ( m_table != nullptr && e != nullptr && e->isOwnedBy( m_table.get() ) )
+        {
+            m_table->remove( static_cast<TableSlot*>( const_cast<EventHandlerBase*>( e ) ) );
+            return;
+        }
+        auto it = std::find_if(begin(m_lambdas), end(m_lambdas), [&e](typename decltype(m_lambdas)::value_type &value) {
+            return e == value.get();
+        });
+        if (it != end(m_lambdas))
+            m_lambdas.erase( it );
+    }
+
+    void unregisterOne(const Handle& h)
+    {
+        if ( isRegistered( h ) == true )
+            unregisterOne( h.event() );
+    }
+
 public:
     template <typename T, typename... Args>
     void unregister(const T e, const Args... args)
     {
-        static_assert(std::is_convertible<decltype(e), const EventHandlerBase*>::value, "Expected const RegisteredEvent");
-
-        {
-            auto it = std::find_if(begin(m_lambdas), end(m_lambdas), [&e](typename decltype(m_lambdas)::value_type &value) {
-                return e == value.get();
-            });
-            if (it != end(m_lambdas))
-                m_lambdas.erase( it );
-        }
+        static_assert(std::is_convertible<decltype(e), const EventHandlerBase*>::value ||
+                      std::is_same<T, Handle>::value, "Expected const RegisteredEvent");
 
+        unregisterOne( e );
         unregister(args...);
     }
 
+    /**
+     * @brief isRegistered Checks if the registration identified by this handle
+     * is still active on this event manager.
+     */
+    bool isRegistered(const Handle& h) const
+    {
+        if ( h.event() == nullptr )
+            return false;
+        // In table mode, slots are never freed, so we can safely look into it
+        if ( m_table != nullptr && h.event()->isOwnedBy( m_table.get() ) )
+            return m_table->isRegistered( static_cast<const TableSlot*>( h.event() ), h.generation() );
+        auto it = std::find_if(begin(m_lambdas), end(m_lambdas), [&h](const typename decltype(m_lambdas)::value_type &value) {
+            return h.event() == value.get();
+        });
+        return it != end(m_lambdas) && (*it)->generation() == h.generation();
+    }
+
+    /**
+     * @brief nbRegistered Returns the number of registrations active on this
+     * event manager
+     */
+    size_t nbRegistered() const
+    {
+        auto res = m_lambdas.size();
+        if ( m_table != nullptr )
+            res += m_table->nbRegistered();
+        return res;
+    }
+
+    /**
+     * @brief setRateLimit Limits how often a handler gets invoked
+     *
+     * Once set, the handler is invoked at most once every \p interval, and
+     * the events received in between are dropped before reaching the handler.
+     * This is typically useful for high frequency events, such as
+     * onTimeChanged, onPositionChanged or onBuffering:
+     *
+     *     em.setRateLimit( em.onTimeChanged( f ), std::chrono::milliseconds( 250 ) );
+     *
+     * When the handler is delivered through an EventQueue, the limit applies
+     * when the queue is drained, and the last dropped event is delivered by
+     * the first drain once the interval elapsed, so that the handler always
+     * ends up with the latest value.
+     * Otherwise, the events are delivered from libvlc's threads, and can't be
+     * kept for later: the last events of a burst, such as the final
+     * onBuffering( 100 ), can be lost.
+     *
+     * @param h         The registration to limit
+     * @param interval  The minimum interval between two invocations. 0 removes the limit
+     * @return false if the registration isn't active on this event manager
+     */
+    template <typename Rep, typename Period>
+    bool setRateLimit(const Handle& h, std::chrono::duration<Rep, Period> interval)
+    {
+        if ( isRegistered( h ) == false )
+            return false;
+        h.event()->setMinInterval( std::chrono::duration_cast<std::chrono::steady_clock::duration>( interval ) );
+        return true;
+    }
+
+    /**
+     * @brief setDispatchMode Selects how the handlers are attached to libvlc
+     *
+     * This must be called before any handler is registered on this instance.
+     * Copies of this event manager inherit its dispatch mode.
+     *
+     * @throw std::logic_error if some handlers are already registered
+     */
+    void setDispatchMode(DispatchMode mode)
+    {
+        if ( m_lambdas.empty() == false || m_table != nullptr )
+            throw std::logic_error( "Can't change the dispatch mode once handlers were registered" );
+        m_dispatchMode = mode;
+        // Asynchronous delivery relies on the dispatch table
+        if ( mode == DispatchMode::PerHandler )
+            m_queue.reset();
+    }
+
+    DispatchMode dispatchMode() const
+    {
+        return m_dispatchMode;
+    }
+
+    /**
+     * @brief setEventQueue Delivers the events through the provided queue
+     *
+     * The handlers registered afterward will be invoked from the thread
+     * draining the queue, instead of libvlc's threads. See EventQueue for
+     * more details.
+     * This implies DispatchMode::Table, and must be called before any handler
+     * is registered on this instance. Copies of this event manager will use
+     * the same queue.
+     *
+     * @param queue The queue to use, or nullptr to revert to synchronous delivery
+     * @throw std::logic_error if some handlers are already registered
+     */
+    void setEventQueue(std::shared_ptr<EventQueue> queue)
+    {
+        if ( m_lambdas.empty() == false || m_table != nullptr )
+            throw std::logic_error( "Can't change the event queue once handlers were registered" );
+        if ( queue != nullptr )
+            m_dispatchMode = DispatchMode::Table;
+        m_queue = std::move( queue );
+    }
+
+    std::shared_ptr<EventQueue> eventQueue() const
+    {
+        return m_queue;
+    }
+
 protected:
     EventManager(InternalPtr ptr)
         : Internal{ ptr, [](InternalPtr){ /* No-op; EventManager's are handled by their respective objects */ } }
+        , m_dispatchMode( DispatchMode::PerHandler )
+        , m_lastGeneration( 0 )
     {
     }
 
 public:
+    ~EventManager()
+    {
+        unregisterAll();
+    }
+
     /**
      * @brief EventManager Wraps the same EventManager
      *
@@ -152,6 +831,9 @@ public:
      */
     EventManager(const EventManager& em)
         : Internal( em )
+        , m_queue( em.m_queue )
+        , m_dispatchMode( em.m_dispatchMode )
+        , m_lastGeneration( 0 )
     {
         // Don't rely on the default implementation, as we don't want to copy the
         // current list of events.
@@ -181,6 +863,10 @@ public:
     EventManager(EventManager&& em)
         : Internal( std::move( em ) )
         , m_lambdas(std::move( em.m_lambdas ) )
+        , m_table( std::move( em.m_table ) )
+        , m_queue( std::move( em.m_queue ) )
+        , m_dispatchMode( em.m_dispatchMode )
+        , m_lastGeneration( em.m_lastGeneration )
     {
     }
 
@@ -190,11 +876,14 @@ public:
             return *this;
         Internal::operator=( std::move( em ) );
         m_lambdas = std::move( em.m_lambdas );
+        m_table = std::move( em.m_table );
+        m_queue = std::move( em.m_queue );
+        m_dispatchMode = em.m_dispatchMode;
+        m_lastGeneration = em.m_lastGeneration;
+        return *this;
     }
 #endif
 
-    using RegisteredEvent = EventHandlerBase*;
-
 protected:
 
     /**
@@ -210,12 +899,21 @@ protected:
      *                      the registered event handler, this making this reference a dangling reference, which is
      *                      undefined behavior.
      *                      When calling unregister() on this object, the pointer should immediatly be considered invalid.
+     *                      Store it in a Handle to be able to safely unregister it more than once.
      */
     template <typename Func>
     RegisteredEvent handle(libvlc_event_e eventType, Func&& f, EventHandlerBase::Wrapper wrapper)
     {
+        auto generation = ++m_lastGeneration;
+        if ( m_dispatchMode == DispatchMode::Table )
+        {
+            if ( m_table == nullptr )
+                m_table = std::make_shared<DispatchTable>( get(), m_queue );
+            return m_table->add( eventType, std::forward<Func>( f ), wrapper, generation );
+        }
         auto ptr = std::unique_ptr<EventHandlerBase>( new EventHandler<Func>(
                                 *this, eventType, std::forward<Func>( f ), wrapper ) );
+        ptr->m_generation = generation;
         auto raw = ptr.get();
         m_lambdas.push_back( std::move( ptr ) );
         return raw;
@@ -232,12 +930,38 @@ protected:
         });
     }
 
+    /**
+     * @brief unregisterAll Unregisters all the handlers
+     *
+     * Derived classes must call this from their destructor, while the object
+     * emitting the events is still alive.
+     */
+    void unregisterAll()
+    {
+        m_lambdas.clear();
+        // Queued events might still hold a reference on the table, make sure
+        // it doesn't outlive the libvlc event manager.
+        if ( m_table != nullptr )
+            m_table->shutdown();
+        m_table.reset();
+    }
+
 protected:
     // We store the EventHandlerBase's as unique_ptr in order for the function stored within
     // EventHandler<T> not to move to another memory location
     std::vector<std::unique_ptr<EventHandlerBase>> m_lambdas;
+    // Only used in DispatchMode::Table
+    std::shared_ptr<DispatchTable> m_table;
+    std::shared_ptr<EventQueue> m_queue;
+    DispatchMode m_dispatchMode;
+    uint32_t m_lastGeneration;
 };
 
+inline void EventManager::TableSlot::unregister()
+{
+    m_bucket->table->remove( this );
+}
+
 /**
  * @brief The MediaEventManager class allows one to register Media related events
  */
@@ -260,7 +984,7 @@ class MediaEventManager : public EventManager
         ~MediaEventManager()
         {
             // Clear the events as long as the underlying VLC object is alive
-            m_lambdas.clear();
+            unregisterAll();
         }
 
         /**
@@ -433,6 +1157,48 @@ class MediaEventManager : public EventManager
                 (*callback)( pictures );
             });
         }
+
+        /**
+         * \brief onThumbnailGeneratedUnique Same as onThumbnailGenerated, the
+         *        thumbnail being handed over without a shared ownership
+         * \param f A std::function<void(UniquePicture)> (or an equivalent Callable type)
+         *          The provided picture will be invalid if the thumbnail
+         *          generation failed. It can be kept beyond the callback.
+         */
+        template <typename Func>
+        RegisteredEvent onThumbnailGeneratedUnique( Func&& f )
+        {
+            EXPECT_SIGNATURE(void(UniquePicture));
+            return handle(libvlc_MediaThumbnailGenerated, std::forward<Func>( f ), [](const libvlc_event_t* e, void* data)
+            {
+                auto callback = static_cast<DecayPtr<Func>>(data);
+                (*callback)( UniquePicture::retain( e->u.media_thumbnail_generated.p_thumbnail ) );
+            });
+        }
+
+        /**
+         * \brief onAttachedThumbnailsFoundUnique Same as onAttachedThumbnailsFound,
+         *        the pictures being handed over without a shared ownership
+         * \param f A std::function<void(std::vector<UniquePicture>&)> (or an equivalent Callable type)
+         *          The pictures can be moved out of the vector, and kept
+         *          beyond the callback.
+         */
+        template <typename Func>
+        RegisteredEvent onAttachedThumbnailsFoundUnique( Func&& f )
+        {
+            EXPECT_SIGNATURE(void( std::vector<UniquePicture>& ) );
+            return handle(libvlc_MediaAttachedThumbnailsFound, std::forward<Func>( f ),
+                          []( const libvlc_event_t* e, void* data ) {
+                auto callback = static_cast<DecayPtr<Func>>(data);
+                std::vector<UniquePicture> pictures;
+                auto picList = e->u.media_attached_thumbnails_found.thumbnails;
+                auto nbPictures = libvlc_picture_list_count( picList );
+                pictures.reserve( nbPictures );
+                for ( auto i = 0u; i < nbPictures; ++i )
+                    pictures.push_back( UniquePicture::retain( libvlc_picture_list_at( picList, i ) ) );
+                (*callback)( pictures );
+            });
+        }
 #endif
 
 };
@@ -452,7 +1218,7 @@ class MediaPlayerEventManager : public EventManager
         }
         ~MediaPlayerEventManager()
         {
-            m_lambdas.clear();
+            unregisterAll();
         }
 
         /**
@@ -992,7 +1758,7 @@ class MediaListEventManager : public EventManager
         }
         ~MediaListEventManager()
         {
-            m_lambdas.clear();
+            unregisterAll();
         }
 
         /**
@@ -1071,6 +1837,40 @@ class MediaListEventManager : public EventManager
             });
         }
 
+        /**
+         * \brief onItemAddedUnique Same as onItemAdded, the media being handed
+         *        over without a shared ownership
+         * \param f A std::function<void(UniqueMedia, int)> (or an equivalent Callable type)
+         */
+        template <typename Func>
+        RegisteredEvent onItemAddedUnique( Func&& f )
+        {
+            EXPECT_SIGNATURE(void(UniqueMedia, int));
+            return handle(libvlc_MediaListItemAdded, std::forward<Func>( f ), [](const libvlc_event_t* e, void* data)
+            {
+                auto callback = static_cast<DecayPtr<Func>>( data );
+                (*callback)( UniqueMedia::retain( e->u.media_list_item_added.item ),
+                             e->u.media_list_item_added.index );
+            });
+        }
+
+        /**
+         * \brief onItemDeletedUnique Same as onItemDeleted, the media being
+         *        handed over without a shared ownership
+         * \param f A std::function<void(UniqueMedia, int)> (or an equivalent Callable type)
+         */
+        template <typename Func>
+        RegisteredEvent onItemDeletedUnique( Func&& f )
+        {
+            EXPECT_SIGNATURE(void(UniqueMedia, int));
+            return handle(libvlc_MediaListItemDeleted, std::forward<Func>( f ), [](const libvlc_event_t* e, void* data)
+            {
+                auto callback = static_cast<DecayPtr<Func>>( data );
+                (*callback)( UniqueMedia::retain( e->u.media_list_item_deleted.item ),
+                             e->u.media_list_item_deleted.index );
+            });
+        }
+
 #if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
         template <typename Func>
         RegisteredEvent onEndReached( Func&& f )
@@ -1096,7 +1896,7 @@ class MediaListPlayerEventManager : public EventManager
         }
         ~MediaListPlayerEventManager()
         {
-            m_lambdas.clear();
+            unregisterAll();
         }
 
         template <typename Func>
@@ -1173,7 +1973,7 @@ public:
     }
     ~RendererDiscovererEventManager()
     {
-        m_lambdas.clear();
+        unregisterAll();
     }
 
     template <typename Func>
@@ -0,0 +1,293 @@
+/*****************************************************************************
+ * EventQueue.hpp: Asynchronous event delivery queue
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_EVENTQUEUE_H
+#define LIBVLC_CXX_EVENTQUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "common.hpp"
+
+namespace VLC
+{
+
+class EventManager;
+
+///
+/// \brief The EventQueue class moves event handlers off libvlc's threads.
+///
+/// When an event manager is bound to a queue (see EventManager::setEventQueue)
+/// the events are copied into this bounded, preallocated, lock-free queue
+/// from libvlc's thread, and the handlers are invoked when the application
+/// drains the queue, from its own thread:
+///
+///     auto queue = std::make_shared<VLC::EventQueue>( 1024 );
+///     auto& em = mp.eventManager();
+///     em.setEventQueue( queue );
+///     em.onTimeChanged( [](libvlc_time_t t) { updateUI( t ); } );
+///     // UI thread
+///     queue->waitAndDrain( std::chrono::milliseconds( 16 ) );
+///
+/// Any number of event managers can share the same queue, but it must only
+/// be drained from a single thread at a time.
+///
+/// Pending TimeChanged and PositionChanged events are coalesced: only the
+/// latest value is delivered. Events whose payload references memory owned
+/// by libvlc (medias, strings, pictures...) can't outlive the libvlc callback,
+/// and are still delivered synchronously.
+///
+/// When the queue is full, new events are dropped, and accounted for in
+/// nbDropped(). The capacity should be sized for the expected event rate.
+///
+/// The last event dropped by a rate limited handler (see
+/// EventManager::setRateLimit) is delivered by the first drain once the
+/// handler's interval has elapsed. waitAndDrain wakes up for it.
+///
+class EventQueue
+{
+public:
+    /**
+     * \param capacity  The maximum number of pending events. It is rounded
+     *                  up to the next power of two.
+     */
+    explicit EventQueue( size_t capacity = 1024 )
+        : m_mask( roundUp( capacity ) - 1 )
+        , m_cells( new Cell[m_mask + 1] )
+        , m_enqueuePos( 0 )
+        , m_dequeuePos( 0 )
+        , m_nbDropped( 0 )
+        , m_wakeUp( false )
+    {
+        for ( size_t i = 0; i <= m_mask; ++i )
+            m_cells[i].sequence.store( i, std::memory_order_relaxed );
+    }
+
+    EventQueue( const EventQueue& ) = delete;
+    EventQueue& operator=( const EventQueue& ) = delete;
+
+    /**
+     * Invokes the handlers for up to \p maxEvents pending events.
+     *
+     * \return The number of delivered events
+     */
+    size_t drain( size_t maxEvents = std::numeric_limits<size_t>::max() )
+    {
+        size_t nbEvents = 0;
+        libvlc_event_t event;
+        Deliver deliver;
+        void* target;
+        std::shared_ptr<void> owner;
+        while ( nbEvents < maxEvents && pop( event, deliver, target, owner ) == true )
+        {
+            deliver( event, target );
+            owner.reset();
+            ++nbEvents;
+        }
+        if ( nbEvents < maxEvents && m_deferred.empty() == false )
+            nbEvents += drainDeferred( maxEvents - nbEvents );
+        return nbEvents;
+    }
+
+    /**
+     * Waits up to \p timeout for some events to be queued, and drains them.
+     *
+     * \return The number of delivered events, which can be 0 if the wait
+     *         timed out, or if wakeUp() was called.
+     */
+    template <typename Rep, typename Period>
+    size_t waitAndDrain( std::chrono::duration<Rep, Period> timeout,
+                         size_t maxEvents = std::numeric_limits<size_t>::max() )
+    {
+        auto nbEvents = drain( maxEvents );
+        if ( nbEvents != 0 )
+            return nbEvents;
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        for ( const auto& d : m_deferred )
+            deadline = std::min( deadline, d.due );
+        m_parker.waitUntil( [this]() {
+            return empty() == false || m_wakeUp.exchange( false ) == true;
+        }, deadline );
+        return drain( maxEvents );
+    }
+
+    /// Interrupts a pending waitAndDrain call
+    void wakeUp()
+    {
+        m_wakeUp.store( true );
+        m_parker.notify();
+    }
+
+    /// Returns true if no event is pending
+    bool empty() const
+    {
+        auto pos = m_dequeuePos.load( std::memory_order_relaxed );
+        auto seq = m_cells[pos & m_mask].sequence.load( std::memory_order_acquire );
+        return seq != pos + 1;
+    }
+
+    size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+    /// Number of events that were discarded because the queue was full
+    uint64_t nbDropped() const
+    {
+        return m_nbDropped.load( std::memory_order_relaxed );
+    }
+
+private:
+    using Deliver = void(*)( const libvlc_event_t&, void* );
+    // Returns false if the event wasn't delivered
+    using DeliverDeferred = bool(*)( void* owner, void* target, uint32_t generation );
+
+    // An event held back until a given time, see defer()
+    struct Deferred
+    {
+        DeliverDeferred deliver;
+        void* target;
+        uint32_t generation;
+        std::shared_ptr<void> owner;
+        std::chrono::steady_clock::time_point due;
+    };
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        libvlc_event_t event;
+        Deliver deliver;
+        void* target;
+        // Keeps the target alive until the event is delivered
+        std::shared_ptr<void> owner;
+    };
+
+    static size_t roundUp( size_t capacity )
+    {
+        size_t res = 2;
+        while ( res < capacity )
+            res <<= 1;
+        return res;
+    }
+
+    // Called from libvlc's threads. This is a bounded MPMC queue, as described
+    // by Dmitry Vyukov, where each cell sequence tells which lap it belongs to.
+    bool push( const libvlc_event_t& event, Deliver deliver, void* target,
+               std::shared_ptr<void> owner )
+    {
+        auto pos = m_enqueuePos.load( std::memory_order_relaxed );
+        Cell* cell;
+        for ( ;; )
+        {
+            cell = &m_cells[pos & m_mask];
+            auto seq = cell->sequence.load( std::memory_order_acquire );
+            auto diff = static_cast<intptr_t>( seq ) - static_cast<intptr_t>( pos );
+            if ( diff == 0 )
+            {
+                if ( m_enqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) == true )
+                    break;
+            }
+            else if ( diff < 0 )
+            {
+                m_nbDropped.fetch_add( 1, std::memory_order_relaxed );
+                return false;
+            }
+            else
+                pos = m_enqueuePos.load( std::memory_order_relaxed );
+        }
+        cell->event = event;
+        cell->deliver = deliver;
+        cell->target = target;
+        cell->owner = std::move( owner );
+        cell->sequence.store( pos + 1, std::memory_order_release );
+        m_parker.notify();
+        return true;
+    }
+
+    // Only called from the thread draining the queue, hence no
+    // synchronization. The event itself is kept by the caller.
+    void defer( DeliverDeferred deliver, void* target, uint32_t generation,
+                std::shared_ptr<void> owner, std::chrono::steady_clock::time_point due )
+    {
+        m_deferred.push_back( Deferred{ deliver, target, generation, std::move( owner ), due } );
+    }
+
+    size_t drainDeferred( size_t maxEvents )
+    {
+        // The handlers might defer some events again
+        std::vector<Deferred> deferred;
+        deferred.swap( m_deferred );
+        auto now = std::chrono::steady_clock::now();
+        size_t nbEvents = 0;
+        for ( auto& d : deferred )
+        {
+            if ( d.due <= now && nbEvents < maxEvents )
+            {
+                if ( d.deliver( d.owner.get(), d.target, d.generation ) == true )
+                    ++nbEvents;
+            }
+            else
+                m_deferred.push_back( std::move( d ) );
+        }
+        return nbEvents;
+    }
+
+    bool pop( libvlc_event_t& event, Deliver& deliver, void*& target, std::shared_ptr<void>& owner )
+    {
+        auto pos = m_dequeuePos.load( std::memory_order_relaxed );
+        auto cell = &m_cells[pos & m_mask];
+        auto seq = cell->sequence.load( std::memory_order_acquire );
+        if ( seq != pos + 1 )
+            return false;
+        // Single consumer: no need to compete for the cell
+        m_dequeuePos.store( pos + 1, std::memory_order_relaxed );
+        event = cell->event;
+        deliver = cell->deliver;
+        target = cell->target;
+        owner = std::move( cell->owner );
+        cell->sequence.store( pos + m_mask + 1, std::memory_order_release );
+        return true;
+    }
+
+private:
+    static const size_t CacheLineSize = 64;
+
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    char m_padding0[CacheLineSize];
+    std::atomic<size_t> m_enqueuePos;
+    char m_padding1[CacheLineSize];
+    std::atomic<size_t> m_dequeuePos;
+    char m_padding2[CacheLineSize];
+    std::atomic<uint64_t> m_nbDropped;
+    std::atomic<bool> m_wakeUp;
+    detail::ThreadParker m_parker;
+    std::vector<Deferred> m_deferred;
+
+    friend class EventManager;
+};
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_EVENTQUEUE_H
@@ -0,0 +1,449 @@
+/*****************************************************************************
+ * GaplessListPlayer.hpp: Media list player with gapless transitions
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_GAPLESSLISTPLAYER_H
+#define LIBVLC_CXX_GAPLESSLISTPLAYER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "common.hpp"
+#include "Instance.hpp"
+#include "Media.hpp"
+#include "MediaList.hpp"
+#include "MediaPlayer.hpp"
+
+namespace VLC
+{
+
+///
+/// \brief The GaplessListPlayer class plays a MediaList without any gap
+/// between its items.
+///
+/// MediaListPlayer only opens the next item once the current one ended, so
+/// each transition pays for the demuxer & decoders setup, and buffering.
+/// This player alternates between two media players, configured the same
+/// way by the setup function. Shortly before the end of the current item,
+/// the next one is opened on the idle player and paused on its first frame;
+/// at the end of the stream, it's resumed and becomes the active player:
+///
+///     VLC::GaplessListPlayer player( instance, list,
+///         [&player]( VLC::MediaPlayer& mp, unsigned index ) {
+///             mp.setVideoFramePool( pool, [&player, index]( VLC::VideoFrame f ) {
+///                 if ( player.isActive( index ) == true )
+///                     render( std::move( f ) );
+///             });
+///         });
+///     player.play();
+///
+/// Both players decode into the outputs the setup function binds. While an
+/// item is prerolled, its first frame is decoded before the current item
+/// ended: the outputs shared by the two players should drop the frames of
+/// the inactive one, as above, or the application should use outputs that
+/// are only shown for the active player.
+///
+/// All the controls are asynchronous: they are processed, along with the
+/// players events, from a thread of its own.
+///
+class GaplessListPlayer
+{
+public:
+    /// Configures one of the two players, identified by \p index
+    using Setup = std::function<void(MediaPlayer& player, unsigned index)>;
+    /// Invoked when an item starts playing, or with -1 when the playback
+    /// stops. It's invoked from the player thread.
+    using ItemChanged = std::function<void(int item)>;
+
+    struct Config
+    {
+        Config()
+            : prerollTime( 5000 )
+            , loop( false )
+        {
+        }
+
+        /// How long before the end of the current item the next one is
+        /// opened, in ms. Items of unknown length are never prerolled.
+        libvlc_time_t prerollTime;
+        /// Restart from the first item after the last one
+        bool loop;
+    };
+
+    /**
+     * \param instance The instance to create the players from
+     * \param list     The items to play
+     * \param setup    Configures both players, with the same outputs,
+     *                 callbacks or options
+     */
+    GaplessListPlayer( const Instance& instance, MediaList list, Setup setup = nullptr,
+                       Config config = Config() )
+        : m_list( std::move( list ) )
+        , m_config( std::move( config ) )
+        , m_closed( false )
+        , m_active( 0 )
+        , m_current( -1 )
+        , m_prerolled( -1 )
+        , m_prerollQueued( false )
+        , m_players{ MediaPlayer( instance ), MediaPlayer( instance ) }
+    {
+        for ( unsigned i = 0; i < 2; ++i )
+        {
+            m_gen[i].store( 0, std::memory_order_relaxed );
+            if ( setup != nullptr )
+                setup( m_players[i], i );
+            auto& em = m_players[i].eventManager();
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+            em.onStopping( [this, i]() { post( Command::Ended, i ); } );
+#else
+            em.onEndReached( [this, i]() { post( Command::Ended, i ); } );
+#endif
+            em.onEncounteredError( [this, i]() { post( Command::Ended, i ); } );
+            em.onTimeChanged( [this, i]( libvlc_time_t t ) { onTimeChanged( i, t ); } );
+        }
+        m_thread = std::thread( &GaplessListPlayer::run, this );
+    }
+
+    ~GaplessListPlayer()
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_closed = true;
+        }
+        m_cond.notify_all();
+        m_thread.join();
+        // The events raised while the players are released are discarded
+        for ( auto& p : m_players )
+            stopPlayer( p );
+    }
+
+    GaplessListPlayer( const GaplessListPlayer& ) = delete;
+    GaplessListPlayer& operator=( const GaplessListPlayer& ) = delete;
+
+    /// Plays the first item, or resumes the current one
+    void play()
+    {
+        post( Command::Play, 0 );
+    }
+
+    /// Plays the item at \p index. An invalid index stops the playback.
+    void playItemAtIndex( int index )
+    {
+        post( Command::PlayItem, 0, index );
+    }
+
+    void next()
+    {
+        post( Command::Next, 0 );
+    }
+
+    void previous()
+    {
+        post( Command::Previous, 0 );
+    }
+
+    void pause()
+    {
+        post( Command::Pause, 0 );
+    }
+
+    void stop()
+    {
+        post( Command::PlayItem, 0, -1 );
+    }
+
+    /**
+     * Sets the ItemChanged callback. It must be set before starting the
+     * playback.
+     */
+    void setItemChangedCallback( ItemChanged cb )
+    {
+        m_itemChanged = std::move( cb );
+    }
+
+    /// The index of the item being played, or -1 if stopped
+    int currentItem() const
+    {
+        return m_current.load( std::memory_order_acquire );
+    }
+
+    /// Returns true if the player \p index is the one being played. It's
+    /// meant to be called from the outputs bound by the setup function.
+    bool isActive( unsigned index ) const
+    {
+        return m_active.load( std::memory_order_acquire ) == index;
+    }
+
+    /// The player of the current item. It changes on each transition.
+    MediaPlayer& activePlayer()
+    {
+        return m_players[m_active.load( std::memory_order_acquire )];
+    }
+
+    MediaPlayer& player( unsigned index )
+    {
+        return m_players[index];
+    }
+
+private:
+    struct Command
+    {
+        enum Type
+        {
+            Play,
+            PlayItem,
+            Next,
+            Previous,
+            Pause,
+            Preroll,
+            // The end of the stream, or an error, on a player
+            Ended,
+        };
+        Type type;
+        unsigned player;
+        // The player media generation when the event was raised
+        uint64_t gen;
+        int item;
+    };
+
+    void post( Command::Type type, unsigned player, int item = -1 )
+    {
+        Command cmd{ type, player, m_gen[player].load( std::memory_order_acquire ), item };
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            if ( m_closed == true )
+                return;
+            m_commands.push_back( cmd );
+        }
+        m_cond.notify_one();
+    }
+
+    // Invoked from the libvlc thread, so only checks whether the next item
+    // is due, and leaves the preroll to the player thread
+    void onTimeChanged( unsigned index, libvlc_time_t t )
+    {
+        if ( isActive( index ) == false ||
+             m_prerollQueued.load( std::memory_order_relaxed ) == true )
+            return;
+        auto length = m_players[index].length();
+        if ( length <= 0 || length - t > m_config.prerollTime )
+            return;
+        if ( m_prerollQueued.exchange( true ) == false )
+            post( Command::Preroll, index );
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        for ( ;; )
+        {
+            m_cond.wait( lock, [this]() {
+                return m_closed == true || m_commands.empty() == false;
+            });
+            if ( m_closed == true )
+                return;
+            auto cmd = m_commands.front();
+            m_commands.pop_front();
+            lock.unlock();
+            process( cmd );
+            lock.lock();
+        }
+    }
+
+    void process( const Command& cmd )
+    {
+        auto current = m_current.load( std::memory_order_relaxed );
+        switch ( cmd.type )
+        {
+            case Command::Play:
+                if ( current < 0 )
+                    startItem( 0 );
+                else
+                    m_players[m_active].setPause( false );
+                break;
+            case Command::PlayItem:
+                startItem( cmd.item );
+                break;
+            case Command::Next:
+                startItem( nextItem( current ) );
+                break;
+            case Command::Previous:
+                startItem( previousItem( current ) );
+                break;
+            case Command::Pause:
+                if ( current >= 0 )
+                    m_players[m_active].setPause( true );
+                break;
+            case Command::Preroll:
+                if ( cmd.player == m_active && cmd.gen == m_gen[cmd.player] )
+                    preroll( nextItem( current ) );
+                break;
+            case Command::Ended:
+                // Discard the events of a media that was since replaced
+                if ( cmd.gen != m_gen[cmd.player] || current < 0 )
+                    break;
+                if ( cmd.player == m_active )
+                    startItem( nextItem( current ) );
+                else
+                    // The next item failed to open, it will be retried when
+                    // it's due
+                    m_prerolled = -1;
+                break;
+        }
+    }
+
+    int nextItem( int item )
+    {
+        MediaList::Lock lock( m_list );
+        auto count = m_list.count();
+        if ( item + 1 < count )
+            return item + 1;
+        return m_config.loop == true && count > 0 ? 0 : -1;
+    }
+
+    int previousItem( int item )
+    {
+        if ( item > 0 )
+            return item - 1;
+        MediaList::Lock lock( m_list );
+        auto count = m_list.count();
+        return m_config.loop == true && count > 0 ? count - 1 : 0;
+    }
+
+    MediaPtr itemAt( int item )
+    {
+        MediaList::Lock lock( m_list );
+        return m_list.itemAtIndex( item );
+    }
+
+    // Starts an item on the idle player, so that the events of the previous
+    // item come from a player that is no longer active
+    void startItem( int item )
+    {
+        auto previous = m_active.load( std::memory_order_relaxed );
+        auto next = 1 - previous;
+        MediaPtr media;
+        if ( item >= 0 && m_prerolled != item )
+            media = itemAt( item );
+        if ( media == nullptr && m_prerolled != item )
+            item = -1;
+        if ( item < 0 )
+        {
+            for ( unsigned i = 0; i < 2; ++i )
+                release( i );
+            m_prerolled = -1;
+            setCurrent( -1 );
+            return;
+        }
+        m_prerollQueued.store( false, std::memory_order_relaxed );
+        auto& player = m_players[next];
+        // Follow the volume changes that were made on the active player
+        auto volume = m_players[previous].volume();
+        if ( volume >= 0 )
+        {
+            player.setVolume( volume );
+            player.setMute( m_players[previous].mute() );
+        }
+        if ( m_prerolled == item )
+        {
+            m_active.store( next, std::memory_order_release );
+            player.setPause( false );
+        }
+        else
+        {
+            release( next );
+            ++m_gen[next];
+            player.setMedia( *media );
+            m_active.store( next, std::memory_order_release );
+            player.play();
+        }
+        m_prerolled = -1;
+        release( previous );
+        setCurrent( item );
+    }
+
+    // Opens the next item on the idle player, paused on its first frame
+    void preroll( int item )
+    {
+        if ( item < 0 || m_prerolled >= 0 )
+            return;
+        auto media = itemAt( item );
+        if ( media == nullptr )
+            return;
+        auto next = 1 - m_active.load( std::memory_order_relaxed );
+        // Don't add the option to the list item, which would then always
+        // start paused
+        auto copy = media->duplicate();
+        copy.addOption( ":start-paused" );
+        release( next );
+        ++m_gen[next];
+        m_players[next].setMedia( copy );
+        m_players[next].play();
+        m_prerolled = item;
+    }
+
+    void release( unsigned index )
+    {
+        stopPlayer( m_players[index] );
+        // Invalidates the events of the stopped media
+        ++m_gen[index];
+    }
+
+    void setCurrent( int item )
+    {
+        m_current.store( item, std::memory_order_release );
+        if ( m_itemChanged != nullptr )
+            m_itemChanged( item );
+    }
+
+    static void stopPlayer( MediaPlayer& player )
+    {
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        player.stopAsync();
+#else
+        player.stop();
+#endif
+    }
+
+private:
+    MediaList m_list;
+    const Config m_config;
+    ItemChanged m_itemChanged;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_closed;
+    std::deque<Command> m_commands;
+    std::atomic<unsigned> m_active;
+    std::atomic<int> m_current;
+    std::atomic<uint64_t> m_gen[2];
+    // Only accessed from the player thread
+    int m_prerolled;
+    std::atomic<bool> m_prerollQueued;
+    std::thread m_thread;
+    // Released first, while the state their events refer to is still alive
+    MediaPlayer m_players[2];
+};
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_GAPLESSLISTPLAYER_H
@@ -29,6 +29,7 @@
 #include "Internal.hpp"
 #include "structures.hpp"
 #include "Dialog.hpp"
+#include "LogSink.hpp"
 #include "MediaDiscoverer.hpp"
 
 #include <algorithm>
@@ -78,6 +79,17 @@ private:
         ProgressUpdate
 #endif
     };
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
+    static_assert( static_cast<size_t>( CallbackIdx::ProgressUpdate ) + 1 == NbCallbacks,
+                   "CallbackIdx must match the callback array" );
+#else
+    static_assert( static_cast<size_t>( CallbackIdx::Log ) < NbCallbacks,
+                   "CallbackIdx must fit in the callback array" );
+#endif
+#ifdef LIBVLCPP_INSTRUMENT_CALLBACKS
+    static_assert( NbCallbacks == instrumentation::detail::NbInstanceCallbacks,
+                   "The instrumentation names must follow CallbackIdx" );
+#endif
 
 #if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
     std::shared_ptr<libvlc_dialog_cbs> m_callbacks_pointers;
@@ -280,6 +292,31 @@ public:
             m_callbacks.get() );
     }
 
+    /**
+     * Sets a LogSink as the logging callback for a LibVLC instance.
+     *
+     * Unlike logSet(), the messages are filtered before being formatted, and
+     * the sink callback is invoked from the sink thread, not from the libvlc
+     * thread emitting the message. This replaces any previous logging
+     * callback.
+     *
+     * \param sink The sink, which is kept alive until the callback is unset
+     *             or replaced
+     *
+     * \warning A deadlock may occur if this function is called from the
+     * callback.
+     *
+     * \version LibVLC 2.1.0 or later
+     */
+    void setLogSink( std::shared_ptr<LogSink> sink )
+    {
+        auto wrapper = [sink](int level, const libvlc_log_t* ctx, const char* format, va_list va) {
+            sink->log( level, ctx, format, va );
+        };
+        libvlc_log_set(*this, CallbackWrapper<(unsigned int)CallbackIdx::Log, libvlc_log_cb>::wrap( *m_callbacks, std::move(wrapper)),
+            m_callbacks.get() );
+    }
+
     /**
      * Sets up logging to a file.
      *
@@ -300,20 +337,33 @@ public:
      */
     std::vector<ModuleDescription> audioFilterList()
     {
-        std::unique_ptr<libvlc_module_description_t, decltype(&libvlc_module_description_list_release)>
-                ptr( libvlc_audio_filter_list_get(*this), libvlc_module_description_list_release );
-        if ( ptr == nullptr )
-            return {};
-        libvlc_module_description_t* p = ptr.get();
         std::vector<ModuleDescription> res;
-        while ( p != nullptr )
-        {
-            res.emplace_back( p );
-            p = p->p_next;
-        }
+        audioFilterList( res );
         return res;
     }
 
+    /**
+     * Appends the available audio filters to \p out, which can be any
+     * container of ModuleDescription providing emplace_back(), such as a
+     * reused vector or a std::pmr::vector.
+     */
+    template <typename Container>
+    void audioFilterList( Container& out )
+    {
+        for ( const auto& d : audioFilterListView() )
+            out.emplace_back( d.get() );
+    }
+
+    /**
+     * Returns the available audio filters, without copying their strings.
+     *
+     * \see DescriptionList
+     */
+    ModuleDescriptionList audioFilterListView()
+    {
+        return ModuleDescriptionList( libvlc_audio_filter_list_get( *this ),
+                                      &libvlc_module_description_list_release );
+    }
 
     /**
      * Returns a list of video filters that are available.
@@ -322,20 +372,32 @@ public:
      */
     std::vector<ModuleDescription> videoFilterList()
     {
-        std::unique_ptr<libvlc_module_description_t, decltype(&libvlc_module_description_list_release)>
-                ptr( libvlc_video_filter_list_get(*this), &libvlc_module_description_list_release );
-        if ( ptr == nullptr )
-            return {};
-        libvlc_module_description_t* p = ptr.get();
         std::vector<ModuleDescription> res;
-        while ( p != nullptr )
-        {
-            res.emplace_back( p );
-            p = p->p_next;
-        }
+        videoFilterList( res );
         return res;
     }
 
+    /**
+     * Appends the available video filters to \p out, see audioFilterList()
+     */
+    template <typename Container>
+    void videoFilterList( Container& out )
+    {
+        for ( const auto& d : videoFilterListView() )
+            out.emplace_back( d.get() );
+    }
+
+    /**
+     * Returns the available video filters, without copying their strings.
+     *
+     * \see DescriptionList
+     */
+    ModuleDescriptionList videoFilterListView()
+    {
+        return ModuleDescriptionList( libvlc_video_filter_list_get( *this ),
+                                      &libvlc_module_description_list_release );
+    }
+
     /**
      * Gets the list of available audio output modules.
      *
@@ -343,21 +405,34 @@ public:
      */
     std::vector<AudioOutputDescription> audioOutputList()
     {
-        std::unique_ptr<libvlc_audio_output_t, decltype(&libvlc_audio_output_list_release)>
-                result( libvlc_audio_output_list_get(*this), libvlc_audio_output_list_release );
-        if ( result == nullptr )
-            return {};
         std::vector<AudioOutputDescription> res;
-
-        libvlc_audio_output_t* p = result.get();
-        while ( p != nullptr )
-        {
-            res.emplace_back( p );
-            p = p->p_next;
-        }
+        audioOutputList( res );
         return res;
     }
 
+    /**
+     * Appends the available audio output modules to \p out, see
+     * audioFilterList()
+     */
+    template <typename Container>
+    void audioOutputList( Container& out )
+    {
+        for ( const auto& d : audioOutputListView() )
+            out.emplace_back( d.get() );
+    }
+
+    /**
+     * Returns the available audio output modules, without copying their
+     * strings.
+     *
+     * \see DescriptionList
+     */
+    AudioOutputDescriptionList audioOutputListView()
+    {
+        return AudioOutputDescriptionList( libvlc_audio_output_list_get( *this ),
+                                           &libvlc_audio_output_list_release );
+    }
+
 #if LIBVLC_VERSION_INT < LIBVLC_VERSION(4, 0, 0, 0)
     /**
      * Gets a list of audio output devices for a given audio output module,
@@ -383,16 +458,34 @@ public:
      */
     std::vector<AudioOutputDeviceDescription> audioOutputDeviceList(const std::string& aout)
     {
-        std::unique_ptr<libvlc_audio_output_device_t, decltype(&libvlc_audio_output_device_list_release)>
-                devices(  libvlc_audio_output_device_list_get( *this, aout.c_str() ), libvlc_audio_output_device_list_release );
-        if ( devices == nullptr )
-            return {};
         std::vector<AudioOutputDeviceDescription> res;
-
-        for ( auto p = devices.get(); p != nullptr; p = p->p_next )
-            res.emplace_back( p );
+        audioOutputDeviceList( aout, res );
         return res;
     }
+
+    /**
+     * Appends the audio output devices of \p aout to \p out, see
+     * audioFilterList()
+     */
+    template <typename Container>
+    void audioOutputDeviceList( const std::string& aout, Container& out )
+    {
+        for ( const auto& d : audioOutputDeviceListView( aout ) )
+            out.emplace_back( d.get() );
+    }
+
+    /**
+     * Returns the audio output devices of \p aout, without copying their
+     * strings.
+     *
+     * \see DescriptionList
+     */
+    AudioOutputDeviceDescriptionList audioOutputDeviceListView( const std::string& aout )
+    {
+        return AudioOutputDeviceDescriptionList(
+                    libvlc_audio_output_device_list_get( *this, aout.c_str() ),
+                    &libvlc_audio_output_device_list_release );
+    }
 #endif
 
 #if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
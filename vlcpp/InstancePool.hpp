@@ -0,0 +1,441 @@
+/*****************************************************************************
+ * InstancePool.hpp: Shards the medias & players over several libvlc instances
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_INSTANCEPOOL_H
+#define LIBVLC_CXX_INSTANCEPOOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "Instance.hpp"
+#include "Media.hpp"
+#include "MediaPlayer.hpp"
+
+namespace VLC
+{
+
+///
+/// \brief The InstancePool class creates several identical libvlc instances,
+/// and spreads the medias & players over them.
+///
+/// Each instance has its own locks (logs, modules, event managers...), so
+/// that a process running many players contends less on them than with a
+/// single instance:
+///
+///     VLC::InstancePool::Config config;
+///     config.nbShards = 4;
+///     config.policy = VLC::InstancePool::Policy::LeastLoaded;
+///     config.setup = [sink]( VLC::Instance& instance, size_t ) {
+///         instance.setLogSink( sink );
+///     };
+///     VLC::InstancePool pool( std::move( config ) );
+///     auto mp = pool.createPlayer();
+///     mp->setMedia( media );
+///     mp->play();
+///
+/// The created objects are returned in a Sharded handle, which accounts for
+/// them in their shard load until it's destroyed. The pool itself can be
+/// destroyed before the handles.
+///
+class InstancePool
+{
+public:
+    enum class Policy
+    {
+        /// Each creation goes to the next shard
+        RoundRobin,
+        /// Each creation goes to the shard with the fewest live objects
+        LeastLoaded,
+        /// Same as LeastLoaded, among the shards of the requested node
+        NodeAffinity,
+    };
+
+    /// Configures a newly created instance, given its shard index. This is
+    /// where the log & dialog callbacks, user agent... are set
+    using Setup = std::function<void(Instance&, size_t)>;
+
+    static const size_t AnyNode = std::numeric_limits<size_t>::max();
+
+    struct Config
+    {
+        Config()
+            : nbShards( 2 )
+            , policy( Policy::RoundRobin )
+            , nbNodes( 1 )
+        {
+        }
+
+        size_t nbShards;
+        /// The libvlc arguments, identical for all the instances
+        std::vector<std::string> args;
+        Policy policy;
+        /// The number of nodes the shards are spread over, shard i belonging
+        /// to node i % nbNodes. Only used by Policy::NodeAffinity
+        size_t nbNodes;
+        Setup setup;
+    };
+
+    struct ShardStats
+    {
+        size_t index;
+        size_t node;
+        /// The live objects created on this shard
+        size_t nbPlayers;
+        size_t nbMedias;
+        /// The objects created on this shard since the pool was created
+        uint64_t nbPlayersCreated;
+        uint64_t nbMediasCreated;
+    };
+
+private:
+    struct Shard
+    {
+        Shard()
+            : node( 0 )
+            , nbPlayers( 0 )
+            , nbMedias( 0 )
+            , nbPlayersCreated( 0 )
+            , nbMediasCreated( 0 )
+        {
+        }
+
+        size_t load() const
+        {
+            return nbPlayers.load( std::memory_order_relaxed ) +
+                    nbMedias.load( std::memory_order_relaxed );
+        }
+
+        Instance instance;
+        size_t node;
+        std::atomic<size_t> nbPlayers;
+        std::atomic<size_t> nbMedias;
+        std::atomic<uint64_t> nbPlayersCreated;
+        std::atomic<uint64_t> nbMediasCreated;
+    };
+
+    // Outlives the pool while some Sharded handles are alive
+    struct State
+    {
+        explicit State( size_t n )
+            : nbShards( n )
+            , shards( new Shard[n] )
+        {
+        }
+
+        const size_t nbShards;
+        std::unique_ptr<Shard[]> shards;
+    };
+
+public:
+    ///
+    /// \brief The Sharded class holds an object created by the pool, along
+    /// with the shard it was created on. It can only be moved.
+    ///
+    template <typename T>
+    class Sharded
+    {
+    public:
+        Sharded()
+            : m_shard( 0 )
+            , m_counter( nullptr )
+        {
+        }
+
+        Sharded( const Sharded& ) = delete;
+        Sharded& operator=( const Sharded& ) = delete;
+
+        Sharded( Sharded&& other )
+            : m_object( std::move( other.m_object ) )
+            , m_state( std::move( other.m_state ) )
+            , m_shard( other.m_shard )
+            , m_counter( other.m_counter )
+        {
+            other.m_counter = nullptr;
+        }
+
+        Sharded& operator=( Sharded&& other )
+        {
+            if ( this != &other )
+            {
+                release();
+                m_object = std::move( other.m_object );
+                m_state = std::move( other.m_state );
+                m_shard = other.m_shard;
+                m_counter = other.m_counter;
+                other.m_counter = nullptr;
+            }
+            return *this;
+        }
+
+        ~Sharded()
+        {
+            release();
+        }
+
+        bool isValid() const
+        {
+            return m_counter != nullptr;
+        }
+
+        T& get()
+        {
+            return m_object;
+        }
+
+        T& operator*()
+        {
+            return m_object;
+        }
+
+        T* operator->()
+        {
+            return &m_object;
+        }
+
+        size_t shard() const
+        {
+            return m_shard;
+        }
+
+        /// The instance of the shard, to create related objects from
+        const Instance& instance() const
+        {
+            return m_state->shards[m_shard].instance;
+        }
+
+        /// Stops accounting for the object in its shard load. The object
+        /// itself is released with this handle
+        void release()
+        {
+            if ( m_counter == nullptr )
+                return;
+            m_counter->fetch_sub( 1, std::memory_order_relaxed );
+            m_counter = nullptr;
+        }
+
+    private:
+        Sharded( T object, std::shared_ptr<State> state, size_t shard, std::atomic<size_t>* counter )
+            : m_object( std::move( object ) )
+            , m_state( std::move( state ) )
+            , m_shard( shard )
+            , m_counter( counter )
+        {
+        }
+
+    private:
+        T m_object;
+        std::shared_ptr<State> m_state;
+        size_t m_shard;
+        std::atomic<size_t>* m_counter;
+
+        friend class InstancePool;
+    };
+
+    /**
+     * Creates the instances, and configures them with config.setup
+     *
+     * \throw std::runtime_error if an instance can't be created
+     */
+    explicit InstancePool( Config config )
+        : m_state( std::make_shared<State>( config.nbShards == 0 ? 1 : config.nbShards ) )
+        , m_policy( config.policy )
+        , m_nbNodes( config.nbNodes == 0 ? 1 : config.nbNodes )
+        , m_next( 0 )
+    {
+        std::vector<const char*> argv;
+        argv.reserve( config.args.size() );
+        for ( const auto& a : config.args )
+            argv.push_back( a.c_str() );
+        for ( size_t i = 0; i < m_state->nbShards; ++i )
+        {
+            auto& s = m_state->shards[i];
+            s.instance = Instance( static_cast<int>( argv.size() ),
+                                   argv.empty() == true ? nullptr : argv.data() );
+            if ( s.instance.isValid() == false )
+                throw std::runtime_error( "Failed to create a libvlc instance" );
+            s.node = i % m_nbNodes;
+            if ( config.setup != nullptr )
+                config.setup( s.instance, i );
+        }
+    }
+
+    InstancePool( const InstancePool& ) = delete;
+    InstancePool& operator=( const InstancePool& ) = delete;
+
+    size_t nbShards() const
+    {
+        return m_state->nbShards;
+    }
+
+    Instance& instance( size_t shard )
+    {
+        return m_state->shards[shard].instance;
+    }
+
+    /**
+     * Selects a shard according to the pool policy
+     *
+     * \param node The node of the caller, for instance the NUMA node of the
+     *             current CPU, or AnyNode. It's ignored unless the policy is
+     *             Policy::NodeAffinity
+     */
+    size_t pick( size_t node = AnyNode )
+    {
+        auto n = m_state->nbShards;
+        if ( m_policy == Policy::RoundRobin )
+            return m_next.fetch_add( 1, std::memory_order_relaxed ) % n;
+        bool sameNode = m_policy == Policy::NodeAffinity && node != AnyNode;
+        // Start from a rotating shard, so that equally loaded shards are
+        // used in turn
+        auto first = m_next.fetch_add( 1, std::memory_order_relaxed );
+        auto best = n;
+        auto bestLoad = std::numeric_limits<size_t>::max();
+        for ( size_t i = 0; i < n; ++i )
+        {
+            auto idx = ( first + i ) % n;
+            const auto& s = m_state->shards[idx];
+            if ( sameNode == true && s.node != node % m_nbNodes )
+                continue;
+            auto load = s.load();
+            if ( load < bestLoad )
+            {
+                best = idx;
+                bestLoad = load;
+            }
+        }
+        return best < n ? best : first % n;
+    }
+
+    /// Creates a player on a shard selected by pick()
+    Sharded<MediaPlayer> createPlayer( size_t node = AnyNode )
+    {
+        auto idx = pick( node );
+        auto& s = m_state->shards[idx];
+        return makeSharded( MediaPlayer( s.instance ), idx, s.nbPlayers, s.nbPlayersCreated );
+    }
+
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+    /**
+     * Creates a media, accounted for on a shard selected by pick().
+     *
+     * libvlc 4 medias don't belong to an instance: the shard is the one the
+     * media is meant to be parsed and played with, see Sharded::instance()
+     * and createPlayer( Sharded<Media>& )
+     */
+    Sharded<Media> createMedia( const std::string& mrl, Media::FromType type, size_t node = AnyNode )
+    {
+        auto idx = pick( node );
+        auto& s = m_state->shards[idx];
+        return makeSharded( Media( mrl, type ), idx, s.nbMedias, s.nbMediasCreated );
+    }
+
+    /// Creates a player for \p media, on the media shard
+    Sharded<MediaPlayer> createPlayer( Sharded<Media>& media )
+    {
+        auto& s = m_state->shards[media.shard()];
+        return makeSharded( MediaPlayer( s.instance, media.get() ), media.shard(),
+                            s.nbPlayers, s.nbPlayersCreated );
+    }
+#else
+    /// Creates a media on a shard selected by pick()
+    Sharded<Media> createMedia( const std::string& mrl, Media::FromType type, size_t node = AnyNode )
+    {
+        auto idx = pick( node );
+        auto& s = m_state->shards[idx];
+        return makeSharded( Media( s.instance, mrl, type ), idx, s.nbMedias, s.nbMediasCreated );
+    }
+
+    /// Creates a player for \p media, on the media shard
+    Sharded<MediaPlayer> createPlayer( Sharded<Media>& media )
+    {
+        auto& s = m_state->shards[media.shard()];
+        return makeSharded( MediaPlayer( media.get() ), media.shard(),
+                            s.nbPlayers, s.nbPlayersCreated );
+    }
+#endif
+
+    /// A snapshot of each shard counters
+    std::vector<ShardStats> stats() const
+    {
+        std::vector<ShardStats> res;
+        res.reserve( m_state->nbShards );
+        for ( size_t i = 0; i < m_state->nbShards; ++i )
+        {
+            const auto& s = m_state->shards[i];
+            ShardStats st;
+            st.index = i;
+            st.node = s.node;
+            st.nbPlayers = s.nbPlayers.load( std::memory_order_relaxed );
+            st.nbMedias = s.nbMedias.load( std::memory_order_relaxed );
+            st.nbPlayersCreated = s.nbPlayersCreated.load( std::memory_order_relaxed );
+            st.nbMediasCreated = s.nbMediasCreated.load( std::memory_order_relaxed );
+            res.push_back( st );
+        }
+        return res;
+    }
+
+    /// The counters of all the shards added together, with index & node
+    /// set to AnyNode
+    ShardStats totalStats() const
+    {
+        ShardStats res;
+        res.index = AnyNode;
+        res.node = AnyNode;
+        res.nbPlayers = 0;
+        res.nbMedias = 0;
+        res.nbPlayersCreated = 0;
+        res.nbMediasCreated = 0;
+        for ( const auto& st : stats() )
+        {
+            res.nbPlayers += st.nbPlayers;
+            res.nbMedias += st.nbMedias;
+            res.nbPlayersCreated += st.nbPlayersCreated;
+            res.nbMediasCreated += st.nbMediasCreated;
+        }
+        return res;
+    }
+
+private:
+    template <typename T>
+    Sharded<T> makeSharded( T object, size_t shard, std::atomic<size_t>& counter,
+                            std::atomic<uint64_t>& created )
+    {
+        counter.fetch_add( 1, std::memory_order_relaxed );
+        created.fetch_add( 1, std::memory_order_relaxed );
+        return Sharded<T>( std::move( object ), m_state, shard, &counter );
+    }
+
+private:
+    std::shared_ptr<State> m_state;
+    const Policy m_policy;
+    const size_t m_nbNodes;
+    std::atomic<size_t> m_next;
+};
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_INSTANCEPOOL_H
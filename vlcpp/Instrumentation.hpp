@@ -0,0 +1,384 @@
+/*****************************************************************************
+ * Instrumentation.hpp: Latency histograms for the callback trampolines
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_INSTRUMENTATION_H
+#define LIBVLC_CXX_INSTRUMENTATION_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <vlc/libvlc_version.h>
+
+namespace VLC
+{
+
+///
+/// The time spent in the user callbacks, measured from the trampolines
+/// libvlc invokes: the CallbackWrapper ones (audio, video, imem, log &
+/// dialog callbacks) and the event handlers.
+///
+/// The measurements are compiled in when LIBVLCPP_INSTRUMENT_CALLBACKS is
+/// defined before including any libvlcpp header, and cost nothing otherwise:
+///
+///     #define LIBVLCPP_INSTRUMENT_CALLBACKS
+///     #include <vlcpp/vlc.hpp>
+///     ...
+///     for ( const auto& r : VLC::instrumentation::report() )
+///         printf( "%s: %llu calls, p99 %llu ns\n", r.name.c_str(),
+///                 r.count, r.percentile( 0.99 ) );
+///
+namespace instrumentation
+{
+
+///
+/// \brief The Histogram class counts durations in log-linear buckets: each
+/// power of two is split in 4 buckets, so that any value is known within
+/// 25%, from 1ns to several minutes.
+///
+/// Recording is lock-free. Each callback is usually invoked from a single
+/// libvlc thread, so the counters are seldom contended.
+///
+class Histogram
+{
+public:
+    static const size_t NbBuckets = 160;
+
+    Histogram()
+    {
+        reset();
+    }
+
+    Histogram( const Histogram& ) = delete;
+    Histogram& operator=( const Histogram& ) = delete;
+
+    void record( uint64_t ns )
+    {
+        m_buckets[bucket( ns )].fetch_add( 1, std::memory_order_relaxed );
+        m_count.fetch_add( 1, std::memory_order_relaxed );
+        m_totalNs.fetch_add( ns, std::memory_order_relaxed );
+        auto max = m_maxNs.load( std::memory_order_relaxed );
+        while ( ns > max &&
+                m_maxNs.compare_exchange_weak( max, ns, std::memory_order_relaxed ) == false )
+            ;
+    }
+
+    void reset()
+    {
+        for ( auto& b : m_buckets )
+            b.store( 0, std::memory_order_relaxed );
+        m_count.store( 0, std::memory_order_relaxed );
+        m_totalNs.store( 0, std::memory_order_relaxed );
+        m_maxNs.store( 0, std::memory_order_relaxed );
+    }
+
+    uint64_t count() const { return m_count.load( std::memory_order_relaxed ); }
+    uint64_t totalNs() const { return m_totalNs.load( std::memory_order_relaxed ); }
+    uint64_t maxNs() const { return m_maxNs.load( std::memory_order_relaxed ); }
+    uint64_t bucketCount( size_t i ) const { return m_buckets[i].load( std::memory_order_relaxed ); }
+
+    static size_t bucket( uint64_t ns )
+    {
+        if ( ns < 4 )
+            return static_cast<size_t>( ns );
+        auto exp = log2( ns );
+        auto sub = ( ns >> ( exp - 2 ) ) & 3;
+        auto res = static_cast<size_t>( ( exp - 1 ) * 4 + sub );
+        return res < NbBuckets ? res : NbBuckets - 1;
+    }
+
+    /// The smallest value of the i-th bucket
+    static uint64_t lowerBound( size_t i )
+    {
+        if ( i < 4 )
+            return i;
+        auto exp = i / 4 + 1;
+        return static_cast<uint64_t>( 4 + i % 4 ) << ( exp - 2 );
+    }
+
+private:
+    static unsigned log2( uint64_t v )
+    {
+#if defined(__GNUC__)
+        return 63 - static_cast<unsigned>( __builtin_clzll( v ) );
+#else
+        unsigned res = 0;
+        while ( v >>= 1 )
+            ++res;
+        return res;
+#endif
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, NbBuckets> m_buckets;
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_totalNs;
+    std::atomic<uint64_t> m_maxNs;
+};
+
+///
+/// \brief The Site class identifies an instrumented callback. Sites are
+/// created on their first call, and live until the program exits.
+///
+class Site
+{
+public:
+    explicit Site( std::string name )
+        : m_name( std::move( name ) )
+        , m_next( nullptr )
+    {
+        auto& h = head();
+        m_next = h.load( std::memory_order_relaxed );
+        while ( h.compare_exchange_weak( m_next, this, std::memory_order_release,
+                                         std::memory_order_relaxed ) == false )
+            ;
+    }
+
+    Site( const Site& ) = delete;
+    Site& operator=( const Site& ) = delete;
+
+    const std::string& name() const { return m_name; }
+    Histogram& histogram() { return m_histogram; }
+    const Histogram& histogram() const { return m_histogram; }
+    const Site* next() const { return m_next; }
+
+    /// The most recently created site, from which all the sites can be
+    /// walked through next()
+    static const Site* first()
+    {
+        return head().load( std::memory_order_acquire );
+    }
+
+    static void resetAll()
+    {
+        for ( auto s = head().load( std::memory_order_acquire ); s != nullptr; s = s->m_next )
+            s->m_histogram.reset();
+    }
+
+private:
+    static std::atomic<Site*>& head()
+    {
+        static std::atomic<Site*> h( nullptr );
+        return h;
+    }
+
+private:
+    const std::string m_name;
+    Histogram m_histogram;
+    Site* m_next;
+};
+
+///
+/// \brief The Report struct is a copy of a site histogram.
+///
+struct Report
+{
+    std::string name;
+    uint64_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+    std::array<uint64_t, Histogram::NbBuckets> buckets;
+
+    double meanNs() const
+    {
+        return count != 0 ? static_cast<double>( totalNs ) / count : 0.;
+    }
+
+    /// The lower bound of the bucket holding the \p q quantile, \p q being
+    /// between 0 and 1
+    uint64_t percentile( double q ) const
+    {
+        uint64_t total = 0;
+        for ( auto b : buckets )
+            total += b;
+        if ( total == 0 )
+            return 0;
+        auto rank = static_cast<uint64_t>( q * static_cast<double>( total - 1 ) );
+        uint64_t seen = 0;
+        for ( size_t i = 0; i < buckets.size(); ++i )
+        {
+            seen += buckets[i];
+            if ( seen > rank )
+                return Histogram::lowerBound( i );
+        }
+        return maxNs;
+    }
+};
+
+/// Copies the histograms of the sites that were called at least once.
+/// This can be called at any time; a call in progress may or may not be
+/// accounted for.
+inline std::vector<Report> report()
+{
+    std::vector<Report> res;
+    for ( auto s = Site::first(); s != nullptr; s = s->next() )
+    {
+        const auto& h = s->histogram();
+        if ( h.count() == 0 )
+            continue;
+        Report r;
+        r.name = s->name();
+        r.count = h.count();
+        r.totalNs = h.totalNs();
+        r.maxNs = h.maxNs();
+        for ( size_t i = 0; i < Histogram::NbBuckets; ++i )
+            r.buckets[i] = h.bucketCount( i );
+        res.push_back( std::move( r ) );
+    }
+    return res;
+}
+
+/// Clears all the histograms
+inline void reset()
+{
+    Site::resetAll();
+}
+
+///
+/// \brief The ScopedTimer class records its lifetime into a histogram
+///
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer( Site& site )
+        : m_site( site )
+        , m_start( std::chrono::steady_clock::now() )
+    {
+    }
+
+    ~ScopedTimer()
+    {
+        auto elapsed = std::chrono::steady_clock::now() - m_start;
+        m_site.histogram().record( static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>( elapsed ).count() ) );
+    }
+
+    ScopedTimer( const ScopedTimer& ) = delete;
+    ScopedTimer& operator=( const ScopedTimer& ) = delete;
+
+private:
+    Site& m_site;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+namespace detail
+{
+
+// The callback owners are told apart by the size of their callback array.
+// Each owner checks its CallbackIdx enum against its count here, and each
+// name table against the same count, so that they can't get out of sync.
+static const size_t NbMediaPlayerCallbacks = 22;
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
+static const size_t NbInstanceCallbacks = 8;
+#else
+static const size_t NbInstanceCallbacks = 5;
+#endif
+static const size_t NbMediaCallbacks = 4;
+
+static_assert( NbMediaPlayerCallbacks != NbInstanceCallbacks &&
+               NbMediaPlayerCallbacks != NbMediaCallbacks &&
+               NbInstanceCallbacks != NbMediaCallbacks,
+               "The callback owners must have distinct callback counts" );
+
+inline std::string callbackName( size_t nbEvents, size_t idx )
+{
+    static const char* const mediaPlayer[] = {
+        "AudioPlay", "AudioPause", "AudioResume", "AudioFlush", "AudioDrain",
+        "AudioVolume", "AudioSetup", "AudioCleanup",
+        "VideoLock", "VideoUnlock", "VideoDisplay", "VideoFormat", "VideoCleanup",
+        "VideoOutputSetup", "VideoOutputCleanup", "VideoOutputSetWindow",
+        "VideoUpdateOutput", "VideoSwap", "VideoMakeCurrent", "VideoGetProcAddress",
+        "VideoFrameMetadata", "VideoOutputSelectPlane",
+    };
+    static_assert( sizeof( mediaPlayer ) / sizeof( *mediaPlayer ) == NbMediaPlayerCallbacks,
+                   "The MediaPlayer callback names must follow MediaPlayer::CallbackIdx" );
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
+    static const char* const instance[] = {
+        "Exit", "Log", "ErrorDisplay", "LoginDisplay", "QuestionDisplay",
+        "ProgressDisplay", "CancelDialog", "ProgressUpdate",
+    };
+#else
+    // The last entries of the array are unused
+    static const char* const instance[] = {
+        "Exit", "Log", nullptr, nullptr, nullptr,
+    };
+#endif
+    static_assert( sizeof( instance ) / sizeof( *instance ) == NbInstanceCallbacks,
+                   "The Instance callback names must follow Instance::CallbackIdx" );
+    static const char* const media[] = { "Open", "Read", "Seek", "Close" };
+    static_assert( sizeof( media ) / sizeof( *media ) == NbMediaCallbacks,
+                   "The Media callback names must follow Media::CallbackIdx" );
+
+    const char* owner = nullptr;
+    const char* name = nullptr;
+    if ( nbEvents == NbMediaPlayerCallbacks )
+    {
+        owner = "MediaPlayer";
+        name = idx < NbMediaPlayerCallbacks ? mediaPlayer[idx] : nullptr;
+    }
+    else if ( nbEvents == NbInstanceCallbacks )
+    {
+        owner = "Instance";
+        name = idx < NbInstanceCallbacks ? instance[idx] : nullptr;
+    }
+    else if ( nbEvents == NbMediaCallbacks )
+    {
+        owner = "Media";
+        name = idx < NbMediaCallbacks ? media[idx] : nullptr;
+    }
+    if ( owner == nullptr || name == nullptr )
+        return "Callback" + std::to_string( nbEvents ) + "::" + std::to_string( idx );
+    return std::string( owner ) + "::" + name;
+}
+
+template <size_t NbEvents, size_t Idx>
+Site& callbackSite()
+{
+    static Site site( callbackName( NbEvents, Idx ) );
+    return site;
+}
+
+// libvlc event types are grouped per object type, in 0x100 wide ranges
+inline Site& eventSite( int type )
+{
+    static const size_t NbTypes = 0x800;
+    static std::atomic<Site*> sites[NbTypes];
+    auto idx = static_cast<size_t>( type ) < NbTypes ? static_cast<size_t>( type ) : NbTypes - 1;
+    auto site = sites[idx].load( std::memory_order_acquire );
+    if ( site != nullptr )
+        return *site;
+    // Sites are never released, a site losing the race is simply unused
+    Site* expected = nullptr;
+    auto created = new Site( "Event::" + std::to_string( type ) );
+    if ( sites[idx].compare_exchange_strong( expected, created, std::memory_order_acq_rel ) == true )
+        return *created;
+    return *expected;
+}
+
+} // namespace detail
+
+} // namespace instrumentation
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_INSTRUMENTATION_H
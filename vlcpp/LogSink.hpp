@@ -0,0 +1,374 @@
+/*****************************************************************************
+ * LogSink.hpp: Filtered, non-blocking libvlc log sink
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_LOGSINK_H
+#define LIBVLC_CXX_LOGSINK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+
+namespace VLC
+{
+
+///
+/// \brief The LogSink class receives libvlc logs without delaying the
+/// threads emitting them.
+///
+/// Messages are filtered by level and module before being formatted. The
+/// accepted ones are formatted once, into a fixed size record of a
+/// preallocated lock-free queue, and handed to the callback from a
+/// background thread:
+///
+///     VLC::LogSink::Config config;
+///     config.minLevel = LIBVLC_WARNING;
+///     // Debug logs for the decoders, at most 50 per second
+///     config.modules.emplace_back( "avcodec", LIBVLC_DEBUG, 50 );
+///     auto sink = std::make_shared<VLC::LogSink>( []( const VLC::LogSink::Record& r ) {
+///         logger.write( r.level, r.module, r.message );
+///     }, config );
+///     instance.setLogSink( sink );
+///
+/// When the queue is full, or a module exceeds its rate, the messages are
+/// dropped and accounted for in nbDropped() and nbRateLimited().
+///
+class LogSink
+{
+public:
+    struct Record
+    {
+        static const size_t MaxModuleLength = 32;
+        static const size_t MaxMessageLength = 256;
+
+        /// One of the libvlc_log_level values
+        int level;
+        std::chrono::system_clock::time_point time;
+        /// The emitting module, possibly truncated
+        char module[MaxModuleLength];
+        /// The formatted message, possibly truncated
+        char message[MaxMessageLength];
+        bool truncated;
+    };
+
+    /// Invoked from the sink thread, for each accepted message
+    using Callback = std::function<void(const Record&)>;
+
+    struct ModuleRule
+    {
+        /**
+         * \param module       The module name, as reported by libvlc
+         * \param minLevel     The lowest level to keep for this module
+         * \param maxPerSecond The maximum number of messages per second, or
+         *                     0 for no limit
+         */
+        ModuleRule( std::string module, int minLevel, unsigned maxPerSecond = 0 )
+            : module( std::move( module ) )
+            , minLevel( minLevel )
+            , maxPerSecond( maxPerSecond )
+        {
+        }
+
+        std::string module;
+        int minLevel;
+        unsigned maxPerSecond;
+    };
+
+    struct Config
+    {
+        Config()
+            : minLevel( LIBVLC_NOTICE )
+            , capacity( 1024 )
+        {
+        }
+
+        /// The lowest level to keep for the modules without a rule
+        int minLevel;
+        /// The maximum number of pending records, rounded up to the next
+        /// power of two
+        size_t capacity;
+        /// Overrides for specific modules
+        std::vector<ModuleRule> modules;
+    };
+
+    explicit LogSink( Callback cb, Config config = Config() )
+        : m_cb( std::move( cb ) )
+        , m_minLevel( config.minLevel )
+        , m_lowestLevel( config.minLevel )
+        , m_nbRules( config.modules.size() )
+        , m_rules( new RuleState[config.modules.size()] )
+        , m_mask( roundUp( config.capacity ) - 1 )
+        , m_cells( new Cell[m_mask + 1] )
+        , m_enqueuePos( 0 )
+        , m_dequeuePos( 0 )
+        , m_nbDropped( 0 )
+        , m_nbRateLimited( 0 )
+        , m_stop( false )
+    {
+        for ( size_t i = 0; i < m_nbRules; ++i )
+        {
+            auto& r = config.modules[i];
+            m_rules[i].module = std::move( r.module );
+            m_rules[i].minLevel = r.minLevel;
+            m_rules[i].maxPerSecond = r.maxPerSecond;
+            if ( r.minLevel < m_lowestLevel )
+                m_lowestLevel = r.minLevel;
+        }
+        for ( size_t i = 0; i <= m_mask; ++i )
+            m_cells[i].sequence.store( i, std::memory_order_relaxed );
+        m_thread = std::thread( &LogSink::run, this );
+    }
+
+    /// Delivers the pending records before returning
+    ~LogSink()
+    {
+        m_stop.store( true );
+        m_parker.notify();
+        m_thread.join();
+    }
+
+    LogSink( const LogSink& ) = delete;
+    LogSink& operator=( const LogSink& ) = delete;
+
+    /**
+     * Changes the lowest level kept for the modules without a rule. This
+     * can be called at any time, from any thread.
+     */
+    void setMinLevel( int level )
+    {
+        m_minLevel.store( level, std::memory_order_relaxed );
+    }
+
+    int minLevel() const
+    {
+        return m_minLevel.load( std::memory_order_relaxed );
+    }
+
+    /**
+     * Filters, formats and queues a message. This is meant to be called from
+     * a libvlc log callback, see Instance::setLogSink()
+     */
+    void log( int level, const libvlc_log_t* ctx, const char* format, va_list va )
+    {
+        // Most messages are rejected here, without any libvlc call
+        if ( level < m_lowestLevel && level < m_minLevel.load( std::memory_order_relaxed ) )
+            return;
+        const char* module;
+        const char* file;
+        unsigned int line;
+        libvlc_log_get_context( ctx, &module, &file, &line );
+        if ( module == nullptr )
+            module = "";
+        if ( accept( level, module ) == false )
+            return;
+        auto cell = acquire();
+        if ( cell == nullptr )
+            return;
+        auto& r = cell->record;
+        r.level = level;
+        r.time = std::chrono::system_clock::now();
+        strncpy( r.module, module, Record::MaxModuleLength - 1 );
+        r.module[Record::MaxModuleLength - 1] = 0;
+#ifndef _MSC_VER
+        auto len = vsnprintf( r.message, Record::MaxMessageLength, format, va );
+        r.truncated = len >= static_cast<int>( Record::MaxMessageLength );
+#else
+        auto len = _vsnprintf_s( r.message, _TRUNCATE, format, va );
+        r.truncated = len < 0;
+#endif
+        if ( len < 0 )
+            r.message[0] = 0;
+        publish( cell );
+    }
+
+    /// Number of messages discarded because the queue was full
+    uint64_t nbDropped() const
+    {
+        return m_nbDropped.load( std::memory_order_relaxed );
+    }
+
+    /// Number of messages discarded because their module exceeded its rate
+    uint64_t nbRateLimited() const
+    {
+        return m_nbRateLimited.load( std::memory_order_relaxed );
+    }
+
+private:
+    struct RuleState
+    {
+        RuleState()
+            : minLevel( 0 )
+            , maxPerSecond( 0 )
+            , window( 0 )
+            , count( 0 )
+        {
+        }
+
+        std::string module;
+        int minLevel;
+        unsigned maxPerSecond;
+        // The current one second window, and the messages counted within
+        std::atomic<int64_t> window;
+        std::atomic<unsigned> count;
+    };
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    static size_t roundUp( size_t capacity )
+    {
+        size_t res = 2;
+        while ( res < capacity )
+            res <<= 1;
+        return res;
+    }
+
+    bool accept( int level, const char* module )
+    {
+        for ( size_t i = 0; i < m_nbRules; ++i )
+        {
+            auto& rule = m_rules[i];
+            if ( strcmp( rule.module.c_str(), module ) != 0 )
+                continue;
+            if ( level < rule.minLevel )
+                return false;
+            if ( rule.maxPerSecond == 0 )
+                return true;
+            auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                        std::chrono::steady_clock::now().time_since_epoch() ).count();
+            auto window = rule.window.load( std::memory_order_relaxed );
+            if ( window != now &&
+                 rule.window.compare_exchange_strong( window, now, std::memory_order_relaxed ) == true )
+                rule.count.store( 0, std::memory_order_relaxed );
+            if ( rule.count.fetch_add( 1, std::memory_order_relaxed ) < rule.maxPerSecond )
+                return true;
+            m_nbRateLimited.fetch_add( 1, std::memory_order_relaxed );
+            return false;
+        }
+        return level >= m_minLevel.load( std::memory_order_relaxed );
+    }
+
+    // The same bounded MPMC queue as EventQueue, except the cell is claimed
+    // first, and filled in place before being published
+    Cell* acquire()
+    {
+        auto pos = m_enqueuePos.load( std::memory_order_relaxed );
+        for ( ;; )
+        {
+            auto cell = &m_cells[pos & m_mask];
+            auto seq = cell->sequence.load( std::memory_order_acquire );
+            auto diff = static_cast<intptr_t>( seq ) - static_cast<intptr_t>( pos );
+            if ( diff == 0 )
+            {
+                if ( m_enqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) == true )
+                    return cell;
+            }
+            else if ( diff < 0 )
+            {
+                m_nbDropped.fetch_add( 1, std::memory_order_relaxed );
+                return nullptr;
+            }
+            else
+                pos = m_enqueuePos.load( std::memory_order_relaxed );
+        }
+    }
+
+    void publish( Cell* cell )
+    {
+        auto pos = cell->sequence.load( std::memory_order_relaxed );
+        cell->sequence.store( pos + 1, std::memory_order_release );
+        m_parker.notify();
+    }
+
+    bool empty() const
+    {
+        auto pos = m_dequeuePos.load( std::memory_order_relaxed );
+        auto seq = m_cells[pos & m_mask].sequence.load( std::memory_order_acquire );
+        return seq != pos + 1;
+    }
+
+    void drain()
+    {
+        for ( ;; )
+        {
+            auto pos = m_dequeuePos.load( std::memory_order_relaxed );
+            auto cell = &m_cells[pos & m_mask];
+            if ( cell->sequence.load( std::memory_order_acquire ) != pos + 1 )
+                return;
+            // Single consumer: the record can be delivered in place
+            m_dequeuePos.store( pos + 1, std::memory_order_relaxed );
+            if ( m_cb != nullptr )
+                m_cb( cell->record );
+            cell->sequence.store( pos + m_mask + 1, std::memory_order_release );
+        }
+    }
+
+    void run()
+    {
+        for ( ;; )
+        {
+            m_parker.wait( [this]() {
+                return m_stop.load() == true || empty() == false;
+            });
+            drain();
+            if ( m_stop.load() == true )
+            {
+                drain();
+                return;
+            }
+        }
+    }
+
+private:
+    static const size_t CacheLineSize = 64;
+
+    const Callback m_cb;
+    std::atomic<int> m_minLevel;
+    int m_lowestLevel;
+    const size_t m_nbRules;
+    std::unique_ptr<RuleState[]> m_rules;
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    char m_padding0[CacheLineSize];
+    std::atomic<size_t> m_enqueuePos;
+    char m_padding1[CacheLineSize];
+    std::atomic<size_t> m_dequeuePos;
+    char m_padding2[CacheLineSize];
+    std::atomic<uint64_t> m_nbDropped;
+    std::atomic<uint64_t> m_nbRateLimited;
+    std::atomic<bool> m_stop;
+    detail::ThreadParker m_parker;
+    std::thread m_thread;
+};
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_LOGSINK_H
@@ -25,6 +25,7 @@
 #define LIBVLC_CXX_MEDIA_H
 
 #include "common.hpp"
+#include "Ref.hpp"
 
 #include <vector>
 #include <stdexcept>
@@ -47,6 +48,12 @@ private:
         Seek,
         Close,
     };
+    static_assert( static_cast<size_t>( CallbackIdx::Close ) + 1 == NbCallbacks,
+                   "CallbackIdx must match the callback array" );
+#ifdef LIBVLCPP_INSTRUMENT_CALLBACKS
+    static_assert( NbCallbacks == instrumentation::detail::NbMediaCallbacks,
+                   "The instrumentation names must follow CallbackIdx" );
+#endif
 #if !defined(_MSC_VER) || _MSC_VER >= 1900
     static constexpr unsigned int NbEvents = 4;
 #else
@@ -148,24 +155,30 @@ public:
     Media(const std::string& mrl, FromType type)
         : Internal{ libvlc_media_release }
     {
-        InternalPtr ptr = nullptr;
+        auto ptr = createUnique( mrl, type ).release();
+        if ( ptr == nullptr )
+            throw std::runtime_error("Failed to construct a media");
+        m_obj.reset( ptr, libvlc_media_release );
+    }
+
+    /**
+     * Creates a media which isn't shared, see Media( mrl, type )
+     *
+     * \return The media, or an invalid handle if it couldn't be created
+     */
+    static UniqueMedia createUnique( const std::string& mrl, FromType type )
+    {
         switch (type)
         {
         case FromLocation:
-            ptr = libvlc_media_new_location( mrl.c_str() );
-            break;
+            return UniqueMedia( libvlc_media_new_location( mrl.c_str() ) );
         case FromPath:
-            ptr = libvlc_media_new_path( mrl.c_str() );
-            break;
+            return UniqueMedia( libvlc_media_new_path( mrl.c_str() ) );
         case AsNode:
-            ptr = libvlc_media_new_as_node( mrl.c_str() );
-            break;
+            return UniqueMedia( libvlc_media_new_as_node( mrl.c_str() ) );
         default:
-            break;
+            return UniqueMedia();
         }
-        if ( ptr == nullptr )
-            throw std::runtime_error("Failed to construct a media");
-        m_obj.reset( ptr, libvlc_media_release );
     }
 
     /**
@@ -210,24 +223,31 @@ public:
     Media(const Instance& instance, const std::string& mrl, FromType type)
         : Internal{ libvlc_media_release }
     {
-        InternalPtr ptr = nullptr;
+        auto ptr = createUnique( instance, mrl, type ).release();
+        if ( ptr == nullptr )
+            throw std::runtime_error("Failed to construct a media");
+        m_obj.reset( ptr, libvlc_media_release );
+    }
+
+    /**
+     * Creates a media which isn't shared, see Media( instance, mrl, type )
+     *
+     * \return The media, or an invalid handle if it couldn't be created
+     */
+    static UniqueMedia createUnique( const Instance& instance, const std::string& mrl, FromType type )
+    {
+        auto inst = getInternalPtr<libvlc_instance_t>( instance );
         switch (type)
         {
         case FromLocation:
-            ptr = libvlc_media_new_location( getInternalPtr<libvlc_instance_t>( instance ), mrl.c_str() );
-            break;
+            return UniqueMedia( libvlc_media_new_location( inst, mrl.c_str() ) );
         case FromPath:
-            ptr = libvlc_media_new_path( getInternalPtr<libvlc_instance_t>( instance ), mrl.c_str() );
-            break;
+            return UniqueMedia( libvlc_media_new_path( inst, mrl.c_str() ) );
         case AsNode:
-            ptr = libvlc_media_new_as_node( getInternalPtr<libvlc_instance_t>( instance ), mrl.c_str() );
-            break;
+            return UniqueMedia( libvlc_media_new_as_node( inst, mrl.c_str() ) );
         default:
-            break;
+            return UniqueMedia();
         }
-        if ( ptr == nullptr )
-            throw std::runtime_error("Failed to construct a media");
-        m_obj.reset( ptr, libvlc_media_release );
     }
 
     /**
@@ -591,6 +611,26 @@ public:
         return libvlc_media_get_state(*this);
     }
 #endif
+    /**
+     * Sets a hook invoked the first time each libvlc thread calls one of the
+     * imem callbacks this media was created with, before the callback
+     * itself.
+     *
+     * \param hook A std::function<void(CallbackThread)> (or an equivalent
+     *             Callable type), or nullptr to remove the hook. It's given
+     *             CallbackThread::Input.
+     *
+     * \note The hook can be replaced at any time: each thread then runs the
+     *       new one before its next callback. Copies of this media share the
+     *       hook.
+     */
+    void setCallbackThreadHook( CallbackThreadHook hook )
+    {
+        setThreadHook( std::move( hook ), []( size_t ) {
+            return CallbackThread::Input;
+        });
+    }
+
     /**
      * Get the current statistics about the media
      *
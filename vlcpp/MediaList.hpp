@@ -26,7 +26,10 @@
 
 #include "common.hpp"
 
+#include <iterator>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 namespace VLC
 {
@@ -142,6 +145,35 @@ public:
         return libvlc_media_list_add_media( *this, getInternalPtr<libvlc_media_t>( md ) ) == 0;
     }
 
+    /**
+     * Adds a range of medias, taking the MediaList lock once. The MediaList
+     * lock should NOT be held upon entering this function.
+     *
+     * \param first, last The medias to add: Media, MediaPtr or UniqueMedia
+     *
+     * \return The number of medias added, which is lower than the range size
+     *         if the list is read-only
+     */
+    template <typename Iterator>
+    int addMedias(Iterator first, Iterator last)
+    {
+        Lock lock( *this );
+        int res = 0;
+        for ( ; first != last; ++first )
+        {
+            if ( libvlc_media_list_add_media( *this, mediaOf( *first ) ) != 0 )
+                break;
+            ++res;
+        }
+        return res;
+    }
+
+    template <typename Container>
+    int addMedias(const Container& medias)
+    {
+        return addMedias( std::begin( medias ), std::end( medias ) );
+    }
+
     /**
      * Insert media instance in media list on a position The
      * MediaList lock should be held upon entering this function.
@@ -166,6 +198,32 @@ public:
         return libvlc_media_list_remove_index( *this, i_pos ) == 0;
     }
 
+    /**
+     * Removes \p count medias starting at \p pos, taking the MediaList lock
+     * once. The MediaList lock should NOT be held upon entering this
+     * function.
+     *
+     * \return The number of medias removed
+     */
+    int removeRange(int pos, int count)
+    {
+        Lock lock( *this );
+        auto size = libvlc_media_list_count( *this );
+        if ( pos < 0 || pos >= size || count <= 0 )
+            return 0;
+        if ( count > size - pos )
+            count = size - pos;
+        // From the end, so that the following items aren't moved repeatedly
+        int res = 0;
+        for ( auto i = pos + count - 1; i >= pos; --i )
+        {
+            if ( libvlc_media_list_remove_index( *this, i ) != 0 )
+                break;
+            ++res;
+        }
+        return res;
+    }
+
     /**
      * Get count on media list items The MediaList lock should be
      * held upon entering this function.
@@ -193,6 +251,33 @@ public:
         return std::make_shared<Media>( ptr, false );
     }
 
+    /**
+     * Same as itemAtIndex(), without sharing the media. The
+     * MediaList lock should be held upon entering this function.
+     *
+     * \return media instance at position i_pos, or an invalid handle if not
+     * found.
+     */
+    UniqueMedia itemAtIndexUnique(int i_pos)
+    {
+        return UniqueMedia( libvlc_media_list_item_at_index( *this, i_pos ) );
+    }
+
+    /**
+     * Returns all the medias, taking the MediaList lock once. The MediaList
+     * lock should NOT be held upon entering this function.
+     */
+    std::vector<UniqueMedia> snapshot()
+    {
+        Lock lock( *this );
+        std::vector<UniqueMedia> res;
+        auto size = libvlc_media_list_count( *this );
+        res.reserve( size > 0 ? static_cast<size_t>( size ) : 0 );
+        for ( auto i = 0; i < size; ++i )
+            res.emplace_back( libvlc_media_list_item_at_index( *this, i ) );
+        return res;
+    }
+
     /**
      * Find index position of List media instance in media list. Warning: the
      * function will return the first matched position. The
@@ -251,6 +336,19 @@ public:
         return *m_eventManager;
     }
 
+private:
+    template <typename T>
+    static libvlc_media_t* mediaOf(const T& md)
+    {
+        return getInternalPtr<libvlc_media_t>( md );
+    }
+
+    template <typename T>
+    static libvlc_media_t* mediaOf(const std::shared_ptr<T>& md)
+    {
+        return getInternalPtr<libvlc_media_t>( *md );
+    }
+
 private:
     std::shared_ptr<MediaListEventManager> m_eventManager;
 };
@@ -0,0 +1,252 @@
+/*****************************************************************************
+ * MediaListIndex.hpp: Constant time lookups of the MediaList items
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_MEDIALISTINDEX_H
+#define LIBVLC_CXX_MEDIALISTINDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common.hpp"
+#include "EventManager.hpp"
+#include "Media.hpp"
+#include "MediaList.hpp"
+
+namespace VLC
+{
+
+///
+/// \brief The MediaListIndex class maps the medias of a MediaList, and
+/// optionally their MRLs, to their position.
+///
+/// The index mirrors the list from its ItemAdded & ItemDeleted events, so
+/// that looking an item up doesn't go through libvlc's linear search:
+///
+///     VLC::MediaListIndex index( list );
+///     list.addMedias( medias );
+///     auto pos = index.indexOf( "file:///music/track.flac" );
+///
+/// Appending and removing the last items keeps the index up to date in
+/// constant time. Inserting or removing items elsewhere invalidates the
+/// positions of the following items, which are computed again, once, on the
+/// next lookup.
+///
+class MediaListIndex
+{
+public:
+    /**
+     * Indexes the current items of \p list, and keeps up with its changes.
+     * The MediaList lock should NOT be held upon entering this function.
+     *
+     * \param list      The list to index
+     * \param indexMrls Whether the items can be looked up by MRL, which
+     *                  costs a copy of each MRL
+     */
+    explicit MediaListIndex( MediaList list, bool indexMrls = true )
+        : m_list( std::move( list ) )
+        , m_indexMrls( indexMrls )
+        , m_dirtyFrom( Clean )
+        , m_stamp( 0 )
+    {
+        // Both the events and the initial content are read under the list
+        // lock, so that no change is missed nor accounted for twice
+        MediaList::Lock lock( m_list );
+        auto& em = m_list.eventManager();
+        m_added = em.onItemAddedUnique( [this]( UniqueMedia md, int pos ) {
+            std::lock_guard<std::mutex> l( m_mutex );
+            onAdded( md.get(), static_cast<size_t>( pos ) );
+        });
+        m_deleted = em.onItemDeletedUnique( [this]( UniqueMedia md, int pos ) {
+            std::lock_guard<std::mutex> l( m_mutex );
+            onDeleted( md.get(), static_cast<size_t>( pos ) );
+        });
+        auto size = libvlc_media_list_count( m_list );
+        std::lock_guard<std::mutex> l( m_mutex );
+        m_items.reserve( size > 0 ? static_cast<size_t>( size ) : 0 );
+        for ( auto i = 0; i < size; ++i )
+        {
+            UniqueMedia md( libvlc_media_list_item_at_index( m_list, i ) );
+            onAdded( md.get(), static_cast<size_t>( i ) );
+        }
+    }
+
+    ~MediaListIndex()
+    {
+        m_list.eventManager().unregister( m_added, m_deleted );
+    }
+
+    MediaListIndex( const MediaListIndex& ) = delete;
+    MediaListIndex& operator=( const MediaListIndex& ) = delete;
+
+    /**
+     * Same as MediaList::indexOfItem(), without the MediaList lock
+     *
+     * \return The position of the first occurrence of \p md, or -1
+     */
+    int indexOf( const Media& md )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        refresh();
+        auto it = m_entries.find( getInternalPtr<libvlc_media_t>( md ) );
+        if ( it == end( m_entries ) )
+            return -1;
+        return static_cast<int>( it->second.pos );
+    }
+
+    /**
+     * \return The position of the first media with this MRL, or -1. This
+     *         always fails if the MRLs aren't indexed.
+     */
+    int indexOf( const std::string& mrl )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        auto it = m_mrls.find( mrl );
+        if ( it == end( m_mrls ) )
+            return -1;
+        refresh();
+        auto res = Clean;
+        for ( auto md : it->second )
+            res = std::min( res, m_entries[md].pos );
+        return res != Clean ? static_cast<int>( res ) : -1;
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return m_items.size();
+    }
+
+private:
+    static const size_t Clean = std::numeric_limits<size_t>::max();
+
+    struct Entry
+    {
+        // The first occurrence, or Clean if it must be looked for again
+        size_t pos;
+        size_t count;
+        // The refresh() pass which last set pos
+        uint64_t stamp;
+    };
+
+    void onAdded( libvlc_media_t* md, size_t pos )
+    {
+        if ( md == nullptr || pos > m_items.size() )
+            return;
+        m_items.insert( begin( m_items ) + pos, md );
+        auto it = m_entries.find( md );
+        if ( it == end( m_entries ) )
+        {
+            m_entries.emplace( md, Entry{ pos, 1, 0 } );
+            if ( m_indexMrls == true )
+            {
+                auto mrl = wrapCStr( libvlc_media_get_mrl( md ) );
+                if ( mrl != nullptr )
+                    m_mrls[mrl.get()].push_back( md );
+            }
+        }
+        else
+            ++it->second.count;
+        if ( pos + 1 < m_items.size() )
+            invalidate( pos );
+    }
+
+    void onDeleted( libvlc_media_t* md, size_t pos )
+    {
+        if ( pos >= m_items.size() || m_items[pos] != md )
+            return;
+        m_items.erase( begin( m_items ) + pos );
+        auto it = m_entries.find( md );
+        if ( it != end( m_entries ) )
+        {
+            auto& e = it->second;
+            if ( --e.count == 0 )
+            {
+                m_entries.erase( it );
+                eraseMrl( md );
+            }
+            else if ( e.pos == pos )
+                e.pos = Clean;
+        }
+        if ( pos < m_items.size() )
+            invalidate( pos );
+    }
+
+    void eraseMrl( libvlc_media_t* md )
+    {
+        if ( m_indexMrls == false )
+            return;
+        auto mrl = wrapCStr( libvlc_media_get_mrl( md ) );
+        if ( mrl == nullptr )
+            return;
+        auto it = m_mrls.find( mrl.get() );
+        if ( it == end( m_mrls ) )
+            return;
+        auto& medias = it->second;
+        medias.erase( std::remove( begin( medias ), end( medias ), md ), end( medias ) );
+        if ( medias.empty() == true )
+            m_mrls.erase( it );
+    }
+
+    void invalidate( size_t pos )
+    {
+        m_dirtyFrom = std::min( m_dirtyFrom, pos );
+    }
+
+    // Computes the first occurrence of the items whose position may have
+    // changed. The positions before m_dirtyFrom are still valid.
+    void refresh()
+    {
+        if ( m_dirtyFrom == Clean )
+            return;
+        ++m_stamp;
+        for ( auto i = m_dirtyFrom; i < m_items.size(); ++i )
+        {
+            auto& e = m_entries[m_items[i]];
+            if ( ( e.pos == Clean || e.pos >= m_dirtyFrom ) && e.stamp != m_stamp )
+            {
+                e.pos = i;
+                e.stamp = m_stamp;
+            }
+        }
+        m_dirtyFrom = Clean;
+    }
+
+private:
+    MediaList m_list;
+    const bool m_indexMrls;
+    EventManager::Handle m_added;
+    EventManager::Handle m_deleted;
+    mutable std::mutex m_mutex;
+    // The list items, which the list keeps alive
+    std::vector<libvlc_media_t*> m_items;
+    std::unordered_map<libvlc_media_t*, Entry> m_entries;
+    std::unordered_map<std::string, std::vector<libvlc_media_t*>> m_mrls;
+    size_t m_dirtyFrom;
+    uint64_t m_stamp;
+};
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_MEDIALISTINDEX_H
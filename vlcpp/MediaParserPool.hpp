@@ -0,0 +1,586 @@
+/*****************************************************************************
+ * MediaParserPool.hpp: Concurrent batch media parser
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_MEDIAPARSERPOOL_H
+#define LIBVLC_CXX_MEDIAPARSERPOOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "Instance.hpp"
+#include "Media.hpp"
+#include "EventManager.hpp"
+
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
+
+namespace VLC
+{
+
+///
+/// \brief The MediaParserPool class parses a stream of medias, with a bounded
+/// number of concurrent parses.
+///
+/// Medias are submitted, either as MRLs or MediaPtr, and parsed in submission
+/// order on one or several instances. Each parse is bounded by a timeout. The
+/// results are pushed to a completion queue, from which the application pops
+/// them from any thread:
+///
+///     VLC::MediaParserPool::Config config;
+///     config.maxInFlightPerInstance = 32;
+///     VLC::MediaParserPool pool( { instance }, config );
+///     for ( const auto& mrl : mrls )
+///         pool.submit( mrl );
+///     VLC::MediaParserPool::Result res;
+///     while ( pool.waitPop( res, std::chrono::seconds( 10 ) ) )
+///         index( res );
+///
+/// The scheduling is done by an internal thread, which is also responsible
+/// for collecting the results, so the libvlc preparser threads never wait
+/// for the application.
+///
+class MediaParserPool
+{
+public:
+    struct Config
+    {
+        Config()
+            : flags( Media::ParseFlags::Local )
+            , timeout( 5000 )
+            , maxInFlightPerInstance( 8 )
+            , maxPendingResults( 0 )
+            , fetchTracks( true )
+            , fetchMeta( true )
+        {
+        }
+
+        /// Parse options, passed to libvlc for each media
+        Media::ParseFlags flags;
+        /// Maximum time allowed to parse a media. 0 waits indefinitely.
+        std::chrono::milliseconds timeout;
+        /// Maximum number of concurrent parses, for each instance
+        unsigned int maxInFlightPerInstance;
+        /// When not 0, no new parse is started while this many results are
+        /// waiting to be popped
+        size_t maxPendingResults;
+        /// Collect the tracks & meta in the results
+        bool fetchTracks;
+        bool fetchMeta;
+    };
+
+    struct Result
+    {
+        Result()
+            : id( 0 )
+            , status( Media::ParsedStatus::Failed )
+            , duration( -1 )
+            , queueTime( 0 )
+            , parseTime( 0 )
+        {
+        }
+
+        /// The identifier returned by submit()
+        uint64_t id;
+        /// The submitted MRL, empty when a MediaPtr was submitted
+        std::string mrl;
+        /// The parsed media. Can be nullptr if it couldn't be created.
+        MediaPtr media;
+        Media::ParsedStatus status;
+        /// Duration in ms, or -1 if unknown
+        libvlc_time_t duration;
+        std::vector<MediaTrack> tracks;
+        /// The non-empty meta
+        std::vector<std::pair<libvlc_meta_t, std::string>> meta;
+        /// Time spent waiting for a parse slot
+        std::chrono::microseconds queueTime;
+        /// Time spent parsing
+        std::chrono::microseconds parseTime;
+    };
+
+    struct Stats
+    {
+        Stats()
+            : nbSubmitted( 0 )
+            , nbCompleted( 0 )
+            , nbFailed( 0 )
+            , nbTimedOut( 0 )
+            , nbQueued( 0 )
+            , nbInFlight( 0 )
+            , throughput( 0. )
+            , averageParseTime( 0 )
+            , maxParseTime( 0 )
+        {
+        }
+
+        uint64_t nbSubmitted;
+        /// Number of results produced, successful or not
+        uint64_t nbCompleted;
+        uint64_t nbFailed;
+        uint64_t nbTimedOut;
+        /// Number of submitted medias waiting for a parse slot
+        size_t nbQueued;
+        size_t nbInFlight;
+        /// Completed parses per second, since the first submission
+        double throughput;
+        std::chrono::microseconds averageParseTime;
+        std::chrono::microseconds maxParseTime;
+    };
+
+    /**
+     * \param instances The instances to parse with. The parses are balanced
+     *                  across all of them.
+     * \param config    The pool configuration
+     * \throw std::invalid_argument if no instance is provided
+     */
+    explicit MediaParserPool( std::vector<Instance> instances, Config config = Config{} )
+        : m_config( std::move( config ) )
+        , m_nbInFlight( instances.size(), 0u )
+        , m_instances( std::move( instances ) )
+        , m_nextId( 0 )
+        , m_stop( false )
+        , m_totalInFlight( 0 )
+        , m_totalParseTime( 0 )
+    {
+        if ( m_instances.empty() == true )
+            throw std::invalid_argument( "MediaParserPool requires at least one instance" );
+        if ( m_config.maxInFlightPerInstance == 0 )
+            m_config.maxInFlightPerInstance = 1;
+        m_thread = std::thread( &MediaParserPool::run, this );
+    }
+
+    /**
+     * Stops the pending parses. Results that weren't popped yet are discarded.
+     */
+    ~MediaParserPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        m_resultCond.notify_all();
+        m_thread.join();
+        for ( auto& p : m_parsing )
+        {
+            stopParse( p.second );
+            // Once unregistered, our handler can't be running anymore
+            p.second.media->eventManager().unregister( p.second.handle );
+        }
+    }
+
+    MediaParserPool( const MediaParserPool& ) = delete;
+    MediaParserPool& operator=( const MediaParserPool& ) = delete;
+
+    /**
+     * Queues a media to be parsed.
+     *
+     * \param mrl   A location, or a path, depending on \p type
+     * \return The identifier of the request, provided in the Result
+     */
+    uint64_t submit( std::string mrl, Media::FromType type = Media::FromLocation )
+    {
+        Request req;
+        req.mrl = std::move( mrl );
+        req.type = type;
+        return submit( std::move( req ) );
+    }
+
+    uint64_t submit( MediaPtr media )
+    {
+        if ( media == nullptr )
+            throw std::invalid_argument( "Can't parse a null media" );
+        Request req;
+        req.media = std::move( media );
+        return submit( std::move( req ) );
+    }
+
+    /**
+     * Pops a completed result, if any
+     */
+    bool tryPop( Result& result )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return popLocked( result );
+    }
+
+    /**
+     * Waits up to \p timeout for a result to be available.
+     *
+     * \return false if the wait timed out
+     */
+    template <typename Rep, typename Period>
+    bool waitPop( Result& result, std::chrono::duration<Rep, Period> timeout )
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_resultCond.wait_for( lock, timeout, [this]() {
+            return m_results.empty() == false || m_stop == true;
+        });
+        return popLocked( result );
+    }
+
+    /**
+     * Waits until all the submitted medias have been parsed, and their results
+     * popped, or until \p timeout expires.
+     *
+     * \return true if the pool is idle
+     */
+    template <typename Rep, typename Period>
+    bool waitIdle( std::chrono::duration<Rep, Period> timeout )
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        return m_resultCond.wait_for( lock, timeout, [this]() {
+            return m_queue.empty() == true && m_totalInFlight == 0 &&
+                    m_results.empty() == true;
+        });
+    }
+
+    /**
+     * Discards the submitted medias which aren't being parsed yet.
+     *
+     * \return The number of discarded requests
+     */
+    size_t cancelPending()
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        auto nbCancelled = m_queue.size();
+        m_queue.clear();
+        m_resultCond.notify_all();
+        return nbCancelled;
+    }
+
+    Stats stats() const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        auto res = m_stats;
+        res.nbQueued = m_queue.size();
+        res.nbInFlight = m_totalInFlight;
+        if ( res.nbCompleted > 0 )
+        {
+            res.averageParseTime = std::chrono::microseconds( m_totalParseTime / res.nbCompleted );
+            auto elapsed = std::chrono::duration<double>( Clock::now() - m_firstSubmission ).count();
+            if ( elapsed > 0. )
+                res.throughput = res.nbCompleted / elapsed;
+        }
+        return res;
+    }
+
+    const Config& config() const
+    {
+        return m_config;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Request
+    {
+        Request()
+            : id( 0 )
+            , type( Media::FromLocation )
+        {
+        }
+
+        uint64_t id;
+        std::string mrl;
+        Media::FromType type;
+        MediaPtr media;
+        Clock::time_point submitted;
+    };
+
+    struct InFlight
+    {
+        Request request;
+        MediaPtr media;
+        size_t instanceIdx;
+        EventManager::Handle handle;
+        Clock::time_point started;
+    };
+
+    struct Completion
+    {
+        uint64_t id;
+        Media::ParsedStatus status;
+    };
+
+    uint64_t submit( Request req )
+    {
+        uint64_t id;
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            id = req.id = ++m_nextId;
+            req.submitted = Clock::now();
+            if ( m_stats.nbSubmitted++ == 0 )
+                m_firstSubmission = req.submitted;
+            m_queue.push_back( std::move( req ) );
+        }
+        m_cond.notify_one();
+        return id;
+    }
+
+    bool popLocked( Result& result )
+    {
+        if ( m_results.empty() == true )
+            return false;
+        result = std::move( m_results.front() );
+        m_results.pop_front();
+        // Some room was made for new parses
+        if ( m_config.maxPendingResults != 0 )
+            m_cond.notify_one();
+        if ( m_results.empty() == true )
+            m_resultCond.notify_all();
+        return true;
+    }
+
+    // Must be called with the lock held
+    bool canStart() const
+    {
+        if ( m_queue.empty() == true )
+            return false;
+        if ( m_totalInFlight >= m_config.maxInFlightPerInstance * m_instances.size() )
+            return false;
+        return m_config.maxPendingResults == 0 ||
+                m_results.size() + m_totalInFlight < m_config.maxPendingResults;
+    }
+
+    // Picks the least loaded instance. Must be called with the lock held
+    size_t pickInstance() const
+    {
+        size_t res = 0;
+        for ( size_t i = 1; i < m_nbInFlight.size(); ++i )
+        {
+            if ( m_nbInFlight[i] < m_nbInFlight[res] )
+                res = i;
+        }
+        return res;
+    }
+
+    // Called from libvlc's preparser thread
+    void onParsed( uint64_t id, Media::ParsedStatus status )
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_completions.push_back( Completion{ id, status } );
+        }
+        m_cond.notify_one();
+    }
+
+    bool startParse( InFlight& p )
+    {
+        auto timeout = static_cast<int>( m_config.timeout.count() );
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        return p.media->parseRequest( m_instances[p.instanceIdx], m_config.flags, timeout );
+#else
+        return p.media->parseWithOptions( m_config.flags, timeout );
+#endif
+    }
+
+    void stopParse( InFlight& p )
+    {
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        p.media->parseStop( m_instances[p.instanceIdx] );
+#else
+        p.media->parseStop();
+#endif
+    }
+
+    void run()
+    {
+        std::vector<Request> toStart;
+        std::vector<Completion> completions;
+        std::unique_lock<std::mutex> lock( m_mutex );
+        for ( ;; )
+        {
+            m_cond.wait( lock, [this]() {
+                return m_stop == true || m_completions.empty() == false || canStart() == true;
+            });
+            if ( m_stop == true )
+                return;
+            completions.assign( m_completions.begin(), m_completions.end() );
+            m_completions.clear();
+            std::vector<size_t> instanceIdx;
+            while ( canStart() == true )
+            {
+                auto idx = pickInstance();
+                ++m_nbInFlight[idx];
+                ++m_totalInFlight;
+                instanceIdx.push_back( idx );
+                toStart.push_back( std::move( m_queue.front() ) );
+                m_queue.pop_front();
+            }
+            // Don't hold the lock while calling into libvlc: the preparser
+            // thread might be waiting for it to report a completion.
+            lock.unlock();
+            for ( const auto& c : completions )
+                complete( c.id, c.status );
+            for ( size_t i = 0; i < toStart.size(); ++i )
+                start( std::move( toStart[i] ), instanceIdx[i] );
+            toStart.clear();
+            completions.clear();
+            lock.lock();
+        }
+    }
+
+    void start( Request req, size_t instanceIdx )
+    {
+        InFlight p;
+        p.instanceIdx = instanceIdx;
+        p.started = Clock::now();
+        try
+        {
+            if ( req.media != nullptr )
+                p.media = req.media;
+            else
+            {
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+                p.media = std::make_shared<Media>( req.mrl, req.type );
+#else
+                p.media = std::make_shared<Media>( m_instances[instanceIdx], req.mrl, req.type );
+#endif
+            }
+        }
+        catch ( const std::runtime_error& )
+        {
+        }
+        p.request = std::move( req );
+        if ( p.media == nullptr )
+        {
+            finish( p, Media::ParsedStatus::Failed );
+            return;
+        }
+#if LIBVLC_VERSION_INT < LIBVLC_VERSION(4, 0, 0, 0)
+        // libvlc 3 only parses a media once, and won't report anything again
+        auto status = p.media->parsedStatus();
+        if ( static_cast<int>( status ) != 0 )
+        {
+            finish( p, status );
+            return;
+        }
+#endif
+        auto id = p.request.id;
+        p.handle = p.media->eventManager().onParsedChanged( [this, id]( Media::ParsedStatus status ) {
+            onParsed( id, status );
+        });
+        auto& inserted = m_parsing.emplace( id, std::move( p ) ).first->second;
+        if ( startParse( inserted ) == false )
+            complete( id, Media::ParsedStatus::Failed );
+    }
+
+    void complete( uint64_t id, Media::ParsedStatus status )
+    {
+        auto it = m_parsing.find( id );
+        if ( it == end( m_parsing ) )
+            return;
+        auto p = std::move( it->second );
+        m_parsing.erase( it );
+        p.media->eventManager().unregister( p.handle );
+        finish( p, status );
+    }
+
+    void finish( InFlight& p, Media::ParsedStatus status )
+    {
+        Result res;
+        res.id = p.request.id;
+        res.mrl = std::move( p.request.mrl );
+        res.status = status;
+        res.queueTime = std::chrono::duration_cast<std::chrono::microseconds>( p.started - p.request.submitted );
+        res.parseTime = std::chrono::duration_cast<std::chrono::microseconds>( Clock::now() - p.started );
+        if ( p.media != nullptr && status == Media::ParsedStatus::Done )
+        {
+            res.duration = p.media->duration();
+            if ( m_config.fetchTracks == true )
+                fetchTracks( *p.media, res.tracks );
+            if ( m_config.fetchMeta == true )
+            {
+                for ( int m = libvlc_meta_Title; m <= libvlc_meta_DiscTotal; ++m )
+                {
+                    auto value = p.media->meta( static_cast<libvlc_meta_t>( m ) );
+                    if ( value.empty() == false )
+                        res.meta.emplace_back( static_cast<libvlc_meta_t>( m ), std::move( value ) );
+                }
+            }
+        }
+        res.media = std::move( p.media );
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+        --m_nbInFlight[p.instanceIdx];
+        --m_totalInFlight;
+        ++m_stats.nbCompleted;
+        if ( status == Media::ParsedStatus::Timeout )
+            ++m_stats.nbTimedOut;
+        else if ( status != Media::ParsedStatus::Done )
+            ++m_stats.nbFailed;
+        m_totalParseTime += res.parseTime.count();
+        if ( res.parseTime > m_stats.maxParseTime )
+            m_stats.maxParseTime = res.parseTime;
+        m_results.push_back( std::move( res ) );
+        m_resultCond.notify_all();
+    }
+
+    static void fetchTracks( Media& media, std::vector<MediaTrack>& tracks )
+    {
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        for ( auto type : { MediaTrack::Type::Audio, MediaTrack::Type::Video, MediaTrack::Type::Subtitle } )
+        {
+            auto t = media.tracks( type );
+            tracks.insert( end( tracks ), std::make_move_iterator( begin( t ) ),
+                           std::make_move_iterator( end( t ) ) );
+        }
+#else
+        tracks = media.tracks();
+#endif
+    }
+
+private:
+    Config m_config;
+    // Only accessed with m_mutex held
+    std::vector<size_t> m_nbInFlight;
+    std::vector<Instance> m_instances;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::condition_variable m_resultCond;
+    std::deque<Request> m_queue;
+    std::vector<Completion> m_completions;
+    std::deque<Result> m_results;
+    uint64_t m_nextId;
+    bool m_stop;
+    size_t m_totalInFlight;
+    Stats m_stats;
+    int64_t m_totalParseTime;
+    Clock::time_point m_firstSubmission;
+
+    // Only accessed from the worker thread, and after it's joined
+    std::unordered_map<uint64_t, InFlight> m_parsing;
+    std::thread m_thread;
+};
+
+} // namespace VLC
+
+#endif
+
+#endif // LIBVLC_CXX_MEDIAPARSERPOOL_H
@@ -30,6 +30,9 @@
 #include <memory>
 
 #include "common.hpp"
+#include "AudioSink.hpp"
+#include "VideoConverter.hpp"
+#include "VideoFramePool.hpp"
 
 namespace VLC
 {
@@ -75,6 +78,12 @@ private:
         VideoFrameMetadata,
         VideoOutputSelectPlane,
     };
+    static_assert( static_cast<size_t>( CallbackIdx::VideoOutputSelectPlane ) + 1 == NbCallbacks,
+                   "CallbackIdx must match the callback array" );
+#ifdef LIBVLCPP_INSTRUMENT_CALLBACKS
+    static_assert( NbCallbacks == instrumentation::detail::NbMediaPlayerCallbacks,
+                   "The instrumentation names must follow CallbackIdx" );
+#endif
 public:
 #if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
     enum class DeinterlaceState : signed char
@@ -85,6 +94,46 @@ public:
     };
 #endif
 
+    ///
+    /// \brief The Snapshot struct gathers the commonly polled player state.
+    ///
+    /// It's trivially copyable, so that it can be shared lock-free, see
+    /// PlayerStateMonitor.
+    ///
+    struct Snapshot
+    {
+        Snapshot()
+            : time( -1 )
+            , length( -1 )
+            , position( -1.f )
+            , rate( 1.f )
+            , buffering( 0.f )
+            , volume( -1 )
+            , state( libvlc_NothingSpecial )
+            , isPlaying( false )
+            , isSeekable( false )
+            , canPause( false )
+            , mute( false )
+        {
+        }
+
+        /// In ms, or -1 if there is no media
+        libvlc_time_t time;
+        libvlc_time_t length;
+        /// Between 0 and 1, or -1 if there is no media
+        float position;
+        float rate;
+        /// The latest buffering progress, in percent
+        float buffering;
+        /// In percent, or -1 if there is no audio output
+        int volume;
+        libvlc_state_t state;
+        bool isPlaying;
+        bool isSeekable;
+        bool canPause;
+        bool mute;
+    };
+
     /**
      * Check if 2 MediaPlayer objects contain the same libvlc_media_player_t.
      * \param another another MediaPlayer
@@ -165,6 +214,17 @@ public:
         return std::make_shared<Media>( media, false );
     }
 
+    /**
+     * Get the media used by the media_player, without sharing it.
+     *
+     * \return the media associated with p_mi, or an invalid handle if no
+     * media is associated
+     */
+    UniqueMedia mediaUnique()
+    {
+        return UniqueMedia( libvlc_media_player_get_media( *this ) );
+    }
+
     /**
      * Get the Event Manager from which the media player send event.
      *
@@ -547,6 +607,30 @@ public:
         return libvlc_media_player_get_state(*this);
     }
 
+    /**
+     * Get the commonly polled state at once.
+     *
+     * Each field is still queried from libvlc. To poll many players, prefer
+     * a PlayerStateMonitor, which is kept up to date by the player events.
+     *
+     * \note The buffering progress is only provided by the monitor.
+     */
+    Snapshot snapshot()
+    {
+        Snapshot res;
+        res.time = time();
+        res.length = length();
+        res.position = position();
+        res.rate = rate();
+        res.volume = volume();
+        res.state = state();
+        res.isPlaying = isPlaying();
+        res.isSeekable = isSeekable();
+        res.canPause = canPause();
+        res.mute = mute();
+        return res;
+    }
+
 #if LIBVLC_VERSION_INT < LIBVLC_VERSION(3, 0, 0, 0)
     /**
      * Get movie fps rate
@@ -733,6 +817,26 @@ public:
         return libvlc_media_player_set_equalizer( *this, nullptr ) == 0;
     }
 
+    /**
+     * Sets a hook invoked the first time each libvlc thread calls one of the
+     * audio or video callbacks of this player, before the callback itself.
+     *
+     * \param hook A std::function<void(CallbackThread)> (or an equivalent
+     *             Callable type), or nullptr to remove the hook. It's given
+     *             CallbackThread::Audio or CallbackThread::Video.
+     *
+     * \note The hook can be replaced at any time: each thread then runs the
+     *       new one before its next callback. Copies of this player share
+     *       the hook.
+     */
+    void setCallbackThreadHook( CallbackThreadHook hook )
+    {
+        setThreadHook( std::move( hook ), []( size_t idx ) {
+            return idx < (size_t)CallbackIdx::VideoLock ? CallbackThread::Audio
+                                                        : CallbackThread::Video;
+        });
+    }
+
     /**
      * Set callbacks and private data for decoded audio. Use
      * MediaPlayer::setFormat() or MediaPlayer::setFormatCallbacks() to configure the
@@ -791,7 +895,7 @@ public:
     {
         static_assert(signature_match_or_nullptr<VolumeCb, void(float, bool)>::value, "Mismatched set volume callback");
         libvlc_audio_set_volume_callback(*this,
-            CallbackWrapper<(unsigned int)CallbackIdx::AudioVolume, libvlc_audio_set_volume_cb>::wrap( this, std::forward<VolumeCb>( func ) ) );
+            CallbackWrapper<(unsigned int)CallbackIdx::AudioVolume, libvlc_audio_set_volume_cb>::wrap( *m_callbacks, std::forward<VolumeCb>( func ) ) );
     }
 
     /**
@@ -814,8 +918,52 @@ public:
         static_assert(signature_match_or_nullptr<CleanupCb, void()>::value, "Mismatched cleanup callback");
 
         libvlc_audio_set_format_callbacks(*this,
-            CallbackWrapper<(unsigned int)CallbackIdx::AudioSetup, libvlc_audio_setup_cb>::wrap( this, std::forward<SetupCb>( setup ) ),
-            CallbackWrapper<(unsigned int)CallbackIdx::AudioCleanup, libvlc_audio_cleanup_cb>::wrap( this, std::forward<CleanupCb>( cleanup ) ) );
+            CallbackWrapper<(unsigned int)CallbackIdx::AudioSetup, libvlc_audio_setup_cb>::wrap( *m_callbacks, std::forward<SetupCb>( setup ) ),
+            CallbackWrapper<(unsigned int)CallbackIdx::AudioCleanup, libvlc_audio_cleanup_cb>::wrap( *m_callbacks, std::forward<CleanupCb>( cleanup ) ) );
+    }
+
+    /**
+     * Buffer the decoded audio in an AudioSink.
+     *
+     * This installs the audio format & audio callbacks (and the volume
+     * callback, if the sink was configured to handle the volume). The
+     * application then pulls samples from the sink, from its own thread.
+     *
+     * \param sink The sink receiving the samples
+     *
+     * \see AudioSink
+     */
+    void setAudioSink(std::shared_ptr<AudioSink> sink)
+    {
+        setAudioCallbacks(
+            [sink](const void* samples, uint32_t count, int64_t pts) {
+                sink->play( samples, count, pts );
+            },
+            [sink](int64_t pts) {
+                sink->pause( pts );
+            },
+            [sink](int64_t pts) {
+                sink->resume( pts );
+            },
+            [sink](int64_t pts) {
+                sink->flush( pts );
+            },
+            [sink]() {
+                sink->drain();
+            });
+        setAudioFormatCallbacks(
+            [sink](char* format, uint32_t* rate, uint32_t* channels) {
+                return sink->setup( format, rate, channels );
+            },
+            [sink]() {
+                sink->cleanup();
+            });
+        if ( sink->config().handleVolume == true )
+        {
+            setVolumeCallback([sink](float volume, bool mute) {
+                sink->setVolume( volume, mute );
+            });
+        }
     }
 
     /**
@@ -872,17 +1020,34 @@ public:
      */
     std::vector<AudioOutputDeviceDescription> outputDeviceEnum()
     {
-        auto devices = libvlc_audio_output_device_enum(*this);
-        if ( devices == nullptr )
-            return {};
         std::vector<AudioOutputDeviceDescription> res;
-        std::unique_ptr<libvlc_audio_output_device_t, decltype(&libvlc_audio_output_device_list_release)>
-                devicesPtr( devices, libvlc_audio_output_device_list_release);
-        for ( auto* p = devices; p != nullptr; p = p->p_next )
-            res.emplace_back( p );
+        outputDeviceEnum( res );
         return res;
     }
 
+    /**
+     * Appends the audio output devices to \p out, which can be any
+     * container of AudioOutputDeviceDescription providing emplace_back(),
+     * such as a reused vector or a std::pmr::vector.
+     */
+    template <typename Container>
+    void outputDeviceEnum( Container& out )
+    {
+        for ( const auto& d : outputDeviceEnumView() )
+            out.emplace_back( d.get() );
+    }
+
+    /**
+     * Returns the audio output devices, without copying their strings.
+     *
+     * \see DescriptionList
+     */
+    AudioOutputDeviceDescriptionList outputDeviceEnumView()
+    {
+        return AudioOutputDeviceDescriptionList( libvlc_audio_output_device_enum( *this ),
+                                                 &libvlc_audio_output_device_list_release );
+    }
+
     /**
      * Configures an explicit audio output device.
      *
@@ -1220,6 +1385,78 @@ public:
                 CallbackWrapper<(unsigned int)CallbackIdx::VideoCleanup, libvlc_video_cleanup_cb>::wrap( *m_callbacks, std::forward<CleanupCb>( cleanup ) ) );
     }
 
+    /**
+     * Render the decoded video into the buffers of a VideoFramePool.
+     *
+     * This installs both the video format and the video memory callbacks. The
+     * pool buffers are allocated once the format is known, and each displayed
+     * picture is handed to \p onFrame as a reference counted VideoFrame, without
+     * any copy or allocation.
+     *
+     * \param pool     The pool providing the picture buffers
+     * \param onFrame  Called from the video output thread for each displayed frame
+     *                 Expected prototype is void(VideoFrame frame)
+     *
+     * \see VideoFramePool
+     */
+    template <typename FrameCb>
+    void setVideoFramePool(std::shared_ptr<VideoFramePool> pool, FrameCb&& onFrame)
+    {
+        static_assert(signature_match<FrameCb, void(VideoFrame)>::value, "Mismatched frame callback signature");
+        using Handler = detail::VideoFramePoolHandler<typename std::decay<FrameCb>::type>;
+        auto handler = std::make_shared<Handler>( std::move( pool ), std::forward<FrameCb>( onFrame ) );
+
+        setVideoFormatCallbacks(
+            [handler](char* chroma, uint32_t* width, uint32_t* height, uint32_t* pitches, uint32_t* lines) {
+                return handler->pool->format( chroma, width, height, pitches, lines );
+            },
+            [handler]() {
+                handler->pool->cleanup();
+            });
+        setVideoCallbacks(
+            [handler](void** planes) {
+                return handler->pool->lock( planes );
+            },
+            [handler](void* picture, void* const* planes) {
+                handler->pool->unlock( picture, planes );
+            },
+            [handler](void* picture) {
+                handler->onFrame( handler->pool->display( picture ) );
+            });
+    }
+
+    /**
+     * Render the decoded video into the buffers of a VideoFramePool, and
+     * convert each displayed frame into the outputs of a VideoConverter.
+     *
+     * The pool should be configured to receive a 4:2:0 chroma the converter
+     * can read from, typically "I420". Frames in other chromas are dropped.
+     *
+     * \param pool       The pool providing the decoded picture buffers
+     * \param converter  The converter producing the output frames
+     * \param onFrames   Called from the video output thread for each displayed frame
+     *                   with one frame per converter output.
+     *                   Expected prototype is void(const std::vector<VideoFrame>& frames)
+     *
+     * \see VideoConverter
+     */
+    template <typename FramesCb>
+    void setVideoFramePool(std::shared_ptr<VideoFramePool> pool,
+                           std::shared_ptr<VideoConverter> converter, FramesCb&& onFrames)
+    {
+        static_assert(signature_match<FramesCb, void(const std::vector<VideoFrame>&)>::value,
+                      "Mismatched frames callback signature");
+        using Handler = detail::VideoConverterHandler<typename std::decay<FramesCb>::type>;
+        auto handler = std::make_shared<Handler>( std::move( converter ), std::forward<FramesCb>( onFrames ) );
+
+        setVideoFramePool( std::move( pool ), [handler](VideoFrame frame) {
+            if ( handler->converter->convert( frame, handler->frames ) == true )
+                handler->onFrames( handler->frames );
+            // Don't hold on the output frames until the next picture
+            handler->frames.clear();
+        });
+    }
+
 #if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
     /**
      * Set callbacks and data to render decoded video to a custom texture
@@ -2095,6 +2332,29 @@ public:
         return res;
     }
 
+    /**
+     * Returns the selected track of the given type, without sharing it.
+     *
+     * \return The track, or an invalid handle if none is selected. When
+     * several tracks are selected, the first one is returned.
+     */
+    UniqueMediaTrack selectedTrack( MediaTrack::Type type )
+    {
+        return UniqueMediaTrack( libvlc_media_player_get_selected_track( *this,
+                                    static_cast<libvlc_track_type_t>( type ) ) );
+    }
+
+    /**
+     * Returns the track with the given string identifier, without sharing it.
+     *
+     * \return The track, or an invalid handle if there is no such track
+     * \see MediaTrack::id()
+     */
+    UniqueMediaTrack trackFromIdUnique( const std::string& id )
+    {
+        return UniqueMediaTrack( libvlc_media_player_get_track_from_id( *this, id.c_str() ) );
+    }
+
     void selectTracks( MediaTrack::Type type, const std::vector<MediaTrack>& tracks )
     {
         std::vector<const libvlc_media_track_t*> ctracks{};
@@ -0,0 +1,414 @@
+/*****************************************************************************
+ * MediaPlayerPool.hpp: Pool of preconfigured media players
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_MEDIAPLAYERPOOL_H
+#define LIBVLC_CXX_MEDIAPLAYERPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "Instance.hpp"
+#include "Media.hpp"
+#include "MediaPlayer.hpp"
+
+namespace VLC
+{
+
+///
+/// \brief The MediaPlayerPool class keeps media players ready to be used,
+/// with their callbacks, event handlers and options already bound.
+///
+/// Players are created upfront, configured once by the setup function, and
+/// leased for a media. When a lease is released, the player is stopped and
+/// reset from a background thread, and goes back to the pool for the next
+/// media, keeping its configuration:
+///
+///     VLC::MediaPlayerPool pool( instance, 2, []( VLC::MediaPlayer& mp ) {
+///         mp.setVideoFramePool( framePool, onFrame );
+///         mp.eventManager().onEncounteredError( onError );
+///     });
+///     auto lease = pool.acquire( channel );
+///     lease->play();
+///     pool.prebuffer( nextChannel );
+///
+/// A media can be prebuffered on an idle player: it is opened and paused on
+/// its first frame, so that acquiring it later only has to resume playback.
+///
+/// Since the players are reused, their event handlers are shared by every
+/// media they play. The setup function should only register handlers that
+/// don't depend on a specific media.
+///
+class MediaPlayerPool
+{
+public:
+    /// Configures a newly created player
+    using Setup = std::function<void(MediaPlayer&)>;
+    /// Restores a player state, after it was stopped and before it's reused
+    using Reset = std::function<void(MediaPlayer&)>;
+
+private:
+    struct Slot
+    {
+        MediaPlayer player;
+        // The prebuffered media, if any
+        std::unique_ptr<Media> media;
+        std::string mrl;
+    };
+
+    // Outlives the pool while some players are leased
+    struct State
+    {
+        State( Instance i, size_t c, Setup s, Reset r )
+            : instance( std::move( i ) )
+            , capacity( c )
+            , setup( std::move( s ) )
+            , reset( std::move( r ) )
+            , closed( false )
+        {
+        }
+
+        std::unique_ptr<Slot> create()
+        {
+            std::unique_ptr<Slot> slot( new Slot{ MediaPlayer( instance ), nullptr, std::string{} } );
+            if ( setup != nullptr )
+                setup( slot->player );
+            return slot;
+        }
+
+        void recycle( std::unique_ptr<Slot> slot )
+        {
+            std::unique_lock<std::mutex> lock( mutex );
+            if ( closed == false )
+            {
+                toReset.push_back( std::move( slot ) );
+                cond.notify_one();
+                return;
+            }
+            // Releasing the player stops it
+            lock.unlock();
+            slot.reset();
+        }
+
+        const Instance instance;
+        const size_t capacity;
+        const Setup setup;
+        const Reset reset;
+        std::mutex mutex;
+        std::condition_variable cond;
+        bool closed;
+        // Idle players, without media
+        std::vector<std::unique_ptr<Slot>> idle;
+        // Oldest first
+        std::deque<std::unique_ptr<Slot>> prebuffered;
+        std::deque<std::unique_ptr<Slot>> toReset;
+    };
+
+public:
+    ///
+    /// \brief The Lease class grants exclusive use of a pooled player, until
+    /// it's released or destroyed.
+    ///
+    class Lease
+    {
+    public:
+        Lease()
+            : m_prebuffered( false )
+        {
+        }
+
+        Lease( Lease&& ) = default;
+
+        Lease& operator=( Lease&& other )
+        {
+            if ( this != &other )
+            {
+                release();
+                m_state = std::move( other.m_state );
+                m_slot = std::move( other.m_slot );
+                m_prebuffered = other.m_prebuffered;
+            }
+            return *this;
+        }
+
+        ~Lease()
+        {
+            release();
+        }
+
+        bool isValid() const
+        {
+            return m_slot != nullptr;
+        }
+
+        MediaPlayer& player()
+        {
+            return m_slot->player;
+        }
+
+        MediaPlayer* operator->()
+        {
+            return &m_slot->player;
+        }
+
+        /// Returns true if the media was prebuffered, and is paused on its
+        /// first frame
+        bool wasPrebuffered() const
+        {
+            return m_prebuffered;
+        }
+
+        /// Hands the player back to the pool. The lease becomes invalid
+        void release()
+        {
+            if ( m_slot == nullptr )
+                return;
+            m_state->recycle( std::move( m_slot ) );
+            m_state.reset();
+        }
+
+    private:
+        Lease( std::shared_ptr<State> state, std::unique_ptr<Slot> slot, bool prebuffered )
+            : m_state( std::move( state ) )
+            , m_slot( std::move( slot ) )
+            , m_prebuffered( prebuffered )
+        {
+        }
+
+    private:
+        std::shared_ptr<State> m_state;
+        std::unique_ptr<Slot> m_slot;
+        bool m_prebuffered;
+
+        friend class MediaPlayerPool;
+    };
+
+    /**
+     * \param instance The instance to create the players from
+     * \param size     The number of players to keep. When all of them are
+     *                 leased, new ones are created on demand, and are only
+     *                 kept if there is room for them when released.
+     * \param setup    Configures each new player
+     * \param reset    Optionally restores a player state when it's released
+     * \param maxPrebuffered The maximum number of prebuffered medias
+     */
+    MediaPlayerPool( Instance instance, size_t size, Setup setup, Reset reset = nullptr,
+                     size_t maxPrebuffered = 1 )
+        : m_state( std::make_shared<State>( std::move( instance ), size == 0 ? 1 : size,
+                                            std::move( setup ), std::move( reset ) ) )
+        , m_maxPrebuffered( maxPrebuffered )
+    {
+        for ( size_t i = 0; i < m_state->capacity; ++i )
+            m_state->idle.push_back( m_state->create() );
+        m_thread = std::thread( &MediaPlayerPool::run, m_state );
+    }
+
+    /// Leases that are still held stop their player on release
+    ~MediaPlayerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_state->mutex );
+            m_state->closed = true;
+        }
+        m_state->cond.notify_all();
+        m_thread.join();
+        // The reset thread stopped the pending players. The prebuffered ones
+        // are stopped when released.
+        m_state->prebuffered.clear();
+        m_state->idle.clear();
+    }
+
+    MediaPlayerPool( const MediaPlayerPool& ) = delete;
+    MediaPlayerPool& operator=( const MediaPlayerPool& ) = delete;
+
+    /**
+     * Leases a player for \p media.
+     *
+     * If the media was prebuffered, its player is returned, paused on the
+     * first frame. Otherwise, the media is set on an idle player, which
+     * isn't started.
+     */
+    Lease acquire( Media media )
+    {
+        auto mrl = media.mrl();
+        std::unique_ptr<Slot> slot;
+        {
+            std::lock_guard<std::mutex> lock( m_state->mutex );
+            auto& prebuffered = m_state->prebuffered;
+            for ( auto it = prebuffered.begin(); it != prebuffered.end(); ++it )
+            {
+                if ( (*it)->mrl != mrl )
+                    continue;
+                slot = std::move( *it );
+                prebuffered.erase( it );
+                break;
+            }
+            if ( slot != nullptr )
+            {
+                slot->mrl.clear();
+                return Lease( m_state, std::move( slot ), true );
+            }
+            slot = takeIdle();
+        }
+        if ( slot == nullptr )
+            slot = m_state->create();
+        slot->player.setMedia( media );
+        return Lease( m_state, std::move( slot ), false );
+    }
+
+    /**
+     * Opens \p media on an idle player, and pauses it on its first frame.
+     *
+     * When the maximum number of prebuffered medias is reached, the oldest
+     * one is dropped.
+     *
+     * \return false if there is no idle player without a prebuffered media,
+     *         or if prebuffering is disabled
+     */
+    bool prebuffer( Media media )
+    {
+        if ( m_maxPrebuffered == 0 )
+            return false;
+        auto mrl = media.mrl();
+        std::unique_ptr<Slot> slot;
+        {
+            std::lock_guard<std::mutex> lock( m_state->mutex );
+            for ( const auto& s : m_state->prebuffered )
+            {
+                if ( s->mrl == mrl )
+                    return true;
+            }
+            if ( m_state->idle.empty() == true )
+                return false;
+            slot = std::move( m_state->idle.back() );
+            m_state->idle.pop_back();
+            if ( m_state->prebuffered.size() >= m_maxPrebuffered )
+            {
+                m_state->toReset.push_back( std::move( m_state->prebuffered.front() ) );
+                m_state->prebuffered.pop_front();
+                m_state->cond.notify_one();
+            }
+        }
+        slot->media.reset( new Media( media ) );
+        slot->media->addOption( ":start-paused" );
+        slot->mrl = std::move( mrl );
+        slot->player.setMedia( *slot->media );
+        slot->player.play();
+        std::lock_guard<std::mutex> lock( m_state->mutex );
+        m_state->prebuffered.push_back( std::move( slot ) );
+        return true;
+    }
+
+    /// Number of players ready to be leased, prebuffered or not
+    size_t nbIdle() const
+    {
+        std::lock_guard<std::mutex> lock( m_state->mutex );
+        return m_state->idle.size() + m_state->prebuffered.size();
+    }
+
+    size_t nbPrebuffered() const
+    {
+        std::lock_guard<std::mutex> lock( m_state->mutex );
+        return m_state->prebuffered.size();
+    }
+
+    size_t capacity() const
+    {
+        return m_state->capacity;
+    }
+
+private:
+    // Prefers the players without any media. Must be called with the lock held
+    std::unique_ptr<Slot> takeIdle()
+    {
+        std::unique_ptr<Slot> slot;
+        if ( m_state->idle.empty() == false )
+        {
+            slot = std::move( m_state->idle.back() );
+            m_state->idle.pop_back();
+        }
+        else if ( m_state->prebuffered.empty() == false )
+        {
+            // Setting the new media stops the prebuffered one
+            slot = std::move( m_state->prebuffered.front() );
+            m_state->prebuffered.pop_front();
+            slot->media.reset();
+            slot->mrl.clear();
+        }
+        return slot;
+    }
+
+    static void stop( MediaPlayer& player )
+    {
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        player.stopAsync();
+#else
+        player.stop();
+#endif
+        libvlc_media_player_set_media( player, nullptr );
+    }
+
+    // Stops & resets the released players, away from the application threads
+    static void run( std::shared_ptr<State> state )
+    {
+        std::unique_lock<std::mutex> lock( state->mutex );
+        for ( ;; )
+        {
+            state->cond.wait( lock, [&state]() {
+                return state->closed == true || state->toReset.empty() == false;
+            });
+            if ( state->toReset.empty() == true )
+                return;
+            auto slot = std::move( state->toReset.front() );
+            state->toReset.pop_front();
+            lock.unlock();
+            stop( slot->player );
+            slot->media.reset();
+            slot->mrl.clear();
+            if ( state->reset != nullptr )
+                state->reset( slot->player );
+            lock.lock();
+            if ( state->closed == false &&
+                 state->idle.size() + state->prebuffered.size() < state->capacity )
+                state->idle.push_back( std::move( slot ) );
+            else
+            {
+                lock.unlock();
+                slot.reset();
+                lock.lock();
+            }
+        }
+    }
+
+private:
+    std::shared_ptr<State> m_state;
+    const size_t m_maxPrebuffered;
+    std::thread m_thread;
+};
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_MEDIAPLAYERPOOL_H
@@ -0,0 +1,303 @@
+/*****************************************************************************
+ * MemoryInput.hpp: Memory and memory mapped file inputs for custom medias
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_MEMORYINPUT_H
+#define LIBVLC_CXX_MEMORYINPUT_H
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+// Keep the min & max macros, which break std::min, std::max and
+// std::numeric_limits, and the rarely used APIs out of the includers' scope
+# ifndef NOMINMAX
+#  define NOMINMAX
+#  define LIBVLC_CXX_UNDEF_NOMINMAX
+# endif
+# ifndef WIN32_LEAN_AND_MEAN
+#  define WIN32_LEAN_AND_MEAN
+#  define LIBVLC_CXX_UNDEF_WIN32_LEAN_AND_MEAN
+# endif
+# include <windows.h>
+# ifdef LIBVLC_CXX_UNDEF_NOMINMAX
+#  undef NOMINMAX
+#  undef LIBVLC_CXX_UNDEF_NOMINMAX
+# endif
+# ifdef LIBVLC_CXX_UNDEF_WIN32_LEAN_AND_MEAN
+#  undef WIN32_LEAN_AND_MEAN
+#  undef LIBVLC_CXX_UNDEF_WIN32_LEAN_AND_MEAN
+# endif
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#include "common.hpp"
+#include "Instance.hpp"
+#include "Media.hpp"
+
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
+
+namespace VLC
+{
+
+///
+/// \brief The MemoryInput class serves a custom bitstream media from a
+/// contiguous memory region.
+///
+/// The region is either provided by the application, or a read-only memory
+/// mapping of a file. Reading is a single memcpy into libvlc's buffer, and
+/// seeking only moves a cursor:
+///
+///     auto input = VLC::MemoryInput::mapFile( "/data/bundle.pak" );
+///     auto media = input->media();
+///     VLC::MediaPlayer mp( instance, media );
+///
+/// The media keeps the input alive. A media created from an input can be
+/// opened several times, and each opening gets its own read position.
+///
+class MemoryInput : public std::enable_shared_from_this<MemoryInput>
+{
+public:
+    /**
+     * Wraps an existing memory region. The region is not copied, and must
+     * stay valid as long as this input is alive.
+     *
+     * \param data  The first byte of the region
+     * \param size  The size of the region in bytes
+     * \param owner An optional object to keep alive along with this input,
+     *              typically the owner of the region.
+     */
+    MemoryInput( const void* data, uint64_t size, std::shared_ptr<const void> owner = nullptr )
+        : m_data( static_cast<const uint8_t*>( data ) )
+        , m_size( size )
+        , m_owner( std::move( owner ) )
+        , m_mapped( false )
+        , m_readAhead( 0 )
+    {
+    }
+
+    /**
+     * Creates an input backed by a read-only memory mapping of \p path.
+     *
+     * The mapping is flagged for sequential access, and when seeking, the
+     * kernel is asked to start reading \p readAhead bytes past the new
+     * position in advance.
+     *
+     * \throw std::runtime_error if the file can't be mapped
+     */
+    static std::shared_ptr<MemoryInput> mapFile( const std::string& path, uint64_t readAhead = 2 * 1024 * 1024 )
+    {
+        auto mapping = std::make_shared<Mapping>( path );
+        auto input = std::make_shared<MemoryInput>( mapping->data, mapping->size, mapping );
+        input->m_mapped = true;
+        input->m_readAhead = readAhead;
+        input->advise( 0, readAhead );
+        return input;
+    }
+
+    MemoryInput( const MemoryInput& ) = delete;
+    MemoryInput& operator=( const MemoryInput& ) = delete;
+
+    const uint8_t* data() const
+    {
+        return m_data;
+    }
+
+    uint64_t size() const
+    {
+        return m_size;
+    }
+
+    /**
+     * Creates a media reading from this input. The input must be owned by a
+     * std::shared_ptr.
+     */
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+    Media media()
+    {
+        auto self = shared_from_this();
+        return Media( Opener{ self }, &MemoryInput::read, &MemoryInput::seek, &MemoryInput::close );
+    }
+#else
+    Media media( const Instance& instance )
+    {
+        auto self = shared_from_this();
+        return Media( instance, Opener{ self }, &MemoryInput::read, &MemoryInput::seek, &MemoryInput::close );
+    }
+#endif
+
+private:
+    // The read position of a single opening of the media
+    struct Cursor
+    {
+        const MemoryInput* input;
+        uint64_t pos;
+    };
+
+    struct Opener
+    {
+        int operator()( void*, void** datap, uint64_t* sizep ) const
+        {
+            *datap = new Cursor{ input.get(), 0 };
+            *sizep = input->m_size;
+            return 0;
+        }
+        std::shared_ptr<MemoryInput> input;
+    };
+
+    static ptrdiff_t read( void* opaque, unsigned char* buf, size_t len )
+    {
+        auto c = static_cast<Cursor*>( opaque );
+        auto input = c->input;
+        if ( c->pos >= input->m_size )
+            return 0;
+        auto remaining = input->m_size - c->pos;
+        if ( len > remaining )
+            len = static_cast<size_t>( remaining );
+        memcpy( buf, input->m_data + c->pos, len );
+        c->pos += len;
+        return static_cast<ptrdiff_t>( len );
+    }
+
+    static int seek( void* opaque, uint64_t offset )
+    {
+        auto c = static_cast<Cursor*>( opaque );
+        if ( offset > c->input->m_size )
+            return -1;
+        c->pos = offset;
+        c->input->advise( offset, c->input->m_readAhead );
+        return 0;
+    }
+
+    static void close( void* opaque )
+    {
+        delete static_cast<Cursor*>( opaque );
+    }
+
+    // Hints the kernel that the given range will soon be read
+    void advise( uint64_t offset, uint64_t len ) const
+    {
+#ifndef _WIN32
+        if ( m_mapped == false || len == 0 || offset >= m_size )
+            return;
+        auto pageSize = static_cast<uint64_t>( sysconf( _SC_PAGESIZE ) );
+        auto start = offset & ~( pageSize - 1 );
+        if ( len > m_size - start )
+            len = m_size - start;
+        madvise( const_cast<uint8_t*>( m_data ) + start, static_cast<size_t>( len ), MADV_WILLNEED );
+#else
+        (void)offset;
+        (void)len;
+#endif
+    }
+
+    struct Mapping
+    {
+        explicit Mapping( const std::string& path )
+            : data( nullptr )
+            , size( 0 )
+        {
+#ifdef _WIN32
+            auto file = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                     OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+            if ( file == INVALID_HANDLE_VALUE )
+                throw std::runtime_error( "Failed to open " + path );
+            LARGE_INTEGER fileSize;
+            if ( GetFileSizeEx( file, &fileSize ) == 0 )
+            {
+                CloseHandle( file );
+                throw std::runtime_error( "Failed to stat " + path );
+            }
+            size = static_cast<uint64_t>( fileSize.QuadPart );
+            if ( size > 0 )
+            {
+                auto mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+                if ( mapping != nullptr )
+                {
+                    data = static_cast<const uint8_t*>( MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) );
+                    CloseHandle( mapping );
+                }
+            }
+            CloseHandle( file );
+            if ( size > 0 && data == nullptr )
+                throw std::runtime_error( "Failed to map " + path );
+#else
+            auto fd = open( path.c_str(), O_RDONLY | O_CLOEXEC );
+            if ( fd < 0 )
+                throw std::runtime_error( "Failed to open " + path );
+            struct stat st;
+            if ( fstat( fd, &st ) != 0 )
+            {
+                ::close( fd );
+                throw std::runtime_error( "Failed to stat " + path );
+            }
+            size = static_cast<uint64_t>( st.st_size );
+            if ( size > 0 )
+            {
+                auto ptr = mmap( nullptr, static_cast<size_t>( size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+                if ( ptr != MAP_FAILED )
+                {
+                    data = static_cast<const uint8_t*>( ptr );
+                    madvise( ptr, static_cast<size_t>( size ), MADV_SEQUENTIAL );
+                }
+            }
+            // The mapping stays valid once the file is closed
+            ::close( fd );
+            if ( size > 0 && data == nullptr )
+                throw std::runtime_error( "Failed to map " + path );
+#endif
+        }
+
+        ~Mapping()
+        {
+            if ( data == nullptr )
+                return;
+#ifdef _WIN32
+            UnmapViewOfFile( data );
+#else
+            munmap( const_cast<uint8_t*>( data ), static_cast<size_t>( size ) );
+#endif
+        }
+
+        Mapping( const Mapping& ) = delete;
+        Mapping& operator=( const Mapping& ) = delete;
+
+        const uint8_t* data;
+        uint64_t size;
+    };
+
+private:
+    const uint8_t* m_data;
+    uint64_t m_size;
+    std::shared_ptr<const void> m_owner;
+    bool m_mapped;
+    uint64_t m_readAhead;
+};
+
+} // namespace VLC
+
+#endif
+
+#endif // LIBVLC_CXX_MEMORYINPUT_H
@@ -0,0 +1,276 @@
+/*****************************************************************************
+ * PlayerStateMonitor.hpp: Lock-free, event driven media player state
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_PLAYERSTATEMONITOR_H
+#define LIBVLC_CXX_PLAYERSTATEMONITOR_H
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "common.hpp"
+#include "EventManager.hpp"
+#include "MediaPlayer.hpp"
+
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
+
+namespace VLC
+{
+
+namespace detail
+{
+
+///
+/// A sequence lock: readers never block the writers, and retry when they
+/// raced with one. The value is stored as atomic words, so that a torn read
+/// is only ever discarded, never undefined.
+/// Writers must be serialized by the caller.
+///
+template <typename T>
+class SeqLock
+{
+    static_assert( std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type" );
+public:
+    explicit SeqLock( const T& value = T() )
+        : m_seq( 0 )
+    {
+        for ( auto& w : m_words )
+            w.store( 0, std::memory_order_relaxed );
+        store( value );
+    }
+
+    void store( const T& value )
+    {
+        uint64_t words[NbWords] = {};
+        memcpy( words, &value, sizeof( value ) );
+        auto seq = m_seq.load( std::memory_order_relaxed );
+        m_seq.store( seq + 1, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_release );
+        for ( size_t i = 0; i < NbWords; ++i )
+            m_words[i].store( words[i], std::memory_order_relaxed );
+        m_seq.store( seq + 2, std::memory_order_release );
+    }
+
+    T load() const
+    {
+        uint64_t words[NbWords];
+        for ( ;; )
+        {
+            auto before = m_seq.load( std::memory_order_acquire );
+            if ( ( before & 1 ) != 0 )
+                continue;
+            for ( size_t i = 0; i < NbWords; ++i )
+                words[i] = m_words[i].load( std::memory_order_relaxed );
+            std::atomic_thread_fence( std::memory_order_acquire );
+            if ( m_seq.load( std::memory_order_relaxed ) == before )
+                break;
+        }
+        T res;
+        memcpy( &res, words, sizeof( res ) );
+        return res;
+    }
+
+private:
+    static constexpr size_t NbWords = ( sizeof( T ) + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t );
+    std::atomic<uint64_t> m_seq;
+    std::atomic<uint64_t> m_words[NbWords];
+};
+
+} // namespace detail
+
+///
+/// \brief The PlayerStateMonitor class maintains a MediaPlayer::Snapshot
+/// from the player events, so that it can be read without querying libvlc.
+///
+/// Reading the snapshot is lock-free and doesn't involve any libvlc call,
+/// which makes it suitable to poll many players on each frame:
+///
+///     std::vector<std::unique_ptr<VLC::PlayerStateMonitor>> monitors;
+///     for ( auto& mp : players )
+///         monitors.emplace_back( new VLC::PlayerStateMonitor( mp ) );
+///     // On each frame
+///     VLC::PlayerStateMonitor::snapshot( monitors.begin(), monitors.end(), rows.begin() );
+///
+/// libvlc doesn't notify rate changes: the rate is refreshed when the
+/// playback starts, and by refresh(), which also catches up with any state
+/// changed before the monitor was created.
+///
+class PlayerStateMonitor
+{
+public:
+    /**
+     * Registers the event handlers on \p player, and takes an initial
+     * snapshot. The monitor keeps a reference to the player.
+     */
+    explicit PlayerStateMonitor( MediaPlayer& player )
+    {
+        // Share the event manager with our copy of the player
+        auto& em = player.eventManager();
+        m_player = player;
+        m_handles.push_back( em.onMediaChanged( [this]( MediaPtr ) {
+            update( []( MediaPlayer::Snapshot& s ) {
+                s.time = -1;
+                s.length = -1;
+                s.position = -1.f;
+                s.buffering = 0.f;
+                s.state = libvlc_NothingSpecial;
+                s.isPlaying = false;
+            });
+        }));
+        m_handles.push_back( em.onOpening( [this]() { setState( libvlc_Opening, false ); } ) );
+        m_handles.push_back( em.onBuffering( [this]( float b ) {
+            update( [b]( MediaPlayer::Snapshot& s ) { s.buffering = b; } );
+        }));
+        m_handles.push_back( em.onPlaying( [this]() {
+            auto rate = m_player.rate();
+            update( [rate]( MediaPlayer::Snapshot& s ) {
+                s.state = libvlc_Playing;
+                s.isPlaying = true;
+                s.rate = rate;
+            });
+        }));
+        m_handles.push_back( em.onPaused( [this]() { setState( libvlc_Paused, false ); } ) );
+        m_handles.push_back( em.onStopped( [this]() { setState( libvlc_Stopped, false ); } ) );
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        m_handles.push_back( em.onStopping( [this]() { setState( libvlc_Stopping, false ); } ) );
+#else
+        m_handles.push_back( em.onEndReached( [this]() { setState( libvlc_Ended, false ); } ) );
+#endif
+        m_handles.push_back( em.onEncounteredError( [this]() { setState( libvlc_Error, false ); } ) );
+        m_handles.push_back( em.onTimeChanged( [this]( libvlc_time_t t ) {
+            update( [t]( MediaPlayer::Snapshot& s ) { s.time = t; } );
+        }));
+        m_handles.push_back( em.onPositionChanged( [this]( float p ) {
+            update( [p]( MediaPlayer::Snapshot& s ) { s.position = p; } );
+        }));
+        m_handles.push_back( em.onLengthChanged( [this]( libvlc_time_t l ) {
+            update( [l]( MediaPlayer::Snapshot& s ) { s.length = l; } );
+        }));
+        m_handles.push_back( em.onSeekableChanged( [this]( bool b ) {
+            update( [b]( MediaPlayer::Snapshot& s ) { s.isSeekable = b; } );
+        }));
+        m_handles.push_back( em.onPausableChanged( [this]( bool b ) {
+            update( [b]( MediaPlayer::Snapshot& s ) { s.canPause = b; } );
+        }));
+        m_handles.push_back( em.onAudioVolume( [this]( float v ) {
+            // The event provides the volume as a factor
+            auto volume = static_cast<int>( std::lround( v * 100.f ) );
+            update( [volume]( MediaPlayer::Snapshot& s ) { s.volume = volume; } );
+        }));
+        m_handles.push_back( em.onMuted( [this]() {
+            update( []( MediaPlayer::Snapshot& s ) { s.mute = true; } );
+        }));
+        m_handles.push_back( em.onUnmuted( [this]() {
+            update( []( MediaPlayer::Snapshot& s ) { s.mute = false; } );
+        }));
+        refresh();
+    }
+
+    ~PlayerStateMonitor()
+    {
+        auto& em = m_player.eventManager();
+        for ( const auto& h : m_handles )
+            em.unregister( h );
+    }
+
+    PlayerStateMonitor( const PlayerStateMonitor& ) = delete;
+    PlayerStateMonitor& operator=( const PlayerStateMonitor& ) = delete;
+
+    /// Returns the latest state. This is lock-free, and can be called from
+    /// any thread.
+    MediaPlayer::Snapshot snapshot() const
+    {
+        return m_snapshot.load();
+    }
+
+    /**
+     * Reads the snapshots of a range of monitors.
+     *
+     * \param first, last A range of PlayerStateMonitor, or of pointers to
+     *                    PlayerStateMonitor
+     * \param out         Receives one snapshot per monitor
+     * \return The end of the output range
+     */
+    template <typename It, typename Out>
+    static Out snapshot( It first, It last, Out out )
+    {
+        for ( ; first != last; ++first, ++out )
+            *out = monitor( *first ).snapshot();
+        return out;
+    }
+
+    /**
+     * Queries the whole state from the player again. This is meant to be
+     * called when the application changed the rate.
+     */
+    void refresh()
+    {
+        std::lock_guard<std::mutex> lock( m_writeMutex );
+        auto buffering = m_current.buffering;
+        m_current = m_player.snapshot();
+        m_current.buffering = buffering;
+        m_snapshot.store( m_current );
+    }
+
+private:
+    template <typename Func>
+    void update( Func f )
+    {
+        std::lock_guard<std::mutex> lock( m_writeMutex );
+        f( m_current );
+        m_snapshot.store( m_current );
+    }
+
+    void setState( libvlc_state_t state, bool isPlaying )
+    {
+        update( [state, isPlaying]( MediaPlayer::Snapshot& s ) {
+            s.state = state;
+            s.isPlaying = isPlaying;
+        });
+    }
+
+    static const PlayerStateMonitor& monitor( const PlayerStateMonitor& m )
+    {
+        return m;
+    }
+
+    template <typename Ptr>
+    static const PlayerStateMonitor& monitor( const Ptr& m )
+    {
+        return *m;
+    }
+
+private:
+    MediaPlayer m_player;
+    std::vector<EventManager::Handle> m_handles;
+    // The events may be raised from several libvlc threads
+    std::mutex m_writeMutex;
+    MediaPlayer::Snapshot m_current;
+    detail::SeqLock<MediaPlayer::Snapshot> m_snapshot;
+};
+
+} // namespace VLC
+
+#endif
+
+#endif // LIBVLC_CXX_PLAYERSTATEMONITOR_H
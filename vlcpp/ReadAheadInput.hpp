@@ -0,0 +1,412 @@
+/*****************************************************************************
+ * ReadAheadInput.hpp: Prefetching input for custom medias
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_READAHEADINPUT_H
+#define LIBVLC_CXX_READAHEADINPUT_H
+
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "Instance.hpp"
+#include "Media.hpp"
+
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
+
+namespace VLC
+{
+
+///
+/// \brief The ReadAheadInput class prefetches a custom bitstream media.
+///
+/// libvlc reads custom medias synchronously, one buffer at a time, so a
+/// read callback backed by a remote storage pays for a full round-trip on
+/// each call. This input splits the stream in fixed size chunks, and keeps
+/// several of them in flight on background threads, ahead of the current
+/// read position:
+///
+///     auto input = std::make_shared<VLC::ReadAheadInput>(
+///         [client]( uint64_t offset, unsigned char* buf, size_t len ) {
+///             return client->rangeGet( offset, buf, len );
+///         }, objectSize );
+///     auto media = input->media();
+///
+/// Seeking within the prefetched window keeps the chunks that are still
+/// ahead; any other seek invalidates the window and reissues the requests
+/// from the new position.
+///
+class ReadAheadInput : public std::enable_shared_from_this<ReadAheadInput>
+{
+public:
+    /**
+     * Reads up to \p len bytes at \p offset.
+     *
+     * It is invoked concurrently from the I/O threads, for distinct ranges,
+     * and must return the number of bytes read, 0 at the end of the stream,
+     * or -1 on a non recoverable error. Short reads are allowed.
+     */
+    using ReadAt = std::function<ptrdiff_t(uint64_t offset, unsigned char* buf, size_t len)>;
+
+    struct Config
+    {
+        Config()
+            : chunkSize( 1024 * 1024 )
+            , nbChunks( 8 )
+            , nbThreads( 4 )
+        {
+        }
+
+        /// Size of a single request
+        size_t chunkSize;
+        /// Number of chunks buffered ahead of the read position
+        size_t nbChunks;
+        /// Number of I/O threads per opened stream, which bounds the number
+        /// of requests in flight
+        size_t nbThreads;
+    };
+
+    /**
+     * \param readAt The positional read function
+     * \param size   The stream size in bytes, or 0 if unknown
+     */
+    ReadAheadInput( ReadAt readAt, uint64_t size, Config config = Config() )
+        : m_readAt( std::move( readAt ) )
+        , m_size( size )
+        , m_config( std::move( config ) )
+    {
+        if ( m_config.chunkSize == 0 )
+            m_config.chunkSize = 1;
+        if ( m_config.nbChunks == 0 )
+            m_config.nbChunks = 1;
+        if ( m_config.nbThreads == 0 )
+            m_config.nbThreads = 1;
+    }
+
+    ReadAheadInput( const ReadAheadInput& ) = delete;
+    ReadAheadInput& operator=( const ReadAheadInput& ) = delete;
+
+    uint64_t size() const
+    {
+        return m_size;
+    }
+
+    const Config& config() const
+    {
+        return m_config;
+    }
+
+    /**
+     * Creates a media reading from this input. The input must be owned by a
+     * std::shared_ptr.
+     *
+     * Each opening of the media starts its own I/O threads, which are
+     * stopped when libvlc closes the media.
+     */
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+    Media media()
+    {
+        return Media( Opener{ shared_from_this() }, &ReadAheadInput::read,
+                      &ReadAheadInput::seek, &ReadAheadInput::close );
+    }
+#else
+    Media media( const Instance& instance )
+    {
+        return Media( instance, Opener{ shared_from_this() }, &ReadAheadInput::read,
+                      &ReadAheadInput::seek, &ReadAheadInput::close );
+    }
+#endif
+
+private:
+    struct Chunk
+    {
+        enum class State
+        {
+            // Past the end of the stream
+            Idle,
+            Pending,
+            Loading,
+            Ready,
+            Failed,
+        };
+
+        Chunk( size_t size )
+            : data( size )
+            , offset( 0 )
+            , filled( 0 )
+            , epoch( 0 )
+            , state( State::Idle )
+        {
+        }
+
+        std::vector<unsigned char> data;
+        uint64_t offset;
+        size_t filled;
+        // Bumped when the chunk is reassigned, so that a request completing
+        // for its previous offset is discarded and reissued
+        uint64_t epoch;
+        State state;
+    };
+
+    // The state of a single opening of the media. read & seek are invoked
+    // from a single libvlc thread, which is the only one moving the window.
+    class Stream
+    {
+    public:
+        Stream( std::shared_ptr<ReadAheadInput> input )
+            : m_input( std::move( input ) )
+            , m_head( 0 )
+            , m_pos( 0 )
+            , m_nextOffset( 0 )
+            , m_stop( false )
+        {
+            const auto& config = m_input->m_config;
+            m_chunks.reserve( config.nbChunks );
+            for ( size_t i = 0; i < config.nbChunks; ++i )
+                m_chunks.emplace_back( config.chunkSize );
+            for ( auto& c : m_chunks )
+                assign( c );
+            m_threads.reserve( config.nbThreads );
+            for ( size_t i = 0; i < config.nbThreads; ++i )
+                m_threads.emplace_back( &Stream::run, this );
+        }
+
+        ~Stream()
+        {
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                m_stop = true;
+            }
+            m_workCond.notify_all();
+            for ( auto& t : m_threads )
+                t.join();
+        }
+
+        ptrdiff_t read( unsigned char* buf, size_t len )
+        {
+            Chunk* c;
+            {
+                std::unique_lock<std::mutex> lock( m_mutex );
+                c = &m_chunks[m_head];
+                if ( c->state == Chunk::State::Idle )
+                    return 0;
+                m_readyCond.wait( lock, [c]() {
+                    return c->state == Chunk::State::Ready ||
+                           c->state == Chunk::State::Failed;
+                });
+                if ( c->state == Chunk::State::Failed )
+                    return -1;
+            }
+            // A ready chunk is only modified by this thread, so the copy can
+            // happen without holding the lock
+            auto chunkPos = static_cast<size_t>( m_pos - c->offset );
+            auto available = c->filled - chunkPos;
+            if ( available == 0 )
+                return 0;
+            if ( len > available )
+                len = available;
+            memcpy( buf, c->data.data() + chunkPos, len );
+            m_pos += len;
+            if ( chunkPos + len == c->data.size() )
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                recycleHead();
+            }
+            return static_cast<ptrdiff_t>( len );
+        }
+
+        int seek( uint64_t offset )
+        {
+            auto size = m_input->m_size;
+            if ( size != 0 && offset > size )
+                return -1;
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                if ( offset >= m_chunks[m_head].offset && offset < m_nextOffset )
+                {
+                    // Within the window: only drop the chunks behind
+                    while ( offset >= m_chunks[m_head].offset + m_chunks[m_head].data.size() )
+                        recycleHead();
+                }
+                else
+                {
+                    m_nextOffset = offset;
+                    for ( size_t i = 0; i < m_chunks.size(); ++i )
+                        assign( m_chunks[( m_head + i ) % m_chunks.size()] );
+                }
+                m_pos = offset;
+            }
+            m_workCond.notify_all();
+            return 0;
+        }
+
+    private:
+        // Makes the head chunk the next one to fetch, past the end of the window
+        void recycleHead()
+        {
+            assign( m_chunks[m_head] );
+            m_head = ( m_head + 1 ) % m_chunks.size();
+            m_workCond.notify_one();
+        }
+
+        void assign( Chunk& c )
+        {
+            auto size = m_input->m_size;
+            c.offset = m_nextOffset;
+            c.filled = 0;
+            ++c.epoch;
+            m_nextOffset += c.data.size();
+            // A chunk being loaded for a previous offset is reissued once
+            // its request completes
+            if ( c.state == Chunk::State::Loading )
+                return;
+            if ( size != 0 && c.offset >= size )
+                c.state = Chunk::State::Idle;
+            else
+                c.state = Chunk::State::Pending;
+        }
+
+        // Returns the pending chunk closest to the read position
+        Chunk* nextPending()
+        {
+            for ( size_t i = 0; i < m_chunks.size(); ++i )
+            {
+                auto& c = m_chunks[( m_head + i ) % m_chunks.size()];
+                if ( c.state == Chunk::State::Pending )
+                    return &c;
+            }
+            return nullptr;
+        }
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            for ( ;; )
+            {
+                Chunk* c = nullptr;
+                m_workCond.wait( lock, [this, &c]() {
+                    return m_stop == true || ( c = nextPending() ) != nullptr;
+                });
+                if ( m_stop == true )
+                    return;
+                c->state = Chunk::State::Loading;
+                auto offset = c->offset;
+                auto epoch = c->epoch;
+                lock.unlock();
+                auto res = fill( *c, offset );
+                lock.lock();
+                if ( c->epoch != epoch )
+                {
+                    // Reassigned while loading
+                    auto size = m_input->m_size;
+                    c->filled = 0;
+                    c->state = ( size != 0 && c->offset >= size ) ?
+                                Chunk::State::Idle : Chunk::State::Pending;
+                    continue;
+                }
+                if ( res < 0 )
+                    c->state = Chunk::State::Failed;
+                else
+                {
+                    c->filled = static_cast<size_t>( res );
+                    c->state = Chunk::State::Ready;
+                }
+                m_readyCond.notify_one();
+            }
+        }
+
+        // Loops over short reads, so that only the end of the stream yields a
+        // partially filled chunk
+        ptrdiff_t fill( Chunk& c, uint64_t offset )
+        {
+            auto size = m_input->m_size;
+            auto len = c.data.size();
+            if ( size != 0 && offset + len > size )
+                len = static_cast<size_t>( size - offset );
+            size_t filled = 0;
+            while ( filled < len )
+            {
+                auto res = m_input->m_readAt( offset + filled, c.data.data() + filled,
+                                              len - filled );
+                if ( res < 0 )
+                    return -1;
+                if ( res == 0 )
+                    break;
+                filled += static_cast<size_t>( res );
+            }
+            return static_cast<ptrdiff_t>( filled );
+        }
+
+    private:
+        std::shared_ptr<ReadAheadInput> m_input;
+        std::vector<Chunk> m_chunks;
+        // Index of the chunk holding m_pos
+        size_t m_head;
+        uint64_t m_pos;
+        // Offset of the first byte past the window
+        uint64_t m_nextOffset;
+        bool m_stop;
+        std::mutex m_mutex;
+        std::condition_variable m_workCond;
+        std::condition_variable m_readyCond;
+        std::vector<std::thread> m_threads;
+    };
+
+    struct Opener
+    {
+        int operator()( void*, void** datap, uint64_t* sizep ) const
+        {
+            *datap = new Stream( input );
+            *sizep = input->m_size;
+            return 0;
+        }
+        std::shared_ptr<ReadAheadInput> input;
+    };
+
+    static ptrdiff_t read( void* opaque, unsigned char* buf, size_t len )
+    {
+        return static_cast<Stream*>( opaque )->read( buf, len );
+    }
+
+    static int seek( void* opaque, uint64_t offset )
+    {
+        return static_cast<Stream*>( opaque )->seek( offset );
+    }
+
+    static void close( void* opaque )
+    {
+        delete static_cast<Stream*>( opaque );
+    }
+
+private:
+    ReadAt m_readAt;
+    uint64_t m_size;
+    Config m_config;
+};
+
+} // namespace VLC
+
+#endif
+
+#endif // LIBVLC_CXX_READAHEADINPUT_H
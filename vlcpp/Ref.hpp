@@ -0,0 +1,476 @@
+/*****************************************************************************
+ * Ref.hpp: Intrusive handles on the libvlc reference counts
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_REF_H
+#define LIBVLC_CXX_REF_H
+
+#include <cstddef>
+#include <utility>
+
+#include "common.hpp"
+#include "Internal.hpp"
+
+namespace VLC
+{
+
+///
+/// \brief The RefTraits struct tells how to acquire & release a reference on
+/// a libvlc object. It can be specialized for other types.
+///
+template <typename T>
+struct RefTraits;
+
+template <>
+struct RefTraits<libvlc_instance_t>
+{
+    static void retain( libvlc_instance_t* p ) { libvlc_retain( p ); }
+    static void release( libvlc_instance_t* p ) { libvlc_release( p ); }
+};
+
+template <>
+struct RefTraits<libvlc_media_t>
+{
+    static void retain( libvlc_media_t* p ) { libvlc_media_retain( p ); }
+    static void release( libvlc_media_t* p ) { libvlc_media_release( p ); }
+};
+
+template <>
+struct RefTraits<libvlc_media_player_t>
+{
+    static void retain( libvlc_media_player_t* p ) { libvlc_media_player_retain( p ); }
+    static void release( libvlc_media_player_t* p ) { libvlc_media_player_release( p ); }
+};
+
+template <>
+struct RefTraits<libvlc_media_list_t>
+{
+    static void retain( libvlc_media_list_t* p ) { libvlc_media_list_retain( p ); }
+    static void release( libvlc_media_list_t* p ) { libvlc_media_list_release( p ); }
+};
+
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+template <>
+struct RefTraits<libvlc_picture_t>
+{
+    static void retain( libvlc_picture_t* p ) { libvlc_picture_retain( p ); }
+    static void release( libvlc_picture_t* p ) { libvlc_picture_release( p ); }
+};
+
+template <>
+struct RefTraits<libvlc_media_track_t>
+{
+    static void retain( libvlc_media_track_t* p ) { libvlc_media_track_hold( p ); }
+    static void release( libvlc_media_track_t* p ) { libvlc_media_track_release( p ); }
+};
+#endif
+
+///
+/// \brief The Ref class owns a reference on a libvlc object, using the
+/// object's own reference count.
+///
+/// Unlike the wrappers, which hold a std::shared_ptr, a Ref is a single
+/// pointer: creating one doesn't allocate a control block, and moving one is
+/// free. Copies go through libvlc's retain & release.
+///
+///     // Keep the thumbnails without wrapping them
+///     std::vector<VLC::Ref<libvlc_picture_t>> thumbnails;
+///     thumbnails.push_back( VLC::Ref<libvlc_picture_t>::adopt( pic ) );
+///     // A wrapper can be created when needed
+///     VLC::Picture p( thumbnails.back().get() );
+///
+template <typename T, typename Traits = RefTraits<T>>
+class Ref
+{
+public:
+    Ref()
+        : m_ptr( nullptr )
+    {
+    }
+
+    /// Takes over a reference owned by the caller, such as the one returned
+    /// by a libvlc constructor
+    static Ref adopt( T* ptr )
+    {
+        Ref res;
+        res.m_ptr = ptr;
+        return res;
+    }
+
+    /// Acquires a new reference on \p ptr
+    static Ref retain( T* ptr )
+    {
+        if ( ptr != nullptr )
+            Traits::retain( ptr );
+        return adopt( ptr );
+    }
+
+    /// Acquires a new reference on the object held by \p wrapper
+    template <typename Releaser>
+    explicit Ref( const Internal<T, Releaser>& wrapper )
+        : m_ptr( wrapper.get() )
+    {
+        if ( m_ptr != nullptr )
+            Traits::retain( m_ptr );
+    }
+
+    Ref( const Ref& other )
+        : m_ptr( other.m_ptr )
+    {
+        if ( m_ptr != nullptr )
+            Traits::retain( m_ptr );
+    }
+
+    Ref( Ref&& other )
+        : m_ptr( other.m_ptr )
+    {
+        other.m_ptr = nullptr;
+    }
+
+    Ref& operator=( Ref other )
+    {
+        swap( other );
+        return *this;
+    }
+
+    ~Ref()
+    {
+        if ( m_ptr != nullptr )
+            Traits::release( m_ptr );
+    }
+
+    T* get() const
+    {
+        return m_ptr;
+    }
+
+    operator T*() const
+    {
+        return m_ptr;
+    }
+
+    bool isValid() const
+    {
+        return m_ptr != nullptr;
+    }
+
+    /// Gives the reference back to the caller, which becomes responsible for
+    /// releasing it
+    T* detach()
+    {
+        auto res = m_ptr;
+        m_ptr = nullptr;
+        return res;
+    }
+
+    void reset()
+    {
+        Ref().swap( *this );
+    }
+
+    void swap( Ref& other )
+    {
+        std::swap( m_ptr, other.m_ptr );
+    }
+
+    bool operator==( const Ref& other ) const
+    {
+        return m_ptr == other.m_ptr;
+    }
+
+    bool operator!=( const Ref& other ) const
+    {
+        return m_ptr != other.m_ptr;
+    }
+
+private:
+    T* m_ptr;
+};
+
+///
+/// \brief The LocalRef class shares a single libvlc reference between the
+/// copies made on one thread.
+///
+/// The copies are linked together, and the libvlc reference is released with
+/// the last of them: copying, moving & destroying a LocalRef doesn't involve
+/// any atomic operation nor allocation.
+///
+/// \warning A LocalRef and all its copies must only be used from a single
+/// thread. Use toRef() to hand the object over to another thread.
+///
+///     VLC::LocalRef<libvlc_media_t> media( VLC::Ref<libvlc_media_t>::adopt(
+///         libvlc_media_new_path( path ) ) );
+///     for ( auto& stage : pipeline )
+///         stage.process( media ); // Passed by value, no atomic operation
+///
+template <typename T, typename Traits = RefTraits<T>>
+class LocalRef
+{
+public:
+    LocalRef()
+        : m_ptr( nullptr )
+        , m_prev( this )
+        , m_next( this )
+    {
+    }
+
+    /// Takes over the reference held by \p ref
+    explicit LocalRef( Ref<T, Traits>&& ref )
+        : m_ptr( ref.detach() )
+        , m_prev( this )
+        , m_next( this )
+    {
+    }
+
+    /// Acquires a new reference on the object held by \p wrapper
+    template <typename Releaser>
+    explicit LocalRef( const Internal<T, Releaser>& wrapper )
+        : LocalRef( Ref<T, Traits>( wrapper ) )
+    {
+    }
+
+    LocalRef( const LocalRef& other )
+        : LocalRef()
+    {
+        join( other );
+    }
+
+    LocalRef( LocalRef&& other )
+        : LocalRef()
+    {
+        join( other );
+        other.leave();
+    }
+
+    LocalRef& operator=( const LocalRef& other )
+    {
+        if ( this != &other && other.m_ptr != m_ptr )
+        {
+            reset();
+            join( other );
+        }
+        return *this;
+    }
+
+    LocalRef& operator=( LocalRef&& other )
+    {
+        if ( this != &other )
+        {
+            reset();
+            join( other );
+            other.leave();
+        }
+        return *this;
+    }
+
+    ~LocalRef()
+    {
+        reset();
+    }
+
+    T* get() const
+    {
+        return m_ptr;
+    }
+
+    operator T*() const
+    {
+        return m_ptr;
+    }
+
+    bool isValid() const
+    {
+        return m_ptr != nullptr;
+    }
+
+    /// Returns whether this is the only copy
+    bool unique() const
+    {
+        return m_ptr != nullptr && m_next == this;
+    }
+
+    /// Acquires a reference which can be handed over to another thread
+    Ref<T, Traits> toRef() const
+    {
+        return Ref<T, Traits>::retain( m_ptr );
+    }
+
+    void reset()
+    {
+        if ( leave() == true && m_ptr != nullptr )
+            Traits::release( m_ptr );
+        m_ptr = nullptr;
+    }
+
+    bool operator==( const LocalRef& other ) const
+    {
+        return m_ptr == other.m_ptr;
+    }
+
+    bool operator!=( const LocalRef& other ) const
+    {
+        return m_ptr != other.m_ptr;
+    }
+
+private:
+    // Inserts this instance, which must be empty, in the ring of other
+    void join( const LocalRef& other )
+    {
+        if ( other.m_ptr == nullptr )
+            return;
+        m_ptr = other.m_ptr;
+        m_prev = const_cast<LocalRef*>( &other );
+        m_next = other.m_next;
+        other.m_next->m_prev = this;
+        other.m_next = this;
+    }
+
+    // Removes this instance from its ring, and returns whether it was the last
+    // one. The pointer is left for the caller to release or clear.
+    bool leave()
+    {
+        if ( m_next == this )
+            return true;
+        m_prev->m_next = m_next;
+        m_next->m_prev = m_prev;
+        m_prev = this;
+        m_next = this;
+        m_ptr = nullptr;
+        return false;
+    }
+
+private:
+    T* m_ptr;
+    mutable LocalRef* m_prev;
+    mutable LocalRef* m_next;
+};
+
+///
+/// \brief The Unique class is the sole owner of a reference on a libvlc
+/// object. It can only be moved.
+///
+/// A Unique adopts the reference it's given, without retaining it again, and
+/// never allocates. This is what the factory functions and event handlers
+/// returning a UniqueMedia, UniquePicture or UniqueMediaTrack hand out, for
+/// the callers which don't need to share the object:
+///
+///     auto media = player.mediaUnique();
+///     if ( media.isValid() == true )
+///         process( std::move( media ) );
+///     // Sharing it later on
+///     VLC::Media shared( media.release(), false );
+///
+template <typename T, typename Traits = RefTraits<T>>
+class Unique
+{
+public:
+    Unique()
+        : m_ptr( nullptr )
+    {
+    }
+
+    /// Takes over a reference owned by the caller
+    explicit Unique( T* ptr )
+        : m_ptr( ptr )
+    {
+    }
+
+    /// Acquires a new reference on \p ptr
+    static Unique retain( T* ptr )
+    {
+        if ( ptr != nullptr )
+            Traits::retain( ptr );
+        return Unique( ptr );
+    }
+
+    Unique( const Unique& ) = delete;
+    Unique& operator=( const Unique& ) = delete;
+
+    Unique( Unique&& other )
+        : m_ptr( other.m_ptr )
+    {
+        other.m_ptr = nullptr;
+    }
+
+    Unique& operator=( Unique&& other )
+    {
+        Unique( std::move( other ) ).swap( *this );
+        return *this;
+    }
+
+    ~Unique()
+    {
+        if ( m_ptr != nullptr )
+            Traits::release( m_ptr );
+    }
+
+    T* get() const
+    {
+        return m_ptr;
+    }
+
+    operator T*() const
+    {
+        return m_ptr;
+    }
+
+    bool isValid() const
+    {
+        return m_ptr != nullptr;
+    }
+
+    /// Gives the reference back to the caller, which becomes responsible for
+    /// releasing it
+    T* release()
+    {
+        auto res = m_ptr;
+        m_ptr = nullptr;
+        return res;
+    }
+
+    void reset()
+    {
+        Unique().swap( *this );
+    }
+
+    void swap( Unique& other )
+    {
+        std::swap( m_ptr, other.m_ptr );
+    }
+
+    /// Converts this into a shareable Ref, without touching the reference count
+    Ref<T, Traits> share()
+    {
+        return Ref<T, Traits>::adopt( release() );
+    }
+
+private:
+    T* m_ptr;
+};
+
+using UniqueMedia = Unique<libvlc_media_t>;
+using UniqueMediaPlayer = Unique<libvlc_media_player_t>;
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+using UniquePicture = Unique<libvlc_picture_t>;
+using UniqueMediaTrack = Unique<libvlc_media_track_t>;
+#endif
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_REF_H
@@ -0,0 +1,478 @@
+/*****************************************************************************
+ * StatsCollector.hpp: Periodic sampling of the media statistics
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_STATSCOLLECTOR_H
+#define LIBVLC_CXX_STATSCOLLECTOR_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "Media.hpp"
+#include "MediaPlayer.hpp"
+
+namespace VLC
+{
+
+///
+/// \brief The StatsCollector class samples the statistics of a set of medias
+/// or players at a fixed interval, and keeps a short history of rates.
+///
+/// Media::stats only provides cumulative counters. The collector turns them
+/// into per second rates, kept in a fixed size ring per source, which can be
+/// read from the application or exported in the Prometheus text format:
+///
+///     VLC::StatsCollector stats;
+///     stats.add( "camera-1", player );
+///     ...
+///     auto s = stats.latest( "camera-1" );
+///     if ( s.dropRatio > 0.05f )
+///         alert();
+///     httpResponse( stats.prometheus() );
+///
+/// For a player, the statistics of its current media are sampled, and the
+/// counters restart from zero when the media changes.
+///
+class StatsCollector
+{
+public:
+    struct Config
+    {
+        Config()
+            : interval( 1000 )
+            , historySize( 60 )
+        {
+        }
+
+        /// The sampling interval
+        std::chrono::milliseconds interval;
+        /// The number of samples kept per source
+        size_t historySize;
+    };
+
+    ///
+    /// \brief The Sample struct holds the counters at a sampling time, and
+    /// the rates since the previous sample.
+    ///
+    struct Sample
+    {
+        Sample()
+            : readBytes( 0 )
+            , demuxCorrupted( 0 )
+            , demuxDiscontinuity( 0 )
+            , decodedVideo( 0 )
+            , decodedAudio( 0 )
+            , displayedPictures( 0 )
+            , lostPictures( 0 )
+            , playedAudioBuffers( 0 )
+            , lostAudioBuffers( 0 )
+            , inputBitrate( 0.f )
+            , demuxBitrate( 0.f )
+            , decodedFps( 0.f )
+            , displayedFps( 0.f )
+            , lostFps( 0.f )
+            , dropRatio( 0.f )
+            , lostAudioBuffersRate( 0.f )
+        {
+        }
+
+        std::chrono::steady_clock::time_point time;
+        // Cumulative counters
+        uint64_t readBytes;
+        uint64_t demuxCorrupted;
+        uint64_t demuxDiscontinuity;
+        uint64_t decodedVideo;
+        uint64_t decodedAudio;
+        uint64_t displayedPictures;
+        uint64_t lostPictures;
+        uint64_t playedAudioBuffers;
+        uint64_t lostAudioBuffers;
+        /// The input bitrate, in bytes per second, from the read bytes
+        float inputBitrate;
+        /// The demuxer bitrate, as reported by libvlc
+        float demuxBitrate;
+        float decodedFps;
+        float displayedFps;
+        float lostFps;
+        /// The ratio of lost pictures, among the pictures that were due
+        float dropRatio;
+        float lostAudioBuffersRate;
+    };
+
+    explicit StatsCollector( Config config = Config() )
+        : m_config( std::move( config ) )
+        , m_stop( false )
+    {
+        if ( m_config.historySize == 0 )
+            m_config.historySize = 1;
+        m_thread = std::thread( &StatsCollector::run, this );
+    }
+
+    ~StatsCollector()
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        m_thread.join();
+    }
+
+    StatsCollector( const StatsCollector& ) = delete;
+    StatsCollector& operator=( const StatsCollector& ) = delete;
+
+    /// Samples a media. An existing source with the same name is replaced.
+    void add( const std::string& name, Media media )
+    {
+        auto source = std::make_shared<Source>( name, m_config.historySize );
+        source->media.reset( new Media( std::move( media ) ) );
+        insert( std::move( source ) );
+    }
+
+    /// Samples the current media of a player. An existing source with the
+    /// same name is replaced.
+    void add( const std::string& name, MediaPlayer player )
+    {
+        auto source = std::make_shared<Source>( name, m_config.historySize );
+        source->player.reset( new MediaPlayer( std::move( player ) ) );
+        insert( std::move( source ) );
+    }
+
+    /// \return false if there is no source with this name
+    bool remove( const std::string& name )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        auto it = find( name );
+        if ( it == end( m_sources ) )
+            return false;
+        m_sources.erase( it );
+        return true;
+    }
+
+    /// The latest sample of a source, or a default one if it wasn't
+    /// sampled yet
+    Sample latest( const std::string& name ) const
+    {
+        auto source = get( name );
+        if ( source == nullptr )
+            return Sample{};
+        std::lock_guard<std::mutex> lock( source->mutex );
+        if ( source->count == 0 )
+            return Sample{};
+        return source->at( source->count - 1 );
+    }
+
+    /// The samples of a source, oldest first
+    std::vector<Sample> history( const std::string& name ) const
+    {
+        std::vector<Sample> res;
+        auto source = get( name );
+        if ( source == nullptr )
+            return res;
+        std::lock_guard<std::mutex> lock( source->mutex );
+        res.reserve( source->count );
+        for ( size_t i = 0; i < source->count; ++i )
+            res.push_back( source->at( i ) );
+        return res;
+    }
+
+    /**
+     * Invokes \p f with the name and latest sample of each source, without
+     * copying the histories.
+     *
+     * \param f A void(const std::string&, const Sample&) callable. It's
+     *          invoked with the source lock held, and must not call back into
+     *          the collector.
+     */
+    template <typename Func>
+    void forEach( Func&& f ) const
+    {
+        for ( const auto& s : sources() )
+        {
+            std::lock_guard<std::mutex> lock( s->mutex );
+            if ( s->count != 0 )
+                f( s->name, s->at( s->count - 1 ) );
+        }
+    }
+
+    /// Samples all the sources now, rather than waiting for the next interval
+    void sample()
+    {
+        auto now = std::chrono::steady_clock::now();
+        for ( const auto& s : sources() )
+            s->sample( now );
+    }
+
+    /**
+     * Exports the latest samples in the Prometheus text exposition format.
+     * Each source is labelled with source="<name>".
+     */
+    std::string prometheus( const std::string& prefix = "vlc_" ) const
+    {
+        struct Metric
+        {
+            const char* name;
+            const char* type;
+            const char* help;
+            // Counters are printed as integers, so that they aren't rounded
+            uint64_t (*counter)( const Sample& );
+            double (*gauge)( const Sample& );
+        };
+        static const Metric metrics[] = {
+            { "read_bytes_total", "counter", "Bytes read from the input",
+              []( const Sample& s ) -> uint64_t { return s.readBytes; }, nullptr },
+            { "demux_corrupted_total", "counter", "Corrupted demuxed packets",
+              []( const Sample& s ) -> uint64_t { return s.demuxCorrupted; }, nullptr },
+            { "demux_discontinuity_total", "counter", "Demuxer discontinuities",
+              []( const Sample& s ) -> uint64_t { return s.demuxDiscontinuity; }, nullptr },
+            { "decoded_video_total", "counter", "Decoded video blocks",
+              []( const Sample& s ) -> uint64_t { return s.decodedVideo; }, nullptr },
+            { "decoded_audio_total", "counter", "Decoded audio blocks",
+              []( const Sample& s ) -> uint64_t { return s.decodedAudio; }, nullptr },
+            { "displayed_pictures_total", "counter", "Displayed pictures",
+              []( const Sample& s ) -> uint64_t { return s.displayedPictures; }, nullptr },
+            { "lost_pictures_total", "counter", "Lost pictures",
+              []( const Sample& s ) -> uint64_t { return s.lostPictures; }, nullptr },
+            { "played_audio_buffers_total", "counter", "Played audio buffers",
+              []( const Sample& s ) -> uint64_t { return s.playedAudioBuffers; }, nullptr },
+            { "lost_audio_buffers_total", "counter", "Lost audio buffers",
+              []( const Sample& s ) -> uint64_t { return s.lostAudioBuffers; }, nullptr },
+            { "input_bitrate_bytes", "gauge", "Input bitrate, in bytes per second",
+              nullptr, []( const Sample& s ) -> double { return s.inputBitrate; } },
+            { "demux_bitrate", "gauge", "Demuxer bitrate, as reported by libvlc",
+              nullptr, []( const Sample& s ) -> double { return s.demuxBitrate; } },
+            { "decoded_fps", "gauge", "Decoded video blocks per second",
+              nullptr, []( const Sample& s ) -> double { return s.decodedFps; } },
+            { "displayed_fps", "gauge", "Displayed pictures per second",
+              nullptr, []( const Sample& s ) -> double { return s.displayedFps; } },
+            { "lost_fps", "gauge", "Lost pictures per second",
+              nullptr, []( const Sample& s ) -> double { return s.lostFps; } },
+            { "drop_ratio", "gauge", "Ratio of lost pictures",
+              nullptr, []( const Sample& s ) -> double { return s.dropRatio; } },
+        };
+        std::vector<std::pair<std::string, Sample>> latest;
+        forEach( [&latest]( const std::string& name, const Sample& s ) {
+            latest.emplace_back( escape( name ), s );
+        });
+        std::ostringstream ss;
+        ss.precision( std::numeric_limits<double>::max_digits10 );
+        for ( const auto& m : metrics )
+        {
+            ss << "# HELP " << prefix << m.name << ' ' << m.help << '\n'
+               << "# TYPE " << prefix << m.name << ' ' << m.type << '\n';
+            for ( const auto& l : latest )
+            {
+                ss << prefix << m.name << "{source=\"" << l.first << "\"} ";
+                if ( m.counter != nullptr )
+                    ss << m.counter( l.second );
+                else
+                    ss << m.gauge( l.second );
+                ss << '\n';
+            }
+        }
+        return ss.str();
+    }
+
+private:
+    struct Source
+    {
+        Source( std::string n, size_t historySize )
+            : name( std::move( n ) )
+            , samples( historySize )
+            , head( 0 )
+            , count( 0 )
+        {
+        }
+
+        // The i-th sample, oldest first. Must be called with the lock held
+        const Sample& at( size_t i ) const
+        {
+            return samples[( head + i ) % samples.size()];
+        }
+
+        void sample( std::chrono::steady_clock::time_point now )
+        {
+            libvlc_media_stats_t stats;
+            memset( &stats, 0, sizeof( stats ) );
+            auto available = false;
+            if ( media != nullptr )
+                available = media->stats( &stats );
+            else
+            {
+                auto m = player->media();
+                if ( m != nullptr )
+                    available = m->stats( &stats );
+            }
+            if ( available == false )
+                return;
+            Sample s;
+            s.time = now;
+            s.readBytes = static_cast<uint64_t>( stats.i_read_bytes );
+            s.demuxCorrupted = static_cast<uint64_t>( stats.i_demux_corrupted );
+            s.demuxDiscontinuity = static_cast<uint64_t>( stats.i_demux_discontinuity );
+            s.decodedVideo = static_cast<uint64_t>( stats.i_decoded_video );
+            s.decodedAudio = static_cast<uint64_t>( stats.i_decoded_audio );
+            s.displayedPictures = static_cast<uint64_t>( stats.i_displayed_pictures );
+            s.lostPictures = static_cast<uint64_t>( stats.i_lost_pictures );
+            s.playedAudioBuffers = static_cast<uint64_t>( stats.i_played_abuffers );
+            s.lostAudioBuffers = static_cast<uint64_t>( stats.i_lost_abuffers );
+            s.demuxBitrate = stats.f_demux_bitrate;
+
+            std::lock_guard<std::mutex> lock( mutex );
+            if ( count != 0 )
+                computeRates( at( count - 1 ), s );
+            if ( count < samples.size() )
+                samples[( head + count++ ) % samples.size()] = s;
+            else
+            {
+                samples[head] = s;
+                head = ( head + 1 ) % samples.size();
+            }
+        }
+
+        // A counter lower than the previous one means the media was
+        // replaced, in which case it started over from 0
+        static float rate( uint64_t prev, uint64_t cur, float seconds )
+        {
+            auto delta = cur >= prev ? cur - prev : cur;
+            return static_cast<float>( delta ) / seconds;
+        }
+
+        static void computeRates( const Sample& prev, Sample& s )
+        {
+            auto seconds = std::chrono::duration<float>( s.time - prev.time ).count();
+            if ( seconds <= 0.f )
+                return;
+            s.inputBitrate = rate( prev.readBytes, s.readBytes, seconds );
+            s.decodedFps = rate( prev.decodedVideo, s.decodedVideo, seconds );
+            s.displayedFps = rate( prev.displayedPictures, s.displayedPictures, seconds );
+            s.lostFps = rate( prev.lostPictures, s.lostPictures, seconds );
+            s.lostAudioBuffersRate = rate( prev.lostAudioBuffers, s.lostAudioBuffers, seconds );
+            auto due = s.displayedFps + s.lostFps;
+            s.dropRatio = due > 0.f ? s.lostFps / due : 0.f;
+        }
+
+        const std::string name;
+        std::unique_ptr<Media> media;
+        std::unique_ptr<MediaPlayer> player;
+        mutable std::mutex mutex;
+        std::vector<Sample> samples;
+        // Index of the oldest sample
+        size_t head;
+        size_t count;
+    };
+
+    using SourcePtr = std::shared_ptr<Source>;
+
+    static std::string escape( const std::string& value )
+    {
+        std::string res;
+        res.reserve( value.size() );
+        for ( auto c : value )
+        {
+            if ( c == '\\' || c == '"' )
+                res += '\\';
+            if ( c == '\n' )
+            {
+                res += "\\n";
+                continue;
+            }
+            res += c;
+        }
+        return res;
+    }
+
+    // Must be called with the lock held
+    std::vector<SourcePtr>::iterator find( const std::string& name )
+    {
+        return std::find_if( begin( m_sources ), end( m_sources ), [&name]( const SourcePtr& s ) {
+            return s->name == name;
+        });
+    }
+
+    void insert( SourcePtr source )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        auto it = find( source->name );
+        if ( it != end( m_sources ) )
+            *it = std::move( source );
+        else
+            m_sources.push_back( std::move( source ) );
+    }
+
+    SourcePtr get( const std::string& name ) const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        for ( const auto& s : m_sources )
+        {
+            if ( s->name == name )
+                return s;
+        }
+        return nullptr;
+    }
+
+    // The sources are sampled without holding the collector lock, so that
+    // libvlc calls don't delay the registrations
+    std::vector<SourcePtr> sources() const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return m_sources;
+    }
+
+    void run()
+    {
+        auto next = std::chrono::steady_clock::now() + m_config.interval;
+        std::unique_lock<std::mutex> lock( m_mutex );
+        for ( ;; )
+        {
+            if ( m_cond.wait_until( lock, next, [this]() { return m_stop; } ) == true )
+                return;
+            lock.unlock();
+            sample();
+            // Skip the intervals that were missed, rather than catching up
+            auto now = std::chrono::steady_clock::now();
+            next += m_config.interval;
+            if ( next < now )
+                next = now + m_config.interval;
+            lock.lock();
+        }
+    }
+
+private:
+    Config m_config;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_stop;
+    std::vector<SourcePtr> m_sources;
+    std::thread m_thread;
+};
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_STATSCOLLECTOR_H
@@ -0,0 +1,640 @@
+/*****************************************************************************
+ * ThumbnailService.hpp: Batched thumbnail generation with an on-disk cache
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_THUMBNAILSERVICE_H
+#define LIBVLC_CXX_THUMBNAILSERVICE_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "Instance.hpp"
+#include "Media.hpp"
+#include "Picture.hpp"
+#include "EventManager.hpp"
+
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+
+namespace VLC
+{
+
+///
+/// \brief The ThumbnailService class generates batches of thumbnails, such as
+/// contact sheets, with a global concurrency limit and an optional on-disk
+/// cache.
+///
+/// A batch is a list of seek points for a single media. The points of a
+/// batch are generated one after the other, since libvlc doesn't tell which
+/// request a thumbnail event belongs to, while up to Config::maxConcurrent
+/// batches for different medias are processed concurrently:
+///
+///     VLC::ThumbnailService::Config config;
+///     config.cacheDirectory = "/var/cache/thumbs";
+///     VLC::ThumbnailService service( instance, config );
+///     VLC::ThumbnailService::Options opts;
+///     opts.width = 320;
+///     service.submitPositions( media, { .05f, .1f, .15f }, opts,
+///                              [](const VLC::ThumbnailService::Thumbnail& t) { ... } );
+///
+/// The callbacks are invoked from the service thread, never from libvlc's.
+/// The delivered Picture is a reference counted handle on the libvlc picture,
+/// so it can be kept around without copying the pixels.
+///
+/// When the cache is enabled, each generated picture is saved under a name
+/// derived from the MRL, the file modification time and size, the seek
+/// point, the dimensions and the picture type. Later requests for the same
+/// thumbnail skip decoding, and are delivered with the cached file path only.
+/// The file time & size are only known once the media was parsed; otherwise
+/// the cache entries are only keyed by MRL.
+///
+/// Thumbnail requests made on the same medias outside of this service would
+/// be mistaken for the service's, and must be avoided.
+///
+class ThumbnailService
+{
+public:
+    struct Config
+    {
+        Config()
+            : maxConcurrent( 4 )
+            , timeout( 10000 )
+        {
+        }
+
+        /// Maximum number of medias being thumbnailed at once
+        unsigned int maxConcurrent;
+        /// Maximum time allowed to generate a thumbnail, in ms. 0 waits indefinitely.
+        libvlc_time_t timeout;
+        /// The directory where to cache the thumbnails. Empty disables the cache.
+        std::string cacheDirectory;
+    };
+
+    struct Options
+    {
+        Options()
+            : width( 0 )
+            , height( 0 )
+            , crop( false )
+            , type( Picture::Type::Jpg )
+            , speed( Media::ThumbnailSeekSpeed::Fast )
+        {
+        }
+
+        /// The thumbnail dimensions. If one is 0, the aspect ratio is preserved.
+        uint32_t width;
+        uint32_t height;
+        bool crop;
+        Picture::Type type;
+        Media::ThumbnailSeekSpeed speed;
+    };
+
+    struct Thumbnail
+    {
+        Thumbnail()
+            : batchId( 0 )
+            , index( 0 )
+            , cached( false )
+        {
+        }
+
+        /// Returns true if the thumbnail was either generated or found in cache
+        bool isValid() const
+        {
+            return picture.isValid() == true || path.empty() == false;
+        }
+
+        /// The identifier returned by submit
+        uint64_t batchId;
+        /// The index of this thumbnail's seek point in the batch
+        size_t index;
+        /// The generated picture. Not provided when served from the cache
+        Picture picture;
+        /// The cache file path, if the cache is enabled and the picture was saved
+        std::string path;
+        /// true if this thumbnail was served from the cache
+        bool cached;
+    };
+
+    using Callback = std::function<void(const Thumbnail&)>;
+    /// Invoked once all the thumbnails of a batch were delivered
+    using BatchCallback = std::function<void(uint64_t batchId)>;
+
+    ThumbnailService( Instance instance, Config config = Config{} )
+        : m_instance( std::move( instance ) )
+        , m_config( std::move( config ) )
+        , m_nbActive( 0 )
+        , m_nextId( 0 )
+        , m_cancelTicket( 0 )
+        , m_cancelDone( 0 )
+        , m_stop( false )
+    {
+        if ( m_config.maxConcurrent == 0 )
+            m_config.maxConcurrent = 1;
+        m_thread = std::thread( &ThumbnailService::run, this );
+    }
+
+    /**
+     * Cancels all the pending requests. No callback is invoked afterward.
+     */
+    ~ThumbnailService()
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        m_cancelCond.notify_all();
+        m_thread.join();
+        for ( auto& b : m_active )
+            stopBatch( *b );
+    }
+
+    ThumbnailService( const ThumbnailService& ) = delete;
+    ThumbnailService& operator=( const ThumbnailService& ) = delete;
+
+    /**
+     * Queues a batch of thumbnails at the given times, in ms
+     *
+     * \return The batch identifier
+     */
+    uint64_t submitTimes( MediaPtr media, const std::vector<libvlc_time_t>& times,
+                          const Options& opts, Callback cb, BatchCallback done = nullptr )
+    {
+        std::vector<Seek> seeks;
+        seeks.reserve( times.size() );
+        for ( auto t : times )
+            seeks.push_back( Seek{ true, t, .0f } );
+        return submit( std::move( media ), std::move( seeks ), opts, std::move( cb ), std::move( done ) );
+    }
+
+    /**
+     * Queues a batch of thumbnails at the given positions, between 0 and 1
+     *
+     * \return The batch identifier
+     */
+    uint64_t submitPositions( MediaPtr media, const std::vector<float>& positions,
+                              const Options& opts, Callback cb, BatchCallback done = nullptr )
+    {
+        std::vector<Seek> seeks;
+        seeks.reserve( positions.size() );
+        for ( auto p : positions )
+            seeks.push_back( Seek{ false, 0, p } );
+        return submit( std::move( media ), std::move( seeks ), opts, std::move( cb ), std::move( done ) );
+    }
+
+    /**
+     * Generates a single thumbnail at the given time, in ms.
+     *
+     * The picture is kept in memory: nothing is written to the filesystem
+     * unless the cache is enabled.
+     *
+     * \return A future to the thumbnail, which is not valid if it couldn't
+     *         be generated. If the request is dropped because the service is
+     *         destroyed, the future holds a std::future_error.
+     */
+    std::future<Thumbnail> snapshot( MediaPtr media, libvlc_time_t time,
+                                     const Options& opts = Options{} )
+    {
+        auto promise = std::make_shared<std::promise<Thumbnail>>();
+        auto res = promise->get_future();
+        submitTimes( std::move( media ), { time }, opts, [promise]( const Thumbnail& t ) {
+            promise->set_value( t );
+        });
+        return res;
+    }
+
+    /**
+     * Cancels a batch. The thumbnail being generated is cancelled, and no
+     * callback will be invoked for this batch once this returns, unless called
+     * from a callback of the same batch.
+     */
+    void cancel( uint64_t batchId )
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_cancelled.push_back( batchId );
+        auto ticket = ++m_cancelTicket;
+        m_cond.notify_one();
+        // Wait for the service thread to process it, unless we're running on it
+        if ( std::this_thread::get_id() == m_thread.get_id() )
+            return;
+        m_cancelCond.wait( lock, [this, ticket]() {
+            return m_stop == true || m_cancelDone >= ticket;
+        });
+    }
+
+    /// Number of batches waiting or being processed
+    size_t pendingBatches() const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return m_queue.size() + m_nbActive;
+    }
+
+    /**
+     * Computes the cache key of a thumbnail. Exposed for cache maintenance
+     * tools, which may want to locate or evict specific entries.
+     */
+    static uint64_t cacheKey( const std::string& mrl, uint64_t mtime, uint64_t size,
+                              bool byTime, libvlc_time_t time, float pos, const Options& opts )
+    {
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ULL;
+        auto feed = [&hash]( const void* data, size_t len ) {
+            auto p = static_cast<const uint8_t*>( data );
+            for ( size_t i = 0; i < len; ++i )
+            {
+                hash ^= p[i];
+                hash *= 1099511628211ULL;
+            }
+        };
+        feed( mrl.data(), mrl.size() );
+        feed( &mtime, sizeof( mtime ) );
+        feed( &size, sizeof( size ) );
+        uint8_t flags = ( byTime ? 1 : 0 ) | ( opts.crop ? 2 : 0 );
+        feed( &flags, sizeof( flags ) );
+        if ( byTime == true )
+            feed( &time, sizeof( time ) );
+        else
+            feed( &pos, sizeof( pos ) );
+        feed( &opts.width, sizeof( opts.width ) );
+        feed( &opts.height, sizeof( opts.height ) );
+        auto type = static_cast<uint8_t>( opts.type );
+        feed( &type, sizeof( type ) );
+        return hash;
+    }
+
+private:
+    struct Seek
+    {
+        bool byTime;
+        libvlc_time_t time;
+        float pos;
+    };
+
+    struct Batch
+    {
+        uint64_t id;
+        MediaPtr media;
+        std::vector<Seek> seeks;
+        Options opts;
+        Callback cb;
+        BatchCallback done;
+        // The next seek point to process
+        size_t next;
+        Media::ThumbnailRequest* request;
+        EventManager::Handle handle;
+        // Cache key components, fetched when the batch starts
+        std::string mrl;
+        uint64_t mtime;
+        uint64_t size;
+    };
+
+    struct Completion
+    {
+        uint64_t batchId;
+        Picture picture;
+    };
+
+    uint64_t submit( MediaPtr media, std::vector<Seek> seeks, const Options& opts,
+                     Callback cb, BatchCallback done )
+    {
+        if ( media == nullptr )
+            throw std::invalid_argument( "Can't thumbnail a null media" );
+        std::unique_ptr<Batch> b( new Batch );
+        b->media = std::move( media );
+        b->seeks = std::move( seeks );
+        b->opts = opts;
+        b->cb = std::move( cb );
+        b->done = std::move( done );
+        b->next = 0;
+        b->request = nullptr;
+        b->mtime = 0;
+        b->size = 0;
+        uint64_t id;
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            id = b->id = ++m_nextId;
+            m_queue.push_back( std::move( b ) );
+        }
+        m_cond.notify_one();
+        return id;
+    }
+
+    // Called from libvlc's thumbnailer thread, the picture is only valid
+    // during this call, so take a reference on it
+    void onGenerated( uint64_t batchId, const Picture* pic )
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_completions.push_back( Completion{ batchId, pic != nullptr ? *pic : Picture{} } );
+        }
+        m_cond.notify_one();
+    }
+
+    // Returns true if a batch for the same media is already active
+    bool isMediaBusy( const Batch& b ) const
+    {
+        for ( const auto& a : m_active )
+        {
+            if ( a->media->get() == b.media->get() )
+                return true;
+        }
+        return false;
+    }
+
+    void run()
+    {
+        std::vector<Completion> completions;
+        std::vector<uint64_t> cancelled;
+        std::vector<std::unique_ptr<Batch>> toStart;
+        std::unique_lock<std::mutex> lock( m_mutex );
+        for ( ;; )
+        {
+            m_cond.wait( lock, [this]() {
+                return m_stop == true || m_completions.empty() == false ||
+                        m_cancelled.empty() == false ||
+                        ( m_queue.empty() == false && m_nbActive < m_config.maxConcurrent );
+            });
+            if ( m_stop == true )
+                return;
+            completions.swap( m_completions );
+            cancelled.swap( m_cancelled );
+            auto cancelTicket = m_cancelTicket;
+            // Pick the batches to start while the active list can't change
+            for ( auto it = begin( m_queue ); it != end( m_queue ) &&
+                  m_nbActive + toStart.size() < m_config.maxConcurrent; )
+            {
+                if ( isMediaBusy( **it ) == true )
+                {
+                    ++it;
+                    continue;
+                }
+                // Two queued batches for the same media can't start together either
+                auto busy = false;
+                for ( const auto& b : toStart )
+                    busy = busy || b->media->get() == (*it)->media->get();
+                if ( busy == true )
+                {
+                    ++it;
+                    continue;
+                }
+                toStart.push_back( std::move( *it ) );
+                it = m_queue.erase( it );
+            }
+            m_nbActive += toStart.size();
+            // Don't hold the lock while calling into libvlc, which might be
+            // about to report a thumbnail
+            lock.unlock();
+            for ( auto id : cancelled )
+                cancelBatch( id );
+            for ( auto& c : completions )
+                complete( c );
+            for ( auto& b : toStart )
+            {
+                auto raw = b.get();
+                m_active.push_back( std::move( b ) );
+                startBatch( *raw );
+            }
+            completions.clear();
+            toStart.clear();
+            lock.lock();
+            if ( cancelled.empty() == false )
+            {
+                // Also cancel the batches that didn't start yet
+                for ( auto id : cancelled )
+                {
+                    for ( auto it = begin( m_queue ); it != end( m_queue ); ++it )
+                    {
+                        if ( (*it)->id == id )
+                        {
+                            m_queue.erase( it );
+                            break;
+                        }
+                    }
+                }
+                cancelled.clear();
+            }
+            if ( m_cancelDone != cancelTicket )
+            {
+                m_cancelDone = cancelTicket;
+                m_cancelCond.notify_all();
+            }
+        }
+    }
+
+    Batch* findActive( uint64_t id )
+    {
+        for ( auto& b : m_active )
+        {
+            if ( b->id == id )
+                return b.get();
+        }
+        return nullptr;
+    }
+
+    void startBatch( Batch& b )
+    {
+        b.mrl = b.media->mrl();
+        if ( m_config.cacheDirectory.empty() == false )
+        {
+            auto mtime = b.media->fileStat( Media::FileStat::Mtime );
+            auto size = b.media->fileStat( Media::FileStat::Size );
+            b.mtime = mtime.first == true ? mtime.second : 0;
+            b.size = size.first == true ? size.second : 0;
+        }
+        auto id = b.id;
+        b.handle = b.media->eventManager().onThumbnailGenerated( [this, id]( const Picture* pic ) {
+            onGenerated( id, pic );
+        });
+        processNext( b );
+    }
+
+    // Delivers the cached thumbnails, and starts generating the next one that
+    // isn't. Finishes the batch once all its seek points were processed.
+    void processNext( Batch& b )
+    {
+        while ( b.next < b.seeks.size() )
+        {
+            auto path = cachePath( b, b.seeks[b.next] );
+            if ( path.empty() == true || fileExists( path ) == false )
+                break;
+            Thumbnail t;
+            t.batchId = b.id;
+            t.index = b.next++;
+            t.path = std::move( path );
+            t.cached = true;
+            if ( b.cb != nullptr )
+                b.cb( t );
+        }
+        if ( b.next < b.seeks.size() )
+        {
+            const auto& s = b.seeks[b.next];
+            if ( s.byTime == true )
+                b.request = b.media->thumbnailRequestByTime( m_instance, s.time, b.opts.speed,
+                                b.opts.width, b.opts.height, b.opts.crop, b.opts.type, m_config.timeout );
+            else
+                b.request = b.media->thumbnailRequestByPos( m_instance, s.pos, b.opts.speed,
+                                b.opts.width, b.opts.height, b.opts.crop, b.opts.type, m_config.timeout );
+            if ( b.request != nullptr )
+                return;
+            // Report the failure and move on to the next seek point
+            onGenerated( b.id, nullptr );
+            return;
+        }
+        finishBatch( b.id );
+    }
+
+    void complete( Completion& c )
+    {
+        auto b = findActive( c.batchId );
+        if ( b == nullptr )
+            return;
+        if ( b->request != nullptr )
+        {
+            b->media->thumbnailRequestDestroy( b->request );
+            b->request = nullptr;
+        }
+        Thumbnail t;
+        t.batchId = b->id;
+        t.index = b->next;
+        t.picture = std::move( c.picture );
+        if ( t.picture.isValid() == true )
+        {
+            auto path = cachePath( *b, b->seeks[b->next] );
+            if ( path.empty() == false && t.picture.save( path ) == true )
+                t.path = std::move( path );
+        }
+        ++b->next;
+        if ( b->cb != nullptr )
+            b->cb( t );
+        processNext( *b );
+    }
+
+    void stopBatch( Batch& b )
+    {
+        // No event will be emitted once the request is destroyed
+        if ( b.request != nullptr )
+            b.media->thumbnailRequestDestroy( b.request );
+        b.request = nullptr;
+        b.media->eventManager().unregister( b.handle );
+    }
+
+    void cancelBatch( uint64_t id )
+    {
+        auto b = findActive( id );
+        if ( b == nullptr )
+            return;
+        // Don't invoke the batch completion callback
+        b->done = nullptr;
+        b->next = b->seeks.size();
+        finishBatch( id );
+    }
+
+    void finishBatch( uint64_t id )
+    {
+        for ( auto it = begin( m_active ); it != end( m_active ); ++it )
+        {
+            if ( (*it)->id != id )
+                continue;
+            auto b = std::move( *it );
+            m_active.erase( it );
+            stopBatch( *b );
+            if ( b->done != nullptr )
+                b->done( b->id );
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                --m_nbActive;
+            }
+            // Some queued batch might now be able to start
+            m_cond.notify_one();
+            return;
+        }
+    }
+
+    std::string cachePath( const Batch& b, const Seek& s ) const
+    {
+        if ( m_config.cacheDirectory.empty() == true )
+            return {};
+        auto key = cacheKey( b.mrl, b.mtime, b.size, s.byTime, s.time, s.pos, b.opts );
+        char name[32];
+        const char* ext;
+        switch ( b.opts.type )
+        {
+            case Picture::Type::Png:
+                ext = "png";
+                break;
+            case Picture::Type::Jpg:
+                ext = "jpg";
+                break;
+            default:
+                ext = "argb";
+                break;
+        }
+        snprintf( name, sizeof( name ), "%016llx.%s", static_cast<unsigned long long>( key ), ext );
+        auto res = m_config.cacheDirectory;
+        if ( res.back() != '/' && res.back() != '\\' )
+            res += '/';
+        return res + name;
+    }
+
+    static bool fileExists( const std::string& path )
+    {
+        auto f = fopen( path.c_str(), "rb" );
+        if ( f == nullptr )
+            return false;
+        fclose( f );
+        return true;
+    }
+
+private:
+    Instance m_instance;
+    Config m_config;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::condition_variable m_cancelCond;
+    std::deque<std::unique_ptr<Batch>> m_queue;
+    std::vector<Completion> m_completions;
+    std::vector<uint64_t> m_cancelled;
+    size_t m_nbActive;
+    uint64_t m_nextId;
+    uint64_t m_cancelTicket;
+    uint64_t m_cancelDone;
+    bool m_stop;
+
+    // Only accessed from the service thread, and after it's joined
+    std::vector<std::unique_ptr<Batch>> m_active;
+    std::thread m_thread;
+};
+
+} // namespace VLC
+
+#endif
+
+#endif // LIBVLC_CXX_THUMBNAILSERVICE_H
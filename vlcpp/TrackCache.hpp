@@ -0,0 +1,214 @@
+/*****************************************************************************
+ * TrackCache.hpp: Event driven cache of a media player tracks
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_TRACKCACHE_H
+#define LIBVLC_CXX_TRACKCACHE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "EventManager.hpp"
+#include "MediaPlayer.hpp"
+#include "structures.hpp"
+
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(3, 0, 0, 0)
+
+namespace VLC
+{
+
+///
+/// \brief The TrackCache class keeps the tracks, titles & chapters of a
+/// media player, and only queries them again after they changed.
+///
+/// MediaPlayer::tracks() and the description getters rebuild their result
+/// on each call. The cache listens to the elementary stream, title & media
+/// events instead, and hands out an immutable snapshot, which is shared
+/// until the next change:
+///
+///     VLC::TrackCache cache( mp );
+///     // On each UI refresh
+///     if ( cache.version() != renderedVersion )
+///     {
+///         auto tracks = cache.tracks();
+///         renderedVersion = tracks->version;
+///         updateMenus( tracks->audio, tracks->subtitles );
+///     }
+///
+/// version() is a single atomic load, and tracks() only takes a lock to
+/// share the current snapshot when nothing changed.
+///
+class TrackCache
+{
+public:
+    struct Tracks
+    {
+        Tracks()
+            : version( 0 )
+#if LIBVLC_VERSION_INT < LIBVLC_VERSION(4, 0, 0, 0)
+            , audioTrack( -1 )
+            , videoTrack( -1 )
+            , spu( -1 )
+#endif
+            , title( -1 )
+        {
+        }
+
+        /// The cache version this snapshot was built for
+        uint64_t version;
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        /// All the tracks, see MediaTrack::selected()
+        std::vector<MediaTrack> audio;
+        std::vector<MediaTrack> video;
+        std::vector<MediaTrack> subtitles;
+#else
+        std::vector<TrackDescription> audio;
+        std::vector<TrackDescription> video;
+        std::vector<TrackDescription> subtitles;
+        /// The selected tracks identifiers, or -1
+        int audioTrack;
+        int videoTrack;
+        int spu;
+#endif
+        std::vector<TitleDescription> titles;
+        /// The current title, or -1
+        int title;
+        /// The chapters of the current title
+        std::vector<ChapterDescription> chapters;
+    };
+
+    /**
+     * Registers the event handlers on \p player. The cache keeps a
+     * reference to the player.
+     */
+    explicit TrackCache( MediaPlayer& player )
+        : m_version( 1 )
+    {
+        // Share the event manager with our copy of the player
+        auto& em = player.eventManager();
+        m_player = player;
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        m_handles.push_back( em.onESAdded( [this]( MediaTrack::Type, const std::string& ) {
+            invalidate();
+        }));
+        m_handles.push_back( em.onESDeleted( [this]( MediaTrack::Type, const std::string& ) {
+            invalidate();
+        }));
+        m_handles.push_back( em.onESSelected( [this]( MediaTrack::Type, const std::string&,
+                                                      const std::string& ) {
+            invalidate();
+        }));
+        m_handles.push_back( em.onTitleListChanged( [this]() { invalidate(); } ) );
+        m_handles.push_back( em.onTitleSelectionChanged( [this]( const TitleDescription&, int ) {
+            invalidate();
+        }));
+#else
+        m_handles.push_back( em.onESAdded( [this]( MediaTrack::Type, int ) { invalidate(); } ) );
+        m_handles.push_back( em.onESDeleted( [this]( MediaTrack::Type, int ) { invalidate(); } ) );
+        m_handles.push_back( em.onESSelected( [this]( MediaTrack::Type, int ) { invalidate(); } ) );
+        m_handles.push_back( em.onTitleChanged( [this]( int ) { invalidate(); } ) );
+#endif
+        m_handles.push_back( em.onMediaChanged( [this]( MediaPtr ) { invalidate(); } ) );
+    }
+
+    ~TrackCache()
+    {
+        auto& em = m_player.eventManager();
+        for ( const auto& h : m_handles )
+            em.unregister( h );
+    }
+
+    TrackCache( const TrackCache& ) = delete;
+    TrackCache& operator=( const TrackCache& ) = delete;
+
+    /**
+     * The current version, which changes whenever the tracks, titles or
+     * media change. It can be called from any thread, including the event
+     * handlers.
+     */
+    uint64_t version() const
+    {
+        return m_version.load( std::memory_order_acquire );
+    }
+
+    /**
+     * Returns the tracks snapshot, which is only rebuilt if the version
+     * changed since the previous call.
+     *
+     * The snapshot stays valid, though possibly outdated, as long as it's
+     * referenced.
+     */
+    std::shared_ptr<const Tracks> tracks()
+    {
+        auto version = m_version.load( std::memory_order_acquire );
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if ( m_tracks == nullptr || m_tracks->version != version )
+            m_tracks = build( version );
+        return m_tracks;
+    }
+
+    /// Forces the next tracks() call to query the player again
+    void invalidate()
+    {
+        m_version.fetch_add( 1, std::memory_order_acq_rel );
+    }
+
+private:
+    // A change notified while building is caught by the next call, since the
+    // snapshot carries the version read beforehand
+    std::shared_ptr<const Tracks> build( uint64_t version )
+    {
+        auto res = std::make_shared<Tracks>();
+        res->version = version;
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        res->audio = m_player.tracks( MediaTrack::Type::Audio, false );
+        res->video = m_player.tracks( MediaTrack::Type::Video, false );
+        res->subtitles = m_player.tracks( MediaTrack::Type::Subtitle, false );
+#else
+        res->audio = m_player.audioTrackDescription();
+        res->video = m_player.videoTrackDescription();
+        res->subtitles = m_player.spuDescription();
+        res->audioTrack = m_player.audioTrack();
+        res->videoTrack = m_player.videoTrack();
+        res->spu = m_player.spu();
+#endif
+        res->titles = m_player.titleDescription();
+        res->title = m_player.title();
+        if ( res->title >= 0 )
+            res->chapters = m_player.chapterDescription( res->title );
+        return res;
+    }
+
+private:
+    MediaPlayer m_player;
+    std::vector<EventManager::Handle> m_handles;
+    std::atomic<uint64_t> m_version;
+    std::mutex m_mutex;
+    std::shared_ptr<const Tracks> m_tracks;
+};
+
+} // namespace VLC
+
+#endif
+
+#endif // LIBVLC_CXX_TRACKCACHE_H
@@ -0,0 +1,872 @@
+/*****************************************************************************
+ * VideoConverter.hpp: Vectorized chroma conversion & scaling of video frames
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_VIDEOCONVERTER_H
+#define LIBVLC_CXX_VIDEOCONVERTER_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+# define LIBVLCPP_CONVERT_SSE2 1
+# include <emmintrin.h>
+# if defined(__AVX2__)
+#  define LIBVLCPP_CONVERT_AVX2 1
+#  include <immintrin.h>
+# endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+# define LIBVLCPP_CONVERT_NEON 1
+# include <arm_neon.h>
+#endif
+
+#include "common.hpp"
+#include "VideoFramePool.hpp"
+
+namespace VLC
+{
+
+namespace detail
+{
+namespace chroma
+{
+    /**
+     * Y'CbCr to RGB coefficients (BT.601), in 10.6 fixed point.
+     *
+     * All the implementations compute the same 16 bits arithmetic, so that
+     * the vectorized and scalar paths are bit exact.
+     */
+    struct YuvCoefficients
+    {
+        int16_t yOffset;
+        int16_t y;
+        int16_t ub;
+        int16_t ug;
+        int16_t vg;
+        int16_t vr;
+    };
+
+    inline const YuvCoefficients& yuvCoefficients( bool fullRange )
+    {
+        static const YuvCoefficients limited = { 16, 74, 129, 25, 52, 102 };
+        static const YuvCoefficients full = { 0, 64, 113, 22, 46, 90 };
+        return fullRange == true ? full : limited;
+    }
+
+    /// Byte order of the 4 bytes RGB pixels
+    enum class RgbOrder
+    {
+        RGBA,
+        BGRA,
+        ARGB,
+    };
+
+    template <typename T>
+    inline void orderChannels( RgbOrder order, T r, T g, T b, T a, T* out )
+    {
+        switch ( order )
+        {
+        case RgbOrder::RGBA:
+            out[0] = r; out[1] = g; out[2] = b; out[3] = a;
+            break;
+        case RgbOrder::BGRA:
+            out[0] = b; out[1] = g; out[2] = r; out[3] = a;
+            break;
+        case RgbOrder::ARGB:
+            out[0] = a; out[1] = r; out[2] = g; out[3] = b;
+            break;
+        }
+    }
+
+    inline uint8_t clampPixel( int v )
+    {
+        return static_cast<uint8_t>( v < 0 ? 0 : ( v > 255 ? 255 : v ) );
+    }
+
+    inline void yuvToRgbaPixel( int y, int u, int v, const YuvCoefficients& c,
+                                RgbOrder order, uint8_t* dst )
+    {
+        auto y1 = ( y - c.yOffset ) * c.y + 32;
+        u -= 128;
+        v -= 128;
+        auto r = clampPixel( ( y1 + c.vr * v ) >> 6 );
+        auto g = clampPixel( ( y1 - c.ug * u - c.vg * v ) >> 6 );
+        auto b = clampPixel( ( y1 + c.ub * u ) >> 6 );
+        orderChannels<uint8_t>( order, r, g, b, 0xFF, dst );
+    }
+
+#if defined(LIBVLCPP_CONVERT_SSE2)
+    // Writes 16 4:4:4:4 pixels from 16 bits R, G, B values
+    inline void storeRgba16( uint8_t* dst, __m128i rLo, __m128i rHi, __m128i gLo, __m128i gHi,
+                             __m128i bLo, __m128i bHi, RgbOrder order )
+    {
+        auto r = _mm_packus_epi16( rLo, rHi );
+        auto g = _mm_packus_epi16( gLo, gHi );
+        auto b = _mm_packus_epi16( bLo, bHi );
+        __m128i c[4];
+        orderChannels( order, r, g, b, _mm_set1_epi8( -1 ), c );
+        auto c01Lo = _mm_unpacklo_epi8( c[0], c[1] );
+        auto c01Hi = _mm_unpackhi_epi8( c[0], c[1] );
+        auto c23Lo = _mm_unpacklo_epi8( c[2], c[3] );
+        auto c23Hi = _mm_unpackhi_epi8( c[2], c[3] );
+        auto out = reinterpret_cast<__m128i*>( dst );
+        _mm_storeu_si128( out, _mm_unpacklo_epi16( c01Lo, c23Lo ) );
+        _mm_storeu_si128( out + 1, _mm_unpackhi_epi16( c01Lo, c23Lo ) );
+        _mm_storeu_si128( out + 2, _mm_unpacklo_epi16( c01Hi, c23Hi ) );
+        _mm_storeu_si128( out + 3, _mm_unpackhi_epi16( c01Hi, c23Hi ) );
+    }
+#endif
+
+    /// Converts a line of 4:2:0 pixels to 4 bytes RGB pixels
+    inline void yuvToRgbaRow( const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                              uint8_t* dst, unsigned width, RgbOrder order,
+                              const YuvCoefficients& c )
+    {
+        unsigned x = 0;
+#if defined(LIBVLCPP_CONVERT_AVX2)
+        {
+            const auto c128 = _mm_set1_epi16( 128 );
+            const auto yOffset = _mm256_set1_epi16( c.yOffset );
+            const auto cy = _mm256_set1_epi16( c.y );
+            const auto round = _mm256_set1_epi16( 32 );
+            const auto cub = _mm256_set1_epi16( c.ub );
+            const auto cug = _mm256_set1_epi16( c.ug );
+            const auto cvg = _mm256_set1_epi16( c.vg );
+            const auto cvr = _mm256_set1_epi16( c.vr );
+            for ( ; x + 16 <= width; x += 16 )
+            {
+                auto y16 = _mm256_cvtepu8_epi16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( y + x ) ) );
+                auto u8 = _mm_sub_epi16( _mm_cvtepu8_epi16(
+                            _mm_loadl_epi64( reinterpret_cast<const __m128i*>( u + x / 2 ) ) ), c128 );
+                auto v8 = _mm_sub_epi16( _mm_cvtepu8_epi16(
+                            _mm_loadl_epi64( reinterpret_cast<const __m128i*>( v + x / 2 ) ) ), c128 );
+                // Each chroma sample covers 2 pixels
+                auto u16 = _mm256_inserti128_si256( _mm256_castsi128_si256(
+                            _mm_unpacklo_epi16( u8, u8 ) ), _mm_unpackhi_epi16( u8, u8 ), 1 );
+                auto v16 = _mm256_inserti128_si256( _mm256_castsi128_si256(
+                            _mm_unpacklo_epi16( v8, v8 ) ), _mm_unpackhi_epi16( v8, v8 ), 1 );
+                auto y1 = _mm256_add_epi16( _mm256_mullo_epi16(
+                            _mm256_sub_epi16( y16, yOffset ), cy ), round );
+                auto r = _mm256_srai_epi16( _mm256_adds_epi16( y1, _mm256_mullo_epi16( v16, cvr ) ), 6 );
+                auto g = _mm256_srai_epi16( _mm256_sub_epi16( y1, _mm256_add_epi16(
+                            _mm256_mullo_epi16( u16, cug ), _mm256_mullo_epi16( v16, cvg ) ) ), 6 );
+                auto b = _mm256_srai_epi16( _mm256_adds_epi16( y1, _mm256_mullo_epi16( u16, cub ) ), 6 );
+                storeRgba16( dst + x * 4,
+                             _mm256_castsi256_si128( r ), _mm256_extracti128_si256( r, 1 ),
+                             _mm256_castsi256_si128( g ), _mm256_extracti128_si256( g, 1 ),
+                             _mm256_castsi256_si128( b ), _mm256_extracti128_si256( b, 1 ), order );
+            }
+        }
+#elif defined(LIBVLCPP_CONVERT_SSE2)
+        {
+            const auto zero = _mm_setzero_si128();
+            const auto c128 = _mm_set1_epi16( 128 );
+            const auto yOffset = _mm_set1_epi16( c.yOffset );
+            const auto cy = _mm_set1_epi16( c.y );
+            const auto round = _mm_set1_epi16( 32 );
+            const auto cub = _mm_set1_epi16( c.ub );
+            const auto cug = _mm_set1_epi16( c.ug );
+            const auto cvg = _mm_set1_epi16( c.vg );
+            const auto cvr = _mm_set1_epi16( c.vr );
+            for ( ; x + 16 <= width; x += 16 )
+            {
+                auto y8 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( y + x ) );
+                auto u8 = _mm_sub_epi16( _mm_unpacklo_epi8(
+                            _mm_loadl_epi64( reinterpret_cast<const __m128i*>( u + x / 2 ) ), zero ), c128 );
+                auto v8 = _mm_sub_epi16( _mm_unpacklo_epi8(
+                            _mm_loadl_epi64( reinterpret_cast<const __m128i*>( v + x / 2 ) ), zero ), c128 );
+                // Chroma contributions, for 8 samples covering 16 pixels
+                auto bu = _mm_mullo_epi16( u8, cub );
+                auto gu = _mm_add_epi16( _mm_mullo_epi16( u8, cug ), _mm_mullo_epi16( v8, cvg ) );
+                auto rv = _mm_mullo_epi16( v8, cvr );
+                auto yLo = _mm_add_epi16( _mm_mullo_epi16( _mm_sub_epi16(
+                            _mm_unpacklo_epi8( y8, zero ), yOffset ), cy ), round );
+                auto yHi = _mm_add_epi16( _mm_mullo_epi16( _mm_sub_epi16(
+                            _mm_unpackhi_epi8( y8, zero ), yOffset ), cy ), round );
+                storeRgba16( dst + x * 4,
+                    _mm_srai_epi16( _mm_adds_epi16( yLo, _mm_unpacklo_epi16( rv, rv ) ), 6 ),
+                    _mm_srai_epi16( _mm_adds_epi16( yHi, _mm_unpackhi_epi16( rv, rv ) ), 6 ),
+                    _mm_srai_epi16( _mm_sub_epi16( yLo, _mm_unpacklo_epi16( gu, gu ) ), 6 ),
+                    _mm_srai_epi16( _mm_sub_epi16( yHi, _mm_unpackhi_epi16( gu, gu ) ), 6 ),
+                    _mm_srai_epi16( _mm_adds_epi16( yLo, _mm_unpacklo_epi16( bu, bu ) ), 6 ),
+                    _mm_srai_epi16( _mm_adds_epi16( yHi, _mm_unpackhi_epi16( bu, bu ) ), 6 ),
+                    order );
+            }
+        }
+#elif defined(LIBVLCPP_CONVERT_NEON)
+        {
+            const auto c128 = vdupq_n_s16( 128 );
+            const auto yOffset = vdupq_n_s16( c.yOffset );
+            const auto round = vdupq_n_s16( 32 );
+            for ( ; x + 16 <= width; x += 16 )
+            {
+                auto y8 = vld1q_u8( y + x );
+                auto u8 = vsubq_s16( vreinterpretq_s16_u16( vmovl_u8( vld1_u8( u + x / 2 ) ) ), c128 );
+                auto v8 = vsubq_s16( vreinterpretq_s16_u16( vmovl_u8( vld1_u8( v + x / 2 ) ) ), c128 );
+                auto bu = vmulq_n_s16( u8, c.ub );
+                auto gu = vmlaq_n_s16( vmulq_n_s16( u8, c.ug ), v8, c.vg );
+                auto rv = vmulq_n_s16( v8, c.vr );
+                // Each chroma sample covers 2 pixels
+                auto bu2 = vzipq_s16( bu, bu );
+                auto gu2 = vzipq_s16( gu, gu );
+                auto rv2 = vzipq_s16( rv, rv );
+                auto yLo = vaddq_s16( vmulq_n_s16( vsubq_s16( vreinterpretq_s16_u16(
+                            vmovl_u8( vget_low_u8( y8 ) ) ), yOffset ), c.y ), round );
+                auto yHi = vaddq_s16( vmulq_n_s16( vsubq_s16( vreinterpretq_s16_u16(
+                            vmovl_u8( vget_high_u8( y8 ) ) ), yOffset ), c.y ), round );
+                auto r = vcombine_u8( vqmovun_s16( vshrq_n_s16( vqaddq_s16( yLo, rv2.val[0] ), 6 ) ),
+                                      vqmovun_s16( vshrq_n_s16( vqaddq_s16( yHi, rv2.val[1] ), 6 ) ) );
+                auto g = vcombine_u8( vqmovun_s16( vshrq_n_s16( vsubq_s16( yLo, gu2.val[0] ), 6 ) ),
+                                      vqmovun_s16( vshrq_n_s16( vsubq_s16( yHi, gu2.val[1] ), 6 ) ) );
+                auto b = vcombine_u8( vqmovun_s16( vshrq_n_s16( vqaddq_s16( yLo, bu2.val[0] ), 6 ) ),
+                                      vqmovun_s16( vshrq_n_s16( vqaddq_s16( yHi, bu2.val[1] ), 6 ) ) );
+                uint8x16x4_t px;
+                orderChannels( order, r, g, b, vdupq_n_u8( 0xFF ), px.val );
+                vst4q_u8( dst + x * 4, px );
+            }
+        }
+#endif
+        for ( ; x < width; ++x )
+            yuvToRgbaPixel( y[x], u[x / 2], v[x / 2], c, order, dst + x * 4 );
+    }
+
+    /// Interleaves two chroma lines into a NV12 line
+    inline void interleaveRow( const uint8_t* u, const uint8_t* v, uint8_t* uv, unsigned width )
+    {
+        unsigned x = 0;
+#if defined(LIBVLCPP_CONVERT_SSE2)
+        for ( ; x + 16 <= width; x += 16 )
+        {
+            auto u8 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( u + x ) );
+            auto v8 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( v + x ) );
+            auto out = reinterpret_cast<__m128i*>( uv + x * 2 );
+            _mm_storeu_si128( out, _mm_unpacklo_epi8( u8, v8 ) );
+            _mm_storeu_si128( out + 1, _mm_unpackhi_epi8( u8, v8 ) );
+        }
+#elif defined(LIBVLCPP_CONVERT_NEON)
+        for ( ; x + 16 <= width; x += 16 )
+        {
+            uint8x16x2_t px;
+            px.val[0] = vld1q_u8( u + x );
+            px.val[1] = vld1q_u8( v + x );
+            vst2q_u8( uv + x * 2, px );
+        }
+#endif
+        for ( ; x < width; ++x )
+        {
+            uv[x * 2] = u[x];
+            uv[x * 2 + 1] = v[x];
+        }
+    }
+
+    /// Splits a NV12 line in two chroma lines
+    inline void deinterleaveRow( const uint8_t* uv, uint8_t* u, uint8_t* v, unsigned width )
+    {
+        unsigned x = 0;
+#if defined(LIBVLCPP_CONVERT_SSE2)
+        const auto mask = _mm_set1_epi16( 0x00FF );
+        for ( ; x + 16 <= width; x += 16 )
+        {
+            auto a = _mm_loadu_si128( reinterpret_cast<const __m128i*>( uv + x * 2 ) );
+            auto b = _mm_loadu_si128( reinterpret_cast<const __m128i*>( uv + x * 2 + 16 ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( u + x ),
+                              _mm_packus_epi16( _mm_and_si128( a, mask ), _mm_and_si128( b, mask ) ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( v + x ),
+                              _mm_packus_epi16( _mm_srli_epi16( a, 8 ), _mm_srli_epi16( b, 8 ) ) );
+        }
+#elif defined(LIBVLCPP_CONVERT_NEON)
+        for ( ; x + 16 <= width; x += 16 )
+        {
+            auto px = vld2q_u8( uv + x * 2 );
+            vst1q_u8( u + x, px.val[0] );
+            vst1q_u8( v + x, px.val[1] );
+        }
+#endif
+        for ( ; x < width; ++x )
+        {
+            u[x] = uv[x * 2];
+            v[x] = uv[x * 2 + 1];
+        }
+    }
+
+    /// Averages 2x2 blocks of two lines into \p width output pixels
+    inline void halveRow( const uint8_t* row0, const uint8_t* row1, uint8_t* dst, unsigned width )
+    {
+        unsigned x = 0;
+#if defined(LIBVLCPP_CONVERT_SSE2)
+        const auto mask = _mm_set1_epi16( 0x00FF );
+        for ( ; x + 16 <= width; x += 16 )
+        {
+            auto m0 = _mm_avg_epu8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( row0 + x * 2 ) ),
+                                    _mm_loadu_si128( reinterpret_cast<const __m128i*>( row1 + x * 2 ) ) );
+            auto m1 = _mm_avg_epu8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( row0 + x * 2 + 16 ) ),
+                                    _mm_loadu_si128( reinterpret_cast<const __m128i*>( row1 + x * 2 + 16 ) ) );
+            auto even = _mm_packus_epi16( _mm_and_si128( m0, mask ), _mm_and_si128( m1, mask ) );
+            auto odd = _mm_packus_epi16( _mm_srli_epi16( m0, 8 ), _mm_srli_epi16( m1, 8 ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( dst + x ), _mm_avg_epu8( even, odd ) );
+        }
+#elif defined(LIBVLCPP_CONVERT_NEON)
+        for ( ; x + 16 <= width; x += 16 )
+        {
+            auto a = vld2q_u8( row0 + x * 2 );
+            auto b = vld2q_u8( row1 + x * 2 );
+            vst1q_u8( dst + x, vrhaddq_u8( vrhaddq_u8( a.val[0], b.val[0] ),
+                                           vrhaddq_u8( a.val[1], b.val[1] ) ) );
+        }
+#endif
+        // Same rounding as the vectorized averages
+        for ( ; x < width; ++x )
+        {
+            auto even = ( row0[x * 2] + row1[x * 2] + 1 ) >> 1;
+            auto odd = ( row0[x * 2 + 1] + row1[x * 2 + 1] + 1 ) >> 1;
+            dst[x] = static_cast<uint8_t>( ( even + odd + 1 ) >> 1 );
+        }
+    }
+
+    /**
+     * Scales 8 bits planes.
+     *
+     * Downscaling by 2 or more is done by successive 2x2 box averages, and
+     * the remaining ratio by a bilinear filter. The scaler keeps its scratch
+     * buffers from one call to the next.
+     */
+    class PlaneScaler
+    {
+    public:
+        void scale( const uint8_t* src, size_t srcPitch, unsigned srcWidth, unsigned srcHeight,
+                    uint8_t* dst, size_t dstPitch, unsigned dstWidth, unsigned dstHeight )
+        {
+            unsigned buffer = 0;
+            while ( srcWidth >= dstWidth * 2 && srcHeight >= dstHeight * 2 )
+            {
+                auto width = srcWidth / 2;
+                auto height = srcHeight / 2;
+                uint8_t* out;
+                size_t outPitch;
+                if ( width == dstWidth && height == dstHeight )
+                {
+                    out = dst;
+                    outPitch = dstPitch;
+                }
+                else
+                {
+                    m_buffers[buffer].resize( static_cast<size_t>( width ) * height );
+                    out = m_buffers[buffer].data();
+                    outPitch = width;
+                }
+                for ( unsigned j = 0; j < height; ++j )
+                    halveRow( src + srcPitch * j * 2, src + srcPitch * ( j * 2 + 1 ),
+                              out + outPitch * j, width );
+                if ( out == dst )
+                    return;
+                src = out;
+                srcPitch = outPitch;
+                srcWidth = width;
+                srcHeight = height;
+                buffer ^= 1;
+            }
+            if ( srcWidth == dstWidth && srcHeight == dstHeight )
+            {
+                for ( unsigned j = 0; j < dstHeight; ++j )
+                    memcpy( dst + dstPitch * j, src + srcPitch * j, dstWidth );
+                return;
+            }
+            bilinear( src, srcPitch, srcWidth, srcHeight, dst, dstPitch, dstWidth, dstHeight );
+        }
+
+    private:
+        // Source position of an output sample center, in 24.8 fixed point
+        static void samplePosition( unsigned idx, unsigned srcSize, unsigned dstSize,
+                                    unsigned& pos, unsigned& weight )
+        {
+            auto center = ( ( 2 * static_cast<int64_t>( idx ) + 1 ) * srcSize * 256 ) /
+                          ( 2 * static_cast<int64_t>( dstSize ) ) - 128;
+            if ( center < 0 )
+                center = 0;
+            pos = static_cast<unsigned>( center >> 8 );
+            weight = static_cast<unsigned>( center & 0xFF );
+            if ( pos + 1 >= srcSize )
+            {
+                pos = srcSize - 1;
+                weight = 0;
+            }
+        }
+
+        void bilinear( const uint8_t* src, size_t srcPitch, unsigned srcWidth, unsigned srcHeight,
+                       uint8_t* dst, size_t dstPitch, unsigned dstWidth, unsigned dstHeight )
+        {
+            m_xPos.resize( dstWidth );
+            m_xWeight.resize( dstWidth );
+            for ( unsigned i = 0; i < dstWidth; ++i )
+                samplePosition( i, srcWidth, dstWidth, m_xPos[i], m_xWeight[i] );
+            // One more sample, so that the horizontal pass can always read pos + 1
+            m_row.resize( srcWidth + 1 );
+            for ( unsigned j = 0; j < dstHeight; ++j )
+            {
+                unsigned yPos, yWeight;
+                samplePosition( j, srcHeight, dstHeight, yPos, yWeight );
+                auto row0 = src + srcPitch * yPos;
+                auto row1 = yWeight != 0 ? row0 + srcPitch : row0;
+                // Vertical pass, simple enough to be vectorized by the compiler
+                auto row = m_row.data();
+                for ( unsigned i = 0; i < srcWidth; ++i )
+                    row[i] = static_cast<uint16_t>( row0[i] * ( 256 - yWeight ) + row1[i] * yWeight );
+                row[srcWidth] = row[srcWidth - 1];
+                auto out = dst + dstPitch * j;
+                for ( unsigned i = 0; i < dstWidth; ++i )
+                {
+                    auto w = m_xWeight[i];
+                    auto p = m_xPos[i];
+                    out[i] = static_cast<uint8_t>( ( row[p] * ( 256 - w ) + row[p + 1] * w + 32768 ) >> 16 );
+                }
+            }
+        }
+
+    private:
+        std::vector<uint8_t> m_buffers[2];
+        std::vector<uint16_t> m_row;
+        std::vector<unsigned> m_xPos;
+        std::vector<unsigned> m_xWeight;
+    };
+} // namespace chroma
+} // namespace detail
+
+///
+/// \brief The VideoConverter class converts and scales decoded frames into
+/// one or several target layouts.
+///
+/// It takes 4:2:0 frames in their native chroma (I420, J420, YV12, NV12 or
+/// NV21), and produces one frame per configured output, in I420, NV12, RGBA,
+/// BGRA, ARGB or RV32, at any size. The source is read once, and outputs of
+/// the same size share the same scaled planes:
+///
+///     std::vector<VideoConverter::Output> outputs;
+///     outputs.emplace_back( "NV12" );
+///     outputs.emplace_back( "RGBA", 320 );
+///     auto converter = std::make_shared<VLC::VideoConverter>( outputs );
+///     VideoFramePool::Config config;
+///     config.chroma = "I420";
+///     mp.setVideoFramePool( std::make_shared<VideoFramePool>( config ), converter,
+///         []( const std::vector<VideoFrame>& frames ) {
+///             encode( frames[0] );
+///             publishPreview( frames[1] );
+///     });
+///
+/// The hot loops use SSE2, or AVX2 when the translation unit is built with
+/// AVX2 enabled, on x86, and NEON on ARM. Other targets use the equivalent
+/// scalar code, which yields the exact same pixels.
+///
+/// The RGB outputs are opaque, so the alpha channel is both straight and
+/// premultiplied.
+///
+/// The output frames come from buffers owned by the converter, and return to
+/// it once released. When all the buffers of an output are in use, convert()
+/// blocks until a frame is released.
+///
+/// A converter must only be used from one thread at a time, which is the
+/// case from the video callbacks.
+///
+class VideoConverter
+{
+public:
+    class Output
+    {
+    public:
+        Output( std::string c, unsigned w = 0, unsigned h = 0 )
+            : chroma( std::move( c ) )
+            , width( w )
+            , height( h )
+            , nbBuffers( 3 )
+        {
+        }
+
+        /// Target fourcc: "I420", "NV12", "RGBA", "BGRA", "ARGB" or "RV32"
+        std::string chroma;
+        /// Target dimensions. 0 keeps the source dimension, or the source
+        /// aspect ratio if the other dimension is set.
+        unsigned width;
+        unsigned height;
+        /// Number of frames consumers may keep at once for this output
+        unsigned nbBuffers;
+    };
+
+    /**
+     * \param outputs   The target layouts
+     * \param alignment Plane & line alignment of the output frames, in bytes.
+     *                  Must be a power of 2 >= 16
+     *
+     * \throw std::invalid_argument if an output chroma isn't supported
+     */
+    explicit VideoConverter( std::vector<Output> outputs, unsigned alignment = 64 )
+        : m_alignment( alignment )
+    {
+        if ( m_alignment < 16 || ( m_alignment & ( m_alignment - 1 ) ) != 0 )
+            m_alignment = 64;
+        m_outputs.reserve( outputs.size() );
+        for ( auto& o : outputs )
+        {
+            OutputState state( std::move( o ) );
+            if ( state.config.chroma == "I420" )
+                state.kind = Kind::I420;
+            else if ( state.config.chroma == "NV12" )
+                state.kind = Kind::NV12;
+            else if ( state.config.chroma == "RGBA" )
+                state.kind = Kind::RGBA;
+            else if ( state.config.chroma == "BGRA" || state.config.chroma == "RV32" )
+                state.kind = Kind::BGRA;
+            else if ( state.config.chroma == "ARGB" )
+                state.kind = Kind::ARGB;
+            else
+                throw std::invalid_argument( "Unsupported output chroma " + state.config.chroma );
+            if ( state.config.nbBuffers == 0 )
+                state.config.nbBuffers = 1;
+            m_outputs.push_back( std::move( state ) );
+        }
+    }
+
+    ~VideoConverter()
+    {
+        for ( auto& o : m_outputs )
+        {
+            if ( o.storage != nullptr )
+                o.storage->release();
+        }
+    }
+
+    VideoConverter( const VideoConverter& ) = delete;
+    VideoConverter& operator=( const VideoConverter& ) = delete;
+
+    /// Returns true if frames of the given fourcc can be converted
+    static bool isSupportedSource( const char* chroma )
+    {
+        return chroma != nullptr && strlen( chroma ) == 4 &&
+               sourceKind( chroma ) != SourceKind::Unsupported;
+    }
+
+    /**
+     * Converts a frame into every output.
+     *
+     * \param frame   A frame in one of the supported source chromas
+     * \param results Receives one frame per output, in the outputs order.
+     *                Its capacity is reused from one call to the next.
+     * \return false if the frame chroma isn't supported
+     */
+    bool convert( const VideoFrame& frame, std::vector<VideoFrame>& results )
+    {
+        results.clear();
+        if ( frame.isValid() == false || isSupportedSource( frame.chroma() ) == false )
+            return false;
+        Planes source;
+        if ( readSource( frame, source ) == false )
+            return false;
+        for ( auto& s : m_scaled )
+            s.valid = false;
+        for ( auto& o : m_outputs )
+        {
+            unsigned width, height;
+            outputSize( o.config, source.width, source.height, width, height );
+            auto slot = acquire( o, width, height );
+            slot->sequence = frame.sequence();
+            write( o, source.width == width && source.height == height ?
+                        source : scaled( source, width, height ), slot );
+            results.push_back( VideoFrame( slot ) );
+        }
+        return true;
+    }
+
+    size_t nbOutputs() const
+    {
+        return m_outputs.size();
+    }
+
+    const Output& output( size_t idx ) const
+    {
+        return m_outputs.at( idx ).config;
+    }
+
+private:
+    enum class Kind
+    {
+        I420,
+        NV12,
+        RGBA,
+        BGRA,
+        ARGB,
+    };
+
+    enum class SourceKind
+    {
+        Unsupported,
+        I420,
+        YV12,
+        NV12,
+        NV21,
+    };
+
+    struct OutputState
+    {
+        explicit OutputState( Output o )
+            : config( std::move( o ) )
+            , kind( Kind::I420 )
+            , storage( nullptr )
+        {
+        }
+
+        Output config;
+        Kind kind;
+        detail::VideoFrameStorage* storage;
+    };
+
+    // Planar 4:2:0 planes
+    struct Planes
+    {
+        unsigned width;
+        unsigned height;
+        bool fullRange;
+        const uint8_t* planes[3];
+        size_t pitches[3];
+    };
+
+    struct ScaledPlanes
+    {
+        Planes planes;
+        bool valid;
+        std::vector<uint8_t> buffer;
+    };
+
+    static SourceKind sourceKind( const char* chroma )
+    {
+        auto is = [chroma]( const char* fourcc ) {
+            return memcmp( chroma, fourcc, 4 ) == 0;
+        };
+        if ( is( "I420" ) || is( "J420" ) || is( "IYUV" ) )
+            return SourceKind::I420;
+        if ( is( "YV12" ) )
+            return SourceKind::YV12;
+        if ( is( "NV12" ) )
+            return SourceKind::NV12;
+        if ( is( "NV21" ) )
+            return SourceKind::NV21;
+        return SourceKind::Unsupported;
+    }
+
+    static void outputSize( const Output& o, unsigned srcWidth, unsigned srcHeight,
+                            unsigned& width, unsigned& height )
+    {
+        width = o.width;
+        height = o.height;
+        if ( width == 0 && height == 0 )
+        {
+            width = srcWidth;
+            height = srcHeight;
+        }
+        else if ( width == 0 )
+            width = static_cast<unsigned>( ( static_cast<uint64_t>( srcWidth ) * height + srcHeight / 2 ) / srcHeight );
+        else if ( height == 0 )
+            height = static_cast<unsigned>( ( static_cast<uint64_t>( srcHeight ) * width + srcWidth / 2 ) / srcWidth );
+        if ( width == 0 )
+            width = 1;
+        if ( height == 0 )
+            height = 1;
+    }
+
+    bool readSource( const VideoFrame& frame, Planes& source )
+    {
+        source.width = frame.width();
+        source.height = frame.height();
+        source.fullRange = frame.chroma()[0] == 'J';
+        if ( source.width == 0 || source.height == 0 )
+            return false;
+        source.planes[0] = frame.plane( 0 );
+        source.pitches[0] = frame.pitch( 0 );
+        auto kind = sourceKind( frame.chroma() );
+        if ( kind == SourceKind::I420 || kind == SourceKind::YV12 )
+        {
+            auto u = kind == SourceKind::I420 ? 1u : 2u;
+            auto v = kind == SourceKind::I420 ? 2u : 1u;
+            source.planes[1] = frame.plane( u );
+            source.pitches[1] = frame.pitch( u );
+            source.planes[2] = frame.plane( v );
+            source.pitches[2] = frame.pitch( v );
+            return true;
+        }
+        // Split the interleaved chroma, so that the scaling & conversion only
+        // deal with planar formats
+        auto chromaWidth = ( source.width + 1 ) / 2;
+        auto chromaHeight = ( source.height + 1 ) / 2;
+        auto planeSize = static_cast<size_t>( chromaWidth ) * chromaHeight;
+        m_sourceChroma.resize( planeSize * 2 );
+        auto u = m_sourceChroma.data();
+        auto v = u + planeSize;
+        // NV21 stores V first
+        auto first = kind == SourceKind::NV12 ? u : v;
+        auto second = kind == SourceKind::NV12 ? v : u;
+        for ( unsigned j = 0; j < chromaHeight; ++j )
+            detail::chroma::deinterleaveRow( frame.plane( 1 ) + frame.pitch( 1 ) * j,
+                                             first + chromaWidth * j, second + chromaWidth * j,
+                                             chromaWidth );
+        source.planes[1] = u;
+        source.planes[2] = v;
+        source.pitches[1] = source.pitches[2] = chromaWidth;
+        return true;
+    }
+
+    // Returns the source planes scaled to the given size, computing them once
+    // per frame
+    const Planes& scaled( const Planes& source, unsigned width, unsigned height )
+    {
+        ScaledPlanes* target = nullptr;
+        for ( auto& s : m_scaled )
+        {
+            if ( s.planes.width == width && s.planes.height == height )
+            {
+                if ( s.valid == true )
+                    return s.planes;
+                target = &s;
+                break;
+            }
+        }
+        if ( target == nullptr )
+        {
+            m_scaled.emplace_back();
+            target = &m_scaled.back();
+        }
+        auto chromaWidth = ( width + 1 ) / 2;
+        auto chromaHeight = ( height + 1 ) / 2;
+        auto lumaSize = static_cast<size_t>( width ) * height;
+        auto chromaSize = static_cast<size_t>( chromaWidth ) * chromaHeight;
+        target->buffer.resize( lumaSize + chromaSize * 2 );
+        auto& p = target->planes;
+        p.width = width;
+        p.height = height;
+        p.fullRange = source.fullRange;
+        auto out = target->buffer.data();
+        p.planes[0] = out;
+        p.planes[1] = out + lumaSize;
+        p.planes[2] = out + lumaSize + chromaSize;
+        p.pitches[0] = width;
+        p.pitches[1] = p.pitches[2] = chromaWidth;
+        m_scaler.scale( source.planes[0], source.pitches[0], source.width, source.height,
+                        out, width, width, height );
+        for ( unsigned i = 1; i < 3; ++i )
+            m_scaler.scale( source.planes[i], source.pitches[i],
+                            ( source.width + 1 ) / 2, ( source.height + 1 ) / 2,
+                            const_cast<uint8_t*>( p.planes[i] ), chromaWidth,
+                            chromaWidth, chromaHeight );
+        target->valid = true;
+        return p;
+    }
+
+    detail::VideoFrameSlot* acquire( OutputState& o, unsigned width, unsigned height )
+    {
+        if ( o.storage == nullptr || o.storage->layout.width != width ||
+             o.storage->layout.height != height )
+        {
+            // Outstanding frames keep the previous storage alive
+            if ( o.storage != nullptr )
+                o.storage->release();
+            detail::VideoFrameLayout layout;
+            detail::computeVideoFrameLayout( layout, o.kind == Kind::BGRA ? "BGRA" : o.config.chroma.c_str(),
+                                     width, height, m_alignment );
+            if ( o.config.chroma == "RV32" )
+                memcpy( layout.chroma, "RV32", 4 );
+            o.storage = new detail::VideoFrameStorage( layout, o.config.nbBuffers, m_alignment );
+        }
+        return o.storage->acquire();
+    }
+
+    static void write( const OutputState& o, const Planes& in, detail::VideoFrameSlot* slot )
+    {
+        const auto& layout = slot->storage->layout;
+        auto plane = [slot, &layout]( unsigned idx ) {
+            return slot->pixels + layout.offsets[idx];
+        };
+        auto chromaWidth = ( in.width + 1 ) / 2;
+        auto chromaHeight = ( in.height + 1 ) / 2;
+        switch ( o.kind )
+        {
+        case Kind::I420:
+            for ( unsigned j = 0; j < in.height; ++j )
+                memcpy( plane( 0 ) + layout.pitches[0] * j, in.planes[0] + in.pitches[0] * j, in.width );
+            for ( unsigned i = 1; i < 3; ++i )
+                for ( unsigned j = 0; j < chromaHeight; ++j )
+                    memcpy( plane( i ) + layout.pitches[i] * j, in.planes[i] + in.pitches[i] * j, chromaWidth );
+            break;
+        case Kind::NV12:
+            for ( unsigned j = 0; j < in.height; ++j )
+                memcpy( plane( 0 ) + layout.pitches[0] * j, in.planes[0] + in.pitches[0] * j, in.width );
+            for ( unsigned j = 0; j < chromaHeight; ++j )
+                detail::chroma::interleaveRow( in.planes[1] + in.pitches[1] * j,
+                                               in.planes[2] + in.pitches[2] * j,
+                                               plane( 1 ) + layout.pitches[1] * j, chromaWidth );
+            break;
+        case Kind::RGBA:
+        case Kind::BGRA:
+        case Kind::ARGB:
+        {
+            const auto& c = detail::chroma::yuvCoefficients( in.fullRange );
+            auto order = o.kind == Kind::RGBA ? detail::chroma::RgbOrder::RGBA :
+                         ( o.kind == Kind::BGRA ? detail::chroma::RgbOrder::BGRA :
+                                                  detail::chroma::RgbOrder::ARGB );
+            for ( unsigned j = 0; j < in.height; ++j )
+                detail::chroma::yuvToRgbaRow( in.planes[0] + in.pitches[0] * j,
+                                              in.planes[1] + in.pitches[1] * ( j / 2 ),
+                                              in.planes[2] + in.pitches[2] * ( j / 2 ),
+                                              plane( 0 ) + layout.pitches[0] * j, in.width,
+                                              order, c );
+            break;
+        }
+        }
+    }
+
+private:
+    std::vector<OutputState> m_outputs;
+    unsigned m_alignment;
+    std::vector<ScaledPlanes> m_scaled;
+    std::vector<uint8_t> m_sourceChroma;
+    detail::chroma::PlaneScaler m_scaler;
+};
+
+namespace detail
+{
+    // State shared by the callbacks installed by
+    // MediaPlayer::setVideoFramePool( pool, converter, onFrames )
+    template <typename Func>
+    struct VideoConverterHandler
+    {
+        template <typename FuncFwd>
+        VideoConverterHandler( std::shared_ptr<VideoConverter> c, FuncFwd&& f )
+            : converter( std::move( c ) )
+            , onFrames( std::forward<FuncFwd>( f ) )
+        {
+        }
+
+        std::shared_ptr<VideoConverter> converter;
+        std::vector<VideoFrame> frames;
+        Func onFrames;
+    };
+}
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_VIDEOCONVERTER_H
@@ -0,0 +1,199 @@
+/*****************************************************************************
+ * VideoFrameFanout.hpp: Distribution of decoded frames to several consumers
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_VIDEOFRAMEFANOUT_H
+#define LIBVLC_CXX_VIDEOFRAMEFANOUT_H
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "VideoFramePool.hpp"
+#include "VideoFrameQueue.hpp"
+
+namespace VLC
+{
+
+///
+/// \brief The VideoFrameFanout class hands the frames of a single decode
+/// to several consumers.
+///
+/// Each subscriber gets its own VideoFrameQueue, with its own depth and
+/// overflow policy. The queues share the frames: a frame is only a new
+/// reference on the pool buffer, which goes back to the pool once every
+/// subscriber released it.
+///
+///     auto fanout = std::make_shared<VLC::VideoFrameFanout>();
+///     auto preview = fanout->subscribe( 1, VLC::VideoFrameQueue::Overflow::KeepLatest );
+///     auto analyzer = fanout->subscribe( 4, VLC::VideoFrameQueue::Overflow::DropOldest );
+///     VLC::VideoFramePool::Config config;
+///     config.nbSpareBuffers = fanout->maxHeldFrames();
+///     mp.setVideoFramePool( std::make_shared<VLC::VideoFramePool>( config ),
+///         [fanout](VLC::VideoFrame f) { fanout->push( std::move( f ) ); } );
+///
+/// Subscribers can be added or removed at any time, from any thread. push()
+/// must only be called from a single producer thread, which is the case
+/// from the video callbacks.
+///
+/// A subscriber using the Block policy backpressures the decoder, and thus
+/// delays the other subscribers as well.
+///
+class VideoFrameFanout
+{
+public:
+    using Subscriber = std::shared_ptr<VideoFrameQueue>;
+
+    VideoFrameFanout()
+        : m_subscribers( std::make_shared<Subscribers>() )
+        , m_closed( false )
+    {
+    }
+
+    ~VideoFrameFanout()
+    {
+        close();
+    }
+
+    VideoFrameFanout( const VideoFrameFanout& ) = delete;
+    VideoFrameFanout& operator=( const VideoFrameFanout& ) = delete;
+
+    /**
+     * Adds a subscriber. It receives the frames pushed from now on.
+     *
+     * \param depth   The maximum number of frames pending for this subscriber
+     * \param policy  The behavior when this subscriber lags behind
+     * \return The queue to pop frames from, from the subscriber thread
+     */
+    Subscriber subscribe( size_t depth, VideoFrameQueue::Overflow policy = VideoFrameQueue::Overflow::DropOldest )
+    {
+        auto queue = std::make_shared<VideoFrameQueue>( depth, policy );
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if ( m_closed == true )
+            queue->close();
+        else
+            update( [&queue]( Subscribers& s ) { s.push_back( queue ); } );
+        return queue;
+    }
+
+    /**
+     * Removes a subscriber and closes its queue. The pending frames stay
+     * available to pop. A push() in progress can still deliver one last frame.
+     *
+     * \return false if \p queue isn't subscribed to this fanout
+     */
+    bool unsubscribe( const Subscriber& queue )
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            auto found = false;
+            update( [&queue, &found]( Subscribers& s ) {
+                auto it = std::find( s.begin(), s.end(), queue );
+                if ( it == s.end() )
+                    return;
+                s.erase( it );
+                found = true;
+            });
+            if ( found == false )
+                return false;
+        }
+        queue->close();
+        return true;
+    }
+
+    /**
+     * Hands a frame to every subscriber. Must only be called from the
+     * producer thread.
+     */
+    void push( VideoFrame frame )
+    {
+        if ( frame.isValid() == false )
+            return;
+        std::shared_ptr<const Subscribers> subscribers;
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            subscribers = m_subscribers;
+        }
+        if ( subscribers->empty() == true )
+            return;
+        // Each queue gets its own reference, the last one moves ours
+        auto last = subscribers->size() - 1;
+        for ( size_t i = 0; i < last; ++i )
+            (*subscribers)[i]->push( frame );
+        (*subscribers)[last]->push( std::move( frame ) );
+    }
+
+    /// Removes every subscriber, and closes their queues
+    void close()
+    {
+        std::shared_ptr<const Subscribers> subscribers;
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_closed = true;
+            subscribers = std::move( m_subscribers );
+            m_subscribers = std::make_shared<Subscribers>();
+        }
+        for ( const auto& s : *subscribers )
+            s->close();
+    }
+
+    size_t nbSubscribers() const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return m_subscribers->size();
+    }
+
+    /**
+     * The number of frames the current subscribers may hold at once: their
+     * pending frames, and the one each of them is processing.
+     * The pool spare buffers should be sized accordingly, otherwise the
+     * decoder stalls whenever the subscribers are lagging.
+     */
+    unsigned maxHeldFrames() const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        size_t res = 0;
+        for ( const auto& s : *m_subscribers )
+            res += s->capacity() + 1;
+        return static_cast<unsigned>( res );
+    }
+
+private:
+    using Subscribers = std::vector<Subscriber>;
+
+    // The producer iterates over an immutable snapshot: the list is copied
+    // whenever it changes. Must be called with the lock held.
+    template <typename Func>
+    void update( Func&& f )
+    {
+        auto copy = std::make_shared<Subscribers>( *m_subscribers );
+        f( *copy );
+        m_subscribers = std::move( copy );
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::shared_ptr<const Subscribers> m_subscribers;
+    bool m_closed;
+};
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_VIDEOFRAMEFANOUT_H
@@ -0,0 +1,589 @@
+/*****************************************************************************
+ * VideoFramePool.hpp: Zero-copy video frame pool for the video callbacks
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_VIDEOFRAMEPOOL_H
+#define LIBVLC_CXX_VIDEOFRAMEPOOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "common.hpp"
+
+namespace VLC
+{
+
+class VideoFramePool;
+
+namespace detail
+{
+    /// Maximum number of planes libvlc will ever ask for (PICTURE_PLANE_MAX)
+    static const unsigned VideoFrameMaxPlanes = 5;
+
+    struct VideoFrameLayout
+    {
+        char chroma[5];
+        unsigned width;
+        unsigned height;
+        unsigned nbPlanes;
+        unsigned pitches[VideoFrameMaxPlanes];
+        unsigned lines[VideoFrameMaxPlanes];
+        size_t offsets[VideoFrameMaxPlanes];
+        size_t frameSize;
+    };
+
+    template <typename T>
+    inline T alignUp( T value, T alignment )
+    {
+        return ( value + alignment - 1 ) / alignment * alignment;
+    }
+
+    /**
+     * Computes the plane layout for a given chroma.
+     * Returns false if the chroma isn't one we know how to lay out.
+     */
+    inline bool computeVideoFrameLayout( VideoFrameLayout& layout, const char* chroma,
+                                         unsigned width, unsigned height,
+                                         unsigned alignment )
+    {
+        memcpy( layout.chroma, chroma, 4 );
+        layout.chroma[4] = 0;
+        layout.width = width;
+        layout.height = height;
+
+        auto is = [chroma]( const char* fourcc ) {
+            return memcmp( chroma, fourcc, 4 ) == 0;
+        };
+        // Bytes per pixel on the first plane, and the chroma planes subsampling
+        unsigned bpp = 1;
+        unsigned nbPlanes = 1;
+        unsigned hDiv = 1;
+        unsigned vDiv = 1;
+        bool interleavedChroma = false;
+        if ( is( "RV32" ) || is( "RGBA" ) || is( "BGRA" ) || is( "ARGB" ) || is( "RGBX" ) )
+            bpp = 4;
+        else if ( is( "RV24" ) )
+            bpp = 3;
+        else if ( is( "RV16" ) || is( "RV15" ) || is( "YUYV" ) || is( "YUY2" ) ||
+                  is( "UYVY" ) || is( "YVYU" ) )
+        {
+            bpp = 2;
+            // Packed 4:2:2 formats need an even width
+            width = alignUp( width, 2u );
+        }
+        else if ( is( "GREY" ) )
+            bpp = 1;
+        else if ( is( "I420" ) || is( "J420" ) || is( "YV12" ) || is( "IYUV" ) )
+        {
+            nbPlanes = 3;
+            hDiv = vDiv = 2;
+        }
+        else if ( is( "I422" ) || is( "J422" ) )
+        {
+            nbPlanes = 3;
+            hDiv = 2;
+        }
+        else if ( is( "I444" ) || is( "J444" ) )
+            nbPlanes = 3;
+        else if ( is( "NV12" ) || is( "NV21" ) )
+        {
+            nbPlanes = 2;
+            hDiv = vDiv = 2;
+            interleavedChroma = true;
+        }
+        else
+            return false;
+
+        // Keep the luma plane dimensions multiple of the chroma subsampling, so
+        // that decoders writing full macroblocks stay within the buffer.
+        auto lumaLines = alignUp( height, 2u * vDiv );
+        layout.nbPlanes = nbPlanes;
+        layout.pitches[0] = alignUp( width * bpp, alignment );
+        layout.lines[0] = lumaLines;
+        for ( unsigned i = 1; i < nbPlanes; ++i )
+        {
+            auto chromaWidth = ( width + hDiv - 1 ) / hDiv;
+            if ( interleavedChroma == true )
+                chromaWidth *= 2;
+            layout.pitches[i] = alignUp( chromaWidth, alignment );
+            layout.lines[i] = lumaLines / vDiv;
+        }
+        size_t offset = 0;
+        for ( unsigned i = 0; i < VideoFrameMaxPlanes; ++i )
+        {
+            if ( i >= nbPlanes )
+            {
+                layout.pitches[i] = layout.lines[i] = 0;
+                layout.offsets[i] = offset;
+                continue;
+            }
+            layout.offsets[i] = offset;
+            offset += static_cast<size_t>( layout.pitches[i] ) * layout.lines[i];
+        }
+        layout.frameSize = offset;
+        return true;
+    }
+
+    struct VideoFrameStorage;
+
+    struct VideoFrameSlot
+    {
+        VideoFrameStorage* storage;
+        unsigned char* pixels;
+        // Number of references: one for libvlc while it writes to the buffer,
+        // and one per VideoFrame handle.
+        std::atomic<unsigned> refs;
+        uint64_t sequence;
+    };
+
+    /**
+     * Storage for one format configuration.
+     * A new storage is allocated each time libvlc (re)negotiates the format,
+     * and lives until the pool and every frame using it are gone.
+     */
+    struct VideoFrameStorage
+    {
+        VideoFrameStorage( const VideoFrameLayout& l, unsigned count, unsigned alignment )
+            : layout( l )
+            , refs( 1 )
+            , nbSlots( count )
+            , slots( new VideoFrameSlot[count] )
+        {
+            auto frameSize = alignUp<size_t>( layout.frameSize, alignment );
+            memory.reset( new unsigned char[frameSize * count + alignment] );
+            auto base = reinterpret_cast<uintptr_t>( memory.get() );
+            auto aligned = ( base + alignment - 1 ) / alignment * alignment;
+            auto pixels = memory.get() + ( aligned - base );
+            for ( unsigned i = 0; i < count; ++i )
+            {
+                slots[i].storage = this;
+                slots[i].pixels = pixels + frameSize * i;
+                slots[i].refs.store( 0, std::memory_order_relaxed );
+                slots[i].sequence = 0;
+            }
+        }
+
+        void retain()
+        {
+            refs.fetch_add( 1, std::memory_order_relaxed );
+        }
+
+        void release()
+        {
+            if ( refs.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+                delete this;
+        }
+
+        VideoFrameSlot* tryAcquire()
+        {
+            for ( unsigned i = 0; i < nbSlots; ++i )
+            {
+                unsigned expected = 0;
+                // Sequentially consistent, see releaseSlot()
+                if ( slots[i].refs.compare_exchange_strong( expected, 1 ) )
+                {
+                    retain();
+                    return &slots[i];
+                }
+            }
+            return nullptr;
+        }
+
+        /// Blocks until a frame is handed back by its consumers
+        VideoFrameSlot* acquire()
+        {
+            auto slot = tryAcquire();
+            if ( slot == nullptr )
+                parker.wait( [this, &slot]() { return ( slot = tryAcquire() ) != nullptr; } );
+            return slot;
+        }
+
+        static void releaseSlot( VideoFrameSlot* slot )
+        {
+            // Sequentially consistent, so that it pairs with the waiters check
+            // in ThreadParker::notify()
+            if ( slot->refs.fetch_sub( 1 ) != 1 )
+                return;
+            auto storage = slot->storage;
+            storage->parker.notify();
+            storage->release();
+        }
+
+        VideoFrameLayout layout;
+        std::atomic<unsigned> refs;
+        unsigned nbSlots;
+        std::unique_ptr<VideoFrameSlot[]> slots;
+        std::unique_ptr<unsigned char[]> memory;
+        ThreadParker parker;
+    };
+}
+
+///
+/// \brief The VideoFrame class is a reference counted handle to a decoded
+/// picture owned by a VideoFramePool.
+///
+/// Copying a VideoFrame only bumps a reference counter. The underlying buffer
+/// is handed back to the pool once the last handle is released, so consumers
+/// can keep a frame for as long as they need without copying its planes.
+///
+class VideoFrame
+{
+public:
+    VideoFrame() : m_slot( nullptr ) {}
+
+    VideoFrame( const VideoFrame& other )
+        : m_slot( other.m_slot )
+    {
+        if ( m_slot != nullptr )
+            m_slot->refs.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    VideoFrame( VideoFrame&& other ) noexcept
+        : m_slot( other.m_slot )
+    {
+        other.m_slot = nullptr;
+    }
+
+    VideoFrame& operator=( VideoFrame other ) noexcept
+    {
+        std::swap( m_slot, other.m_slot );
+        return *this;
+    }
+
+    ~VideoFrame()
+    {
+        reset();
+    }
+
+    /// Releases this handle. The frame becomes invalid
+    void reset()
+    {
+        if ( m_slot != nullptr )
+            detail::VideoFrameStorage::releaseSlot( m_slot );
+        m_slot = nullptr;
+    }
+
+    bool isValid() const
+    {
+        return m_slot != nullptr;
+    }
+
+    /// The frame fourcc, as negotiated with libvlc (ie. "I420", "RV32", ...)
+    const char* chroma() const
+    {
+        return layout().chroma;
+    }
+
+    unsigned width() const
+    {
+        return layout().width;
+    }
+
+    unsigned height() const
+    {
+        return layout().height;
+    }
+
+    unsigned planeCount() const
+    {
+        return layout().nbPlanes;
+    }
+
+    const uint8_t* plane( unsigned idx ) const
+    {
+        assert( idx < planeCount() );
+        return m_slot->pixels + layout().offsets[idx];
+    }
+
+    /// Line size, in bytes, of the given plane
+    unsigned pitch( unsigned idx ) const
+    {
+        assert( idx < planeCount() );
+        return layout().pitches[idx];
+    }
+
+    /// Number of lines allocated for the given plane
+    unsigned lines( unsigned idx ) const
+    {
+        assert( idx < planeCount() );
+        return layout().lines[idx];
+    }
+
+    /// Monotonic display sequence number, starting from 1
+    uint64_t sequence() const
+    {
+        return m_slot->sequence;
+    }
+
+    /// Returns true if both handles point to the same pool buffer
+    bool operator==( const VideoFrame& other ) const
+    {
+        return m_slot == other.m_slot;
+    }
+
+    bool operator!=( const VideoFrame& other ) const
+    {
+        return m_slot != other.m_slot;
+    }
+
+private:
+    // Adopts a reference that was already taken on the slot
+    explicit VideoFrame( detail::VideoFrameSlot* slot ) : m_slot( slot ) {}
+
+    const detail::VideoFrameLayout& layout() const
+    {
+        assert( m_slot != nullptr );
+        return m_slot->storage->layout;
+    }
+
+    // Gives the reference back to the caller, leaving this handle empty
+    detail::VideoFrameSlot* detach()
+    {
+        auto slot = m_slot;
+        m_slot = nullptr;
+        return slot;
+    }
+
+private:
+    detail::VideoFrameSlot* m_slot;
+
+    friend class VideoFramePool;
+    friend class VideoFrameQueue;
+    friend class VideoConverter;
+};
+
+///
+/// \brief The VideoFramePool class preallocates aligned picture buffers for
+/// the MediaPlayer video memory callbacks.
+///
+/// The buffers are allocated once, when libvlc negotiates the video format,
+/// and are handed to the decoder in the lock callback. Displayed pictures are
+/// published as VideoFrame handles, and return to the pool once every handle
+/// to them has been released. This avoids any allocation or copy per frame.
+///
+/// Use MediaPlayer::setVideoFramePool() to wire a pool to a player.
+///
+/// The format/lock/unlock/display/cleanup methods are meant to be called from
+/// the libvlc video callbacks, which are all invoked from the video output thread.
+///
+class VideoFramePool
+{
+public:
+    class Config
+    {
+    public:
+        Config()
+            : width( 0 )
+            , height( 0 )
+            , nbBuffers( 3 )
+            , nbSpareBuffers( 3 )
+            , alignment( 64 )
+        {
+        }
+
+        /// Requested fourcc, or an empty string to keep the decoder's chroma.
+        /// If the decoder chroma can't be handled by the pool, RV32 is used.
+        std::string chroma;
+        /// Requested dimensions, or 0 to keep the source dimensions
+        unsigned width;
+        unsigned height;
+        /// Number of pictures libvlc may use at once
+        unsigned nbBuffers;
+        /// Number of frames consumers may keep at once without stalling the
+        /// decoder. When all buffers are in use, the lock callback blocks until
+        /// a frame is released.
+        unsigned nbSpareBuffers;
+        /// Plane & line alignment, in bytes. Must be a power of 2 >= 16
+        unsigned alignment;
+    };
+
+    explicit VideoFramePool( const Config& config = Config() )
+        : m_config( config )
+        , m_storage( nullptr )
+        , m_pending( nullptr )
+        , m_sequence( 0 )
+        , m_nbDisplayed( 0 )
+        , m_nbDropped( 0 )
+    {
+        if ( m_config.alignment < 16 || ( m_config.alignment & ( m_config.alignment - 1 ) ) != 0 )
+            m_config.alignment = 64;
+        if ( m_config.nbBuffers == 0 )
+            m_config.nbBuffers = 1;
+    }
+
+    ~VideoFramePool()
+    {
+        cleanup();
+    }
+
+    VideoFramePool( const VideoFramePool& ) = delete;
+    VideoFramePool& operator=( const VideoFramePool& ) = delete;
+
+    /**
+     * Format callback implementation.
+     * Matches MediaPlayer::setVideoFormatCallbacks() setup callback prototype.
+     *
+     * \return The number of pictures libvlc can use, 0 in case of error
+     */
+    uint32_t format( char* chroma, uint32_t* width, uint32_t* height,
+                     uint32_t* pitches, uint32_t* lines )
+    {
+        cleanup();
+        if ( m_config.chroma.size() == 4 )
+            memcpy( chroma, m_config.chroma.c_str(), 4 );
+        if ( m_config.width != 0 )
+            *width = m_config.width;
+        if ( m_config.height != 0 )
+            *height = m_config.height;
+        detail::VideoFrameLayout layout;
+        if ( detail::computeVideoFrameLayout( layout, chroma, *width, *height,
+                                              m_config.alignment ) == false )
+        {
+            memcpy( chroma, "RV32", 4 );
+            if ( detail::computeVideoFrameLayout( layout, chroma, *width, *height,
+                                                  m_config.alignment ) == false )
+                return 0;
+        }
+        for ( unsigned i = 0; i < detail::VideoFrameMaxPlanes; ++i )
+        {
+            pitches[i] = layout.pitches[i];
+            lines[i] = layout.lines[i];
+        }
+        m_storage = new detail::VideoFrameStorage( layout,
+                        m_config.nbBuffers + m_config.nbSpareBuffers, m_config.alignment );
+        return m_config.nbBuffers;
+    }
+
+    /// Cleanup callback implementation. Outstanding frames stay valid.
+    void cleanup()
+    {
+        releasePending();
+        if ( m_storage != nullptr )
+            m_storage->release();
+        m_storage = nullptr;
+    }
+
+    /// Lock callback implementation
+    void* lock( void** planes )
+    {
+        assert( m_storage != nullptr );
+        // A picture that was prepared but never displayed won't be displayed
+        // anymore: release it before handing out a new one.
+        releasePending();
+        auto slot = m_storage->acquire();
+        for ( unsigned i = 0; i < m_storage->layout.nbPlanes; ++i )
+            planes[i] = slot->pixels + m_storage->layout.offsets[i];
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        // libvlc 4 copies the picture in the buffer between lock & unlock,
+        // and displays it later: keep libvlc's reference until then.
+        m_pending.store( slot, std::memory_order_relaxed );
+#endif
+        return slot;
+    }
+
+    /// Unlock callback implementation
+    void unlock( void* picture, void* const* )
+    {
+#if LIBVLC_VERSION_INT < LIBVLC_VERSION(4, 0, 0, 0)
+        // libvlc 3 decodes directly in our buffers, and unlocks them once
+        // it doesn't need them anymore, which can be after they got displayed
+        detail::VideoFrameStorage::releaseSlot( static_cast<detail::VideoFrameSlot*>( picture ) );
+#else
+        (void)picture;
+#endif
+    }
+
+    /**
+     * Display callback implementation
+     * \return A new handle to the displayed frame
+     */
+    VideoFrame display( void* picture )
+    {
+        auto slot = static_cast<detail::VideoFrameSlot*>( picture );
+        slot->sequence = ++m_sequence;
+        m_nbDisplayed.fetch_add( 1, std::memory_order_relaxed );
+#if LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0)
+        // Transfer libvlc's reference to the frame handle
+        if ( m_pending.exchange( nullptr, std::memory_order_relaxed ) == slot )
+            return VideoFrame( slot );
+#endif
+        slot->refs.fetch_add( 1, std::memory_order_relaxed );
+        return VideoFrame( slot );
+    }
+
+    const Config& config() const
+    {
+        return m_config;
+    }
+
+    /// Number of frames that were displayed since the pool was created
+    uint64_t nbDisplayed() const
+    {
+        return m_nbDisplayed.load( std::memory_order_relaxed );
+    }
+
+    /// Number of frames that libvlc prepared but never displayed
+    uint64_t nbDropped() const
+    {
+        return m_nbDropped.load( std::memory_order_relaxed );
+    }
+
+private:
+    void releasePending()
+    {
+        auto pending = m_pending.exchange( nullptr, std::memory_order_relaxed );
+        if ( pending == nullptr )
+            return;
+        m_nbDropped.fetch_add( 1, std::memory_order_relaxed );
+        detail::VideoFrameStorage::releaseSlot( pending );
+    }
+
+private:
+    Config m_config;
+    detail::VideoFrameStorage* m_storage;
+    std::atomic<detail::VideoFrameSlot*> m_pending;
+    uint64_t m_sequence;
+    std::atomic<uint64_t> m_nbDisplayed;
+    std::atomic<uint64_t> m_nbDropped;
+};
+
+namespace detail
+{
+    // State shared by the callbacks installed by MediaPlayer::setVideoFramePool
+    template <typename Func>
+    struct VideoFramePoolHandler
+    {
+        template <typename FuncFwd>
+        VideoFramePoolHandler( std::shared_ptr<VideoFramePool> p, FuncFwd&& f )
+            : pool( std::move( p ) )
+            , onFrame( std::forward<FuncFwd>( f ) )
+        {
+        }
+
+        std::shared_ptr<VideoFramePool> pool;
+        Func onFrame;
+    };
+}
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_VIDEOFRAMEPOOL_H
@@ -0,0 +1,268 @@
+/*****************************************************************************
+ * VideoFrameQueue.hpp: Bounded lock-free queue of video frames
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_VIDEOFRAMEQUEUE_H
+#define LIBVLC_CXX_VIDEOFRAMEQUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "VideoFramePool.hpp"
+
+namespace VLC
+{
+
+///
+/// \brief The VideoFrameQueue class is a bounded single producer/single
+/// consumer queue, used to hand frames from the video output thread over to
+/// the application.
+///
+/// The producer is the VideoFramePool display callback, the consumer is the
+/// application thread (typically a renderer), which pops frames at its own
+/// cadence. What happens when the consumer lags behind is selected by the
+/// Overflow policy:
+///
+/// - Block: push() waits for the consumer, which backpressures libvlc.
+/// - DropOldest: push() never waits, the oldest pending frame is dropped.
+/// - KeepLatest: only the most recent frame is kept. Both sides are wait-free.
+///
+/// Frames must be pushed in display order, which is what the pool provides:
+///
+///     auto queue = std::make_shared<VLC::VideoFrameQueue>( 1, VLC::VideoFrameQueue::Overflow::KeepLatest );
+///     mp.setVideoFramePool( pool, [queue](VLC::VideoFrame f) { queue->push( std::move( f ) ); } );
+///     // Render thread
+///     VLC::VideoFrame frame;
+///     if ( queue->pop( frame ) )
+///         upload( frame );
+///
+class VideoFrameQueue
+{
+public:
+    enum class Overflow
+    {
+        Block,
+        DropOldest,
+        KeepLatest,
+    };
+
+    /**
+     * \param capacity  The maximum number of pending frames. Forced to 1 when
+     *                  using the KeepLatest policy.
+     * \param policy    The behavior when pushing to a full queue
+     */
+    explicit VideoFrameQueue( size_t capacity, Overflow policy = Overflow::DropOldest )
+        : m_policy( policy )
+        , m_capacity( policy == Overflow::KeepLatest || capacity == 0 ? 1 : capacity )
+        , m_cells( new std::atomic<detail::VideoFrameSlot*>[m_capacity] )
+        , m_tail( 0 )
+        , m_head( 0 )
+        , m_lastSequence( 0 )
+        , m_closed( false )
+        , m_nbDropped( 0 )
+    {
+        for ( size_t i = 0; i < m_capacity; ++i )
+            m_cells[i].store( nullptr, std::memory_order_relaxed );
+    }
+
+    ~VideoFrameQueue()
+    {
+        for ( size_t i = 0; i < m_capacity; ++i )
+        {
+            auto slot = m_cells[i].exchange( nullptr );
+            if ( slot != nullptr )
+                detail::VideoFrameStorage::releaseSlot( slot );
+        }
+    }
+
+    VideoFrameQueue( const VideoFrameQueue& ) = delete;
+    VideoFrameQueue& operator=( const VideoFrameQueue& ) = delete;
+
+    /**
+     * Queue a frame. Must only be called from the producer thread.
+     *
+     * \return false if the frame couldn't be queued, which only happens with
+     *         the Block policy, once the queue was closed.
+     */
+    bool push( VideoFrame frame )
+    {
+        if ( frame.isValid() == false )
+            return true;
+        auto tail = m_tail.load( std::memory_order_relaxed );
+        if ( m_policy == Overflow::Block )
+        {
+            auto hasRoom = [this, tail]() {
+                return tail - m_head.load() < m_capacity ||
+                        m_closed.load( std::memory_order_relaxed );
+            };
+            if ( hasRoom() == false )
+                m_producerParker.waitUntil( hasRoom, std::chrono::steady_clock::time_point::max() );
+            if ( m_closed.load( std::memory_order_relaxed ) == true )
+                return false;
+        }
+        auto prev = m_cells[tail % m_capacity].exchange( frame.detach(), std::memory_order_acq_rel );
+        m_tail.store( tail + 1 );
+        m_consumerParker.notify();
+        if ( prev != nullptr )
+        {
+            m_nbDropped.fetch_add( 1, std::memory_order_relaxed );
+            detail::VideoFrameStorage::releaseSlot( prev );
+        }
+        return true;
+    }
+
+    /**
+     * Pops the oldest pending frame. Must only be called from the consumer thread.
+     *
+     * \return true if a frame was available, false otherwise.
+     */
+    bool pop( VideoFrame& frame )
+    {
+        for ( ;; )
+        {
+            auto head = m_head.load( std::memory_order_relaxed );
+            auto tail = m_tail.load();
+            if ( head == tail )
+                return false;
+            // The producer overwrote the frames we didn't get to in time
+            if ( tail - head > m_capacity )
+                head = tail - m_capacity;
+            auto slot = m_cells[head % m_capacity].exchange( nullptr, std::memory_order_acq_rel );
+            m_head.store( head + 1 );
+            if ( m_policy == Overflow::Block )
+                m_producerParker.notify();
+            if ( slot == nullptr )
+                continue;
+            VideoFrame f{ slot };
+            // When racing with an overwrite, we might have fetched a newer frame
+            // than the ones still pending. Never deliver frames out of order.
+            if ( slot->sequence != 0 && slot->sequence <= m_lastSequence )
+            {
+                m_nbDropped.fetch_add( 1, std::memory_order_relaxed );
+                continue;
+            }
+            m_lastSequence = slot->sequence;
+            frame = std::move( f );
+            return true;
+        }
+    }
+
+    /**
+     * Waits for a frame to be available, up to \p timeout.
+     * Must only be called from the consumer thread.
+     */
+    template <typename Rep, typename Period>
+    bool waitPop( VideoFrame& frame, std::chrono::duration<Rep, Period> timeout )
+    {
+        if ( pop( frame ) == true )
+            return true;
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        m_consumerParker.waitUntil( [this]() {
+            return m_head.load( std::memory_order_relaxed ) != m_tail.load() ||
+                    m_closed.load( std::memory_order_relaxed );
+        }, deadline );
+        return pop( frame );
+    }
+
+    /**
+     * Pops all pending frames, and only keeps the most recent one.
+     * This is the typical renderer usage, when it only cares about the frame
+     * to present next.
+     *
+     * \return true if \p frame was updated
+     */
+    bool popLatest( VideoFrame& frame )
+    {
+        auto res = false;
+        VideoFrame f;
+        while ( pop( f ) == true )
+        {
+            if ( res == true )
+                m_nbDropped.fetch_add( 1, std::memory_order_relaxed );
+            res = true;
+            frame = std::move( f );
+        }
+        return res;
+    }
+
+    /**
+     * Unblocks the producer and consumer, if they are waiting.
+     * Once closed, the Block policy doesn't accept new frames anymore.
+     */
+    void close()
+    {
+        m_closed.store( true );
+        m_producerParker.notify();
+        m_consumerParker.notify();
+    }
+
+    bool isClosed() const
+    {
+        return m_closed.load( std::memory_order_relaxed );
+    }
+
+    /// Approximate number of pending frames
+    size_t size() const
+    {
+        auto tail = m_tail.load();
+        auto head = m_head.load();
+        auto size = tail > head ? static_cast<size_t>( tail - head ) : 0;
+        return size > m_capacity ? m_capacity : size;
+    }
+
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    Overflow policy() const
+    {
+        return m_policy;
+    }
+
+    /// Number of frames that were discarded without being delivered
+    uint64_t nbDropped() const
+    {
+        return m_nbDropped.load( std::memory_order_relaxed );
+    }
+
+private:
+    static const size_t CacheLineSize = 64;
+
+    const Overflow m_policy;
+    const size_t m_capacity;
+    std::unique_ptr<std::atomic<detail::VideoFrameSlot*>[]> m_cells;
+    char m_padding0[CacheLineSize];
+    // Written by the producer only
+    std::atomic<uint64_t> m_tail;
+    char m_padding1[CacheLineSize];
+    // Written by the consumer only
+    std::atomic<uint64_t> m_head;
+    uint64_t m_lastSequence;
+    char m_padding2[CacheLineSize];
+    std::atomic<bool> m_closed;
+    std::atomic<uint64_t> m_nbDropped;
+    detail::ThreadParker m_producerParker;
+    detail::ThreadParker m_consumerParker;
+};
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_VIDEOFRAMEQUEUE_H
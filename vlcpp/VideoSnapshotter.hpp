@@ -0,0 +1,194 @@
+/*****************************************************************************
+ * VideoSnapshotter.hpp: In-memory snapshots of the decoded video
+ *****************************************************************************
+ * Copyright © 2025 libvlcpp authors & VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_CXX_VIDEOSNAPSHOTTER_H
+#define LIBVLC_CXX_VIDEOSNAPSHOTTER_H
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "VideoConverter.hpp"
+#include "VideoFramePool.hpp"
+
+namespace VLC
+{
+
+///
+/// \brief The VideoSnapshotter class captures the next decoded frames into
+/// memory, as an alternative to MediaPlayer::takeSnapshot which writes a
+/// file.
+///
+/// It is fed from the video callbacks, and costs a single atomic load per
+/// frame when no snapshot is requested:
+///
+///     auto snapshotter = std::make_shared<VLC::VideoSnapshotter>();
+///     mp.setVideoFramePool( pool, [snapshotter](VLC::VideoFrame f) {
+///         snapshotter->push( f );
+///         render( std::move( f ) );
+///     });
+///     // Any thread
+///     auto snapshot = snapshotter->request( VLC::VideoConverter::Output( "ARGB", 640 ) );
+///     VLC::VideoFrame f = snapshot.get();
+///     process( f.plane( 0 ), f.pitch( 0 ), f.width(), f.height() );
+///
+/// The snapshot is converted, from the thread calling push(), into a buffer
+/// of its own, so it doesn't hold any decoder buffer. Requesting an empty
+/// chroma returns a reference to the decoded frame itself, without any copy.
+///
+/// To get a JPEG or PNG without decoding the media through a player, see
+/// ThumbnailService::snapshot().
+///
+class VideoSnapshotter
+{
+public:
+    /// Receives the snapshot, or an invalid frame if it couldn't be taken
+    using Callback = std::function<void(VideoFrame)>;
+
+    VideoSnapshotter()
+        : m_nbPending( 0 )
+    {
+    }
+
+    /// Invalidates the pending requests, see cancelPending()
+    ~VideoSnapshotter()
+    {
+        cancelPending();
+    }
+
+    VideoSnapshotter( const VideoSnapshotter& ) = delete;
+    VideoSnapshotter& operator=( const VideoSnapshotter& ) = delete;
+
+    /**
+     * Requests a snapshot of the next pushed frame.
+     *
+     * \param output The snapshot chroma & dimensions. An empty chroma keeps
+     *               the decoded frame as is.
+     * \return A future to the snapshot. It holds a std::runtime_error if the
+     *         frame couldn't be converted, or if the request was cancelled.
+     * \throw std::invalid_argument if the output chroma isn't supported
+     */
+    std::future<VideoFrame> request( VideoConverter::Output output = VideoConverter::Output( "ARGB" ) )
+    {
+        auto promise = std::make_shared<std::promise<VideoFrame>>();
+        auto res = promise->get_future();
+        request( [promise]( VideoFrame f ) {
+            if ( f.isValid() == true )
+                promise->set_value( std::move( f ) );
+            else
+                promise->set_exception( std::make_exception_ptr(
+                                            std::runtime_error( "Snapshot failed" ) ) );
+        }, std::move( output ) );
+        return res;
+    }
+
+    /**
+     * Requests a snapshot of the next pushed frame.
+     *
+     * \param cb     Invoked once, from the thread calling push(), or
+     *               cancelPending().
+     * \param output The snapshot chroma & dimensions. An empty chroma keeps
+     *               the decoded frame as is.
+     * \throw std::invalid_argument if the output chroma isn't supported
+     */
+    void request( Callback cb, VideoConverter::Output output = VideoConverter::Output( "ARGB" ) )
+    {
+        Request r;
+        r.cb = std::move( cb );
+        if ( output.chroma.empty() == false )
+        {
+            // A single buffer, which is handed over to the snapshot
+            output.nbBuffers = 1;
+            r.converter = std::make_shared<VideoConverter>(
+                        std::vector<VideoConverter::Output>{ std::move( output ) } );
+        }
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_requests.push_back( std::move( r ) );
+        m_nbPending.store( m_requests.size(), std::memory_order_release );
+    }
+
+    /**
+     * Fulfills the pending requests with \p frame.
+     * This is meant to be called from the video callbacks, for each frame.
+     */
+    void push( const VideoFrame& frame )
+    {
+        if ( m_nbPending.load( std::memory_order_acquire ) == 0 || frame.isValid() == false )
+            return;
+        std::vector<Request> requests;
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            requests.swap( m_requests );
+            m_nbPending.store( 0, std::memory_order_relaxed );
+        }
+        std::vector<VideoFrame> results;
+        for ( auto& r : requests )
+        {
+            if ( r.converter == nullptr )
+            {
+                r.cb( frame );
+                continue;
+            }
+            if ( r.converter->convert( frame, results ) == true )
+                r.cb( std::move( results[0] ) );
+            else
+                r.cb( VideoFrame() );
+            results.clear();
+        }
+    }
+
+    /// Fails all the pending requests
+    void cancelPending()
+    {
+        std::vector<Request> requests;
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            requests.swap( m_requests );
+            m_nbPending.store( 0, std::memory_order_relaxed );
+        }
+        for ( auto& r : requests )
+            r.cb( VideoFrame() );
+    }
+
+    size_t nbPending() const
+    {
+        return m_nbPending.load( std::memory_order_relaxed );
+    }
+
+private:
+    struct Request
+    {
+        Callback cb;
+        std::shared_ptr<VideoConverter> converter;
+    };
+
+private:
+    std::mutex m_mutex;
+    std::vector<Request> m_requests;
+    std::atomic<size_t> m_nbPending;
+};
+
+} // namespace VLC
+
+#endif // LIBVLC_CXX_VIDEOSNAPSHOTTER_H
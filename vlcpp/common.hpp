@@ -30,9 +30,21 @@ using ssize_t = long int;
 
 #include <vlc/vlc.h>
 #include <vlc/libvlc_version.h>
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef LIBVLCPP_INSTRUMENT_CALLBACKS
+#include "Instrumentation.hpp"
+#endif
 
 namespace VLC
 {
@@ -109,8 +121,122 @@ namespace VLC
         Func func;
     };
 
+    ///
+    /// The kind of libvlc thread invoking a callback, as provided to a
+    /// CallbackThreadHook
+    ///
+    enum class CallbackThread
+    {
+        /// The audio output thread, invoking the audio callbacks
+        Audio,
+        /// The video output thread, invoking the video callbacks
+        Video,
+        /// The input thread, invoking the imem callbacks
+        Input,
+    };
+
+    ///
+    /// Invoked the first time a thread calls one of the callbacks of an
+    /// object, before the callback itself, from that thread. This is where
+    /// the thread can be named, pinned, or given a priority, and where the
+    /// thread local resources can be bound.
+    /// Each thread only remembers the last few objects it ran a hook for: a
+    /// thread calling the callbacks of many objects may run a hook again.
+    ///
+    using CallbackThreadHook = std::function<void(CallbackThread)>;
+
+    namespace detail
+    {
+        struct ThreadHook
+        {
+            ThreadHook( CallbackThreadHook f, CallbackThread (*r)( size_t ) )
+                : id( nextId() )
+                , func( std::move( f ) )
+                , role( r )
+            {
+            }
+
+            static uint64_t nextId()
+            {
+                static std::atomic<uint64_t> id( 0 );
+                return id.fetch_add( 1, std::memory_order_relaxed ) + 1;
+            }
+
+            const uint64_t id;
+            const CallbackThreadHook func;
+            // Tells the kind of thread from the callback index
+            CallbackThread (* const role)( size_t );
+        };
+
+        // Runs the hook if this thread didn't run it for this role lately. The
+        // threads usually keep calling the same object callbacks, so the last
+        // key is checked first, then a small ring of the previous ones, where
+        // the oldest keys are overwritten.
+        inline void enterCallback( const ThreadHook& hook, size_t idx )
+        {
+            static const size_t NbSeen = 16;
+            auto role = hook.role( idx );
+            // The hook ids start at 1, so that no key is 0
+            auto key = ( hook.id << 2 ) | static_cast<uint64_t>( role );
+            static thread_local uint64_t last = 0;
+            if ( key == last )
+                return;
+            last = key;
+            static thread_local uint64_t seen[NbSeen];
+            static thread_local size_t nbSeen = 0;
+            auto end = seen + std::min( nbSeen, NbSeen );
+            if ( std::find( seen, end, key ) != end )
+                return;
+            seen[nbSeen++ % NbSeen] = key;
+            hook.func( role );
+        }
+    }
+
     template <size_t NbEvent>
-    using CallbackArray = std::array<std::unique_ptr<CallbackHandlerBase>, NbEvent>;
+    struct CallbackArray : public std::array<std::unique_ptr<CallbackHandlerBase>, NbEvent>
+    {
+        CallbackArray()
+            : threadHook( nullptr )
+            , nbHookUsers( 0 )
+        {
+        }
+
+        void enterCallback( size_t idx ) const
+        {
+            if ( threadHook.load( std::memory_order_relaxed ) == nullptr )
+                return;
+            // Sequentially consistent, along with the threadHook store in
+            // setThreadHook(): either the hook being replaced sees this
+            // thread as a user, or this thread loads the new hook
+            nbHookUsers.fetch_add( 1 );
+            auto hook = threadHook.load();
+            if ( hook != nullptr )
+                detail::enterCallback( *hook, idx );
+            nbHookUsers.fetch_sub( 1, std::memory_order_release );
+        }
+
+        /// Replaces the hook, nullptr removing it
+        void setThreadHook( std::unique_ptr<detail::ThreadHook> hook )
+        {
+            std::lock_guard<std::mutex> lock( hooksMutex );
+            auto current = hook.get();
+            if ( hook != nullptr )
+                hooks.push_back( std::move( hook ) );
+            threadHook.store( current );
+            // The replaced hooks are kept while a libvlc thread may still be
+            // using them. They can go once no callback is in progress, since
+            // the next ones will load the new hook.
+            if ( nbHookUsers.load() == 0 )
+                hooks.erase( begin( hooks ), current != nullptr ? end( hooks ) - 1 : end( hooks ) );
+        }
+
+        std::atomic<const detail::ThreadHook*> threadHook;
+        // The number of callbacks using threadHook
+        mutable std::atomic<unsigned> nbHookUsers;
+        std::mutex hooksMutex;
+        // The current hook, if any, last, after the replaced ones still kept
+        std::vector<std::unique_ptr<detail::ThreadHook>> hooks;
+    };
 
     ///
     /// Utility class that contains a shared pointer to a callback array.
@@ -122,10 +248,21 @@ namespace VLC
     class CallbackOwner
     {
     protected:
+        static const size_t NbCallbacks = NbEvent;
+
         CallbackOwner()
             : m_callbacks( std::make_shared<CallbackArray<NbEvent>>() )
         {
         }
+
+        void setThreadHook( CallbackThreadHook hook, CallbackThread (*role)( size_t ) )
+        {
+            std::unique_ptr<detail::ThreadHook> h;
+            if ( hook != nullptr )
+                h.reset( new detail::ThreadHook( std::move( hook ), role ) );
+            m_callbacks->setThreadHook( std::move( h ) );
+        }
+
         std::shared_ptr<CallbackArray<NbEvent>> m_callbacks;
     };
 
@@ -185,7 +322,11 @@ namespace VLC
         {
             callbacks[Idx] = std::unique_ptr<CallbackHandler<Func>>( new CallbackHandler<Func>( std::forward<Func>( func ) ) );
             return [](Opaque opaque, Args... args) -> Ret {
+#ifdef LIBVLCPP_INSTRUMENT_CALLBACKS
+                instrumentation::ScopedTimer timer( instrumentation::detail::callbackSite<NbEvents, Idx>() );
+#endif
                 auto& callbacks = FromOpaque<NbEvents, Opaque>::get( opaque );
+                callbacks.enterCallback( Idx );
                 assert(callbacks[Idx] != nullptr);
                 auto cbHandler = static_cast<CallbackHandler<Func>*>( callbacks[Idx].get() );
                 return cbHandler->func( detail::converterForNullToString<Args>(std::forward<Args>(args))... );
@@ -224,6 +365,64 @@ namespace VLC
         va_list va;
     };
 
+    namespace detail
+    {
+        // Parks a thread until another one signals it. The signaling side only
+        // pays for an atomic load when nobody is waiting.
+        // The fences order the waiters count against the state the predicate
+        // reads, whatever the memory order the callers publish it with: either
+        // notify() sees the waiter, or the waiter's predicate sees the state.
+        class ThreadParker
+        {
+        public:
+            ThreadParker() : m_waiters( 0 ) {}
+
+            template <typename Pred>
+            bool waitUntil( Pred&& pred, std::chrono::steady_clock::time_point deadline )
+            {
+                std::unique_lock<std::mutex> lock( m_mutex );
+                m_waiters.fetch_add( 1 );
+                std::atomic_thread_fence( std::memory_order_seq_cst );
+                auto res = true;
+                while ( pred() == false )
+                {
+                    if ( m_cond.wait_until( lock, deadline ) == std::cv_status::timeout )
+                    {
+                        res = pred();
+                        break;
+                    }
+                }
+                m_waiters.fetch_sub( 1 );
+                return res;
+            }
+
+            template <typename Pred>
+            void wait( Pred&& pred )
+            {
+                std::unique_lock<std::mutex> lock( m_mutex );
+                m_waiters.fetch_add( 1 );
+                std::atomic_thread_fence( std::memory_order_seq_cst );
+                while ( pred() == false )
+                    m_cond.wait( lock );
+                m_waiters.fetch_sub( 1 );
+            }
+
+            void notify()
+            {
+                std::atomic_thread_fence( std::memory_order_seq_cst );
+                if ( m_waiters.load() == 0 )
+                    return;
+                std::lock_guard<std::mutex> lock( m_mutex );
+                m_cond.notify_all();
+            }
+
+        private:
+            std::atomic<unsigned> m_waiters;
+            std::mutex m_mutex;
+            std::condition_variable m_cond;
+        };
+    }
+
     namespace imem
     {
         // libvlc_media_new_callbacks is a bit different from other libvlc's callbacks.
@@ -382,7 +581,11 @@ namespace VLC
             {
                 callbacks[Idx] = std::unique_ptr<CallbackHandler<Func>>( new CallbackHandler<Func>( std::forward<Func>( func ) ) );
                 return [](void* opaque, Args... args) -> Ret {
+#ifdef LIBVLCPP_INSTRUMENT_CALLBACKS
+                    instrumentation::ScopedTimer timer( instrumentation::detail::callbackSite<NbEvents, Idx>() );
+#endif
                     auto boxed = BoxOpaque<NbEvents, Strategy>( opaque, std::forward<Args>( args )... );
+                    boxed.callbacks().enterCallback( Idx );
                     assert(boxed.callbacks()[Idx] != nullptr );
                     auto cbHandler = static_cast<CallbackHandler<Func>*>( boxed.callbacks()[Idx].get() );
                     return cbHandler->func( boxed, std::forward<Args>(args)... );
@@ -24,6 +24,9 @@
 #ifndef LIBVLC_CXX_STRUCTURES_H
 #define LIBVLC_CXX_STRUCTURES_H
 
+#include <cstddef>
+#include <iterator>
+#include <memory>
 #include <string>
 
 #include "common.hpp"
@@ -73,7 +76,7 @@ public:
         return m_help;
     }
 
-    explicit ModuleDescription( libvlc_module_description_t* c )
+    explicit ModuleDescription( const libvlc_module_description_t* c )
     {
         if ( c->psz_name != nullptr )
             m_name = c->psz_name;
@@ -755,7 +758,7 @@ public:
         return m_description;
     }
 
-    explicit AudioOutputDescription( libvlc_audio_output_t* c )
+    explicit AudioOutputDescription( const libvlc_audio_output_t* c )
     {
         if ( c->psz_name != nullptr )
             m_name = c->psz_name;
@@ -787,7 +790,7 @@ class AudioOutputDeviceDescription
             return m_description;
         }
 
-        explicit AudioOutputDeviceDescription( libvlc_audio_output_device_t* d )
+        explicit AudioOutputDeviceDescription( const libvlc_audio_output_device_t* d )
         {
             if ( d->psz_device != nullptr )
                 m_device = d->psz_device;
@@ -800,6 +803,234 @@ class AudioOutputDeviceDescription
         std::string m_description;
 };
 
+namespace detail
+{
+    inline const char* borrowedString( const char* str )
+    {
+        return str != nullptr ? str : "";
+    }
+}
+
+///
+/// \brief The DescriptionList class holds a description list returned by
+/// libvlc, and exposes it as a range of views borrowing the libvlc strings.
+///
+/// No string is copied: the views, and the strings they return, are valid as
+/// long as the list is alive. The list can be moved, not copied. The accessors return NUL terminated
+/// strings, which convert to a std::string_view without copying either:
+///
+///     for ( const auto& f : instance.audioFilterListView() )
+///     {
+///         if ( strcmp( f.name(), "equalizer" ) == 0 )
+///             return true;
+///     }
+///
+template <typename T, typename View>
+class DescriptionList
+{
+public:
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = View;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const View*;
+        using reference = const View&;
+
+        explicit const_iterator( const T* item = nullptr )
+            : m_view( item )
+        {
+        }
+
+        reference operator*() const
+        {
+            return m_view;
+        }
+
+        pointer operator->() const
+        {
+            return &m_view;
+        }
+
+        const_iterator& operator++()
+        {
+            m_view = View( m_view.get()->p_next );
+            return *this;
+        }
+
+        const_iterator operator++( int )
+        {
+            auto res = *this;
+            ++*this;
+            return res;
+        }
+
+        bool operator==( const const_iterator& rhs ) const
+        {
+            return m_view.get() == rhs.m_view.get();
+        }
+
+        bool operator!=( const const_iterator& rhs ) const
+        {
+            return m_view.get() != rhs.m_view.get();
+        }
+
+    private:
+        View m_view;
+    };
+    using iterator = const_iterator;
+
+    DescriptionList()
+        : m_list( nullptr, nullptr )
+    {
+    }
+
+    /**
+     * Takes ownership of \p list, which will be released with \p release
+     * when the list is destroyed.
+     */
+    DescriptionList( T* list, void (*release)( T* ) )
+        : m_list( list, release )
+    {
+    }
+
+    DescriptionList( DescriptionList&& ) = default;
+    DescriptionList& operator=( DescriptionList&& ) = default;
+    DescriptionList( const DescriptionList& ) = delete;
+    DescriptionList& operator=( const DescriptionList& ) = delete;
+
+    const_iterator begin() const
+    {
+        return const_iterator( m_list.get() );
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator();
+    }
+
+    bool empty() const
+    {
+        return m_list == nullptr;
+    }
+
+    /// Walks the list, which is a linked list
+    size_t size() const
+    {
+        return static_cast<size_t>( std::distance( begin(), end() ) );
+    }
+
+private:
+    std::unique_ptr<T, void (*)( T* )> m_list;
+};
+
+///
+/// \brief The ModuleDescriptionView class is a non owning ModuleDescription
+///
+class ModuleDescriptionView
+{
+public:
+    explicit ModuleDescriptionView( const libvlc_module_description_t* c = nullptr )
+        : m_c( c )
+    {
+    }
+
+    const char* name() const
+    {
+        return detail::borrowedString( m_c->psz_name );
+    }
+
+    const char* shortname() const
+    {
+        return detail::borrowedString( m_c->psz_shortname );
+    }
+
+    const char* longname() const
+    {
+        return detail::borrowedString( m_c->psz_longname );
+    }
+
+    const char* help() const
+    {
+        return detail::borrowedString( m_c->psz_help );
+    }
+
+    const libvlc_module_description_t* get() const
+    {
+        return m_c;
+    }
+
+private:
+    const libvlc_module_description_t* m_c;
+};
+
+///
+/// \brief The AudioOutputDescriptionView class is a non owning
+/// AudioOutputDescription
+///
+class AudioOutputDescriptionView
+{
+public:
+    explicit AudioOutputDescriptionView( const libvlc_audio_output_t* c = nullptr )
+        : m_c( c )
+    {
+    }
+
+    const char* name() const
+    {
+        return detail::borrowedString( m_c->psz_name );
+    }
+
+    const char* description() const
+    {
+        return detail::borrowedString( m_c->psz_description );
+    }
+
+    const libvlc_audio_output_t* get() const
+    {
+        return m_c;
+    }
+
+private:
+    const libvlc_audio_output_t* m_c;
+};
+
+///
+/// \brief The AudioOutputDeviceDescriptionView class is a non owning
+/// AudioOutputDeviceDescription
+///
+class AudioOutputDeviceDescriptionView
+{
+public:
+    explicit AudioOutputDeviceDescriptionView( const libvlc_audio_output_device_t* d = nullptr )
+        : m_d( d )
+    {
+    }
+
+    const char* device() const
+    {
+        return detail::borrowedString( m_d->psz_device );
+    }
+
+    const char* description() const
+    {
+        return detail::borrowedString( m_d->psz_description );
+    }
+
+    const libvlc_audio_output_device_t* get() const
+    {
+        return m_d;
+    }
+
+private:
+    const libvlc_audio_output_device_t* m_d;
+};
+
+using ModuleDescriptionList = DescriptionList<libvlc_module_description_t, ModuleDescriptionView>;
+using AudioOutputDescriptionList = DescriptionList<libvlc_audio_output_t, AudioOutputDescriptionView>;
+using AudioOutputDeviceDescriptionList = DescriptionList<libvlc_audio_output_device_t, AudioOutputDeviceDescriptionView>;
+
 #if LIBVLC_VERSION_INT < LIBVLC_VERSION(4, 0, 0, 0)
 ///
 /// \brief The TrackDescription class describes a track
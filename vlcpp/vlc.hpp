@@ -33,8 +33,32 @@
 #include "MediaList.hpp"
 #include "RendererDiscoverer.hpp"
 #include "MediaPlayer.hpp"
+#include "AudioSink.hpp"
+#include "VideoFramePool.hpp"
+#include "VideoFrameQueue.hpp"
 #include "MediaLibrary.hpp"
 #include "EventManager.hpp"
+#include "EventQueue.hpp"
+#include "MediaParserPool.hpp"
+#include "ThumbnailService.hpp"
+#include "MemoryInput.hpp"
+#include "ReadAheadInput.hpp"
+#include "VideoConverter.hpp"
+#include "VideoFrameFanout.hpp"
+#include "VideoSnapshotter.hpp"
+#include "MediaPlayerPool.hpp"
+#include "GaplessListPlayer.hpp"
+#include "TrackCache.hpp"
+#include "PlayerStateMonitor.hpp"
+#include "LogSink.hpp"
+#include "StatsCollector.hpp"
+#include "Instrumentation.hpp"
+#include "Ref.hpp"
+#include "Awaitable.hpp"
+#include "InstancePool.hpp"
+#include "MediaListIndex.hpp"
+#include "DiscoveryFeed.hpp"
+#include "EqualizerSmoother.hpp"
 #include "structures.hpp"
 
 #endif